@@ -0,0 +1,370 @@
+#include <iostream>
+#include "bstree.h"
+#include "test_types.h"
+#include <set> // std::set
+#include <vector> // std::vector
+#include <string> // std::string
+#include <algorithm> // std::sort, std::unique, std::lower_bound, std::shuffle
+#include <random> // std::mt19937_64
+#include <chrono> // std::chrono::steady_clock
+#include <cstdio> // std::snprintf
+#include <cstdlib> // std::strtoul
+#include <cstring> // std::strcmp
+
+/**
+ * Benchmark dell'albero binario di ricerca contro std::set e un vettore
+ * ordinato. Per ogni contenitore, tipo di dato e distribuzione delle chiavi
+ * misura add, find (chiavi presenti e assenti), la visita completa,
+ * subtree, la copia e clear. Il tempo di ogni operazione è misurato a
+ * blocchi di batch operazioni consecutive: i percentili sono quelli del
+ * tempo medio per operazione nei blocchi, il throughput è calcolato sul
+ * tempo totale. Con lo stesso seme le chiavi sono le stesse a ogni
+ * esecuzione.
+ *
+ * Uso: bench.exe [--json] [--size n] [--seed s]
+ *
+ * Il vettore ordinato viene riempito in blocco (push_back, poi sort e
+ * unique alla fine, inclusi nell'ultimo blocco); l'albero senza
+ * bilanciamento non viene misurato sulle chiavi ordinate e inverse, dove
+ * degenera in una lista.
+*/
+
+/**
+ * Tipo di dato misurato: nome, funtori e costruzione dalla chiave k.
+ * Le chiavi presenti sono pari, quelle assenti dispari.
+ *
+ * @brief Tipo di dato misurato
+*/
+template <typename T>
+struct bench_type;
+
+template <>
+struct bench_type<int> {
+	typedef compare_int compare;
+	typedef equal_int equal;
+
+	static const char *name() { return "int"; }
+	static int make(unsigned int k) { return (int)k; }
+};
+
+template <>
+struct bench_type<std::string> {
+	typedef compare_string_key compare;
+	typedef equal_string_key equal;
+
+	static const char *name() { return "string"; }
+	static std::string make(unsigned int k) {
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "chiave-%010u", k);
+		return buffer;
+	}
+};
+
+template <>
+struct bench_type<point> {
+	typedef compare_point compare;
+	typedef equal_point equal;
+
+	static const char *name() { return "point"; }
+	static point make(unsigned int k) { return point((int)k, (int)(k % 1000)); }
+};
+
+/**
+ * Adattatori dei contenitori alla stessa interfaccia: add, find, visita,
+ * subtree (solo per l'albero), copia e clear.
+*/
+template <typename T, typename B>
+struct bst_adapter {
+	typedef binary_search_tree<T, typename bench_type<T>::compare, typename bench_type<T>::equal, B> container;
+	static const bool has_subtree = true;
+
+	static void add(container &c, const T &v) { c.add(v); }
+	static bool find(const container &c, const T &v) { return c.find(v) != c.end(); }
+	static void finish(container &) {}
+	static std::size_t subtree(const container &c, const T &v) { return c.subtree(v).size(); }
+};
+
+template <typename T>
+struct set_adapter {
+	typedef std::set<T, typename bench_type<T>::compare> container;
+	static const bool has_subtree = false;
+
+	static void add(container &c, const T &v) { c.insert(v); }
+	static bool find(const container &c, const T &v) { return c.find(v) != c.end(); }
+	static void finish(container &) {}
+	static std::size_t subtree(const container &, const T &) { return 0; }
+};
+
+template <typename T>
+struct vector_adapter {
+	typedef std::vector<T> container;
+	static const bool has_subtree = false;
+
+	static void add(container &c, const T &v) { c.push_back(v); }
+	static bool find(const container &c, const T &v) {
+		typename bench_type<T>::compare less;
+		typename container::const_iterator i = std::lower_bound(c.begin(), c.end(), v, less);
+		return i != c.end() && !less(v, *i);
+	}
+	static void finish(container &c) {
+		typename bench_type<T>::compare less;
+		std::sort(c.begin(), c.end(), less);
+		c.erase(std::unique(c.begin(), c.end(), [&less](const T &a, const T &b){ return !less(a, b) && !less(b, a); }), c.end());
+	}
+	static std::size_t subtree(const container &, const T &) { return 0; }
+};
+
+/**
+ * Impostazioni del benchmark
+*/
+struct bench_options {
+	std::size_t size; ///< numero di chiavi
+	unsigned long seed; ///< seme delle sequenze casuali
+	std::size_t batch; ///< operazioni per blocco misurato
+	bool json; ///< uscita JSON invece di CSV
+
+	bench_options(): size(100000), seed(42), batch(64), json(false) {}
+};
+
+/**
+ * Genera la sequenza di chiavi (di rango) di una distribuzione: ordinata,
+ * inversa, permutazione casuale o Zipf con esponente 1 sui ranghi, dove
+ * il rango r corrisponde a una chiave scelta a caso
+*/
+std::vector<unsigned int> make_ranks(const std::string &distribution, std::size_t n, std::mt19937_64 &rng) {
+	std::vector<unsigned int> ranks(n);
+	for(std::size_t i = 0; i < n; ++i)
+		ranks[i] = (unsigned int)i;
+
+	if(distribution == "reverse"){
+		std::reverse(ranks.begin(), ranks.end());
+	}
+	else if(distribution == "random"){
+		std::shuffle(ranks.begin(), ranks.end(), rng);
+	}
+	else if(distribution == "zipf"){
+		std::vector<unsigned int> key_of(ranks);
+		std::shuffle(key_of.begin(), key_of.end(), rng);
+
+		std::vector<double> cdf(n);
+		double total = 0;
+		for(std::size_t i = 0; i < n; ++i){
+			total += 1.0 / (double)(i + 1);
+			cdf[i] = total;
+		}
+		std::uniform_real_distribution<double> uniform(0, total);
+		for(std::size_t i = 0; i < n; ++i){
+			std::size_t r = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+			ranks[i] = key_of[r < n ? r : n - 1];
+		}
+	}
+	return ranks;
+}
+
+/**
+ * Tempi per operazione di una misura
+*/
+struct bench_sample {
+	std::vector<double> batch_ns; ///< tempo medio per operazione in ogni blocco
+	double total_ns; ///< tempo totale
+	std::size_t ops; ///< operazioni eseguite
+
+	bench_sample(): total_ns(0), ops(0) {}
+
+	void add(double ns, std::size_t count) {
+		batch_ns.push_back(ns / (double)count);
+		total_ns += ns;
+		ops += count;
+	}
+
+	double percentile(double p) {
+		if(batch_ns.empty())
+			return 0;
+		std::sort(batch_ns.begin(), batch_ns.end());
+		std::size_t i = (std::size_t)(p * (double)(batch_ns.size() - 1) + 0.5);
+		return batch_ns[i];
+	}
+};
+
+typedef std::chrono::steady_clock bench_clock;
+
+double elapsed_ns(bench_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+}
+
+/**
+ * Scrive una riga di risultati
+*/
+void report(const bench_options &opt, const char *container, const char *type, const std::string &distribution,
+            const char *operation, bench_sample &s, bool &first) {
+	double ms = s.total_ns / 1e6;
+	double throughput = s.total_ns > 0 ? (double)s.ops * 1e9 / s.total_ns : 0;
+	double p50 = s.percentile(0.50), p90 = s.percentile(0.90), p99 = s.percentile(0.99);
+
+	if(opt.json){
+		std::cout << (first ? "\n" : ",\n") << "    {\"container\": \"" << container << "\", \"type\": \"" << type
+		          << "\", \"distribution\": \"" << distribution << "\", \"operation\": \"" << operation
+		          << "\", \"ops\": " << s.ops << ", \"total_ms\": " << ms << ", \"ops_per_sec\": " << throughput
+		          << ", \"p50_ns\": " << p50 << ", \"p90_ns\": " << p90 << ", \"p99_ns\": " << p99 << "}";
+	}
+	else{
+		std::cout << container << "," << type << "," << distribution << "," << operation << "," << s.ops << ","
+		          << ms << "," << throughput << "," << p50 << "," << p90 << "," << p99 << "\n";
+	}
+	first = false;
+}
+
+/**
+ * Misura tutte le operazioni di un contenitore su una distribuzione
+*/
+template <typename T, typename Adapter>
+void run_container(const bench_options &opt, const char *name, const std::string &distribution,
+                   const std::vector<unsigned int> &ranks, const std::vector<unsigned int> &lookups, bool &first) {
+	typedef typename Adapter::container container;
+	const char *type = bench_type<T>::name();
+	const std::size_t n = ranks.size();
+	const std::size_t batch = opt.batch;
+
+	std::vector<T> present, absent;
+	present.reserve(n);
+	absent.reserve(n);
+	for(std::size_t i = 0; i < n; ++i){
+		present.push_back(bench_type<T>::make(2 * ranks[i]));
+		absent.push_back(bench_type<T>::make(2 * lookups[i] + 1));
+	}
+	std::vector<T> hits;
+	hits.reserve(n);
+	for(std::size_t i = 0; i < n; ++i)
+		hits.push_back(bench_type<T>::make(2 * ranks[lookups[i] % n]));
+
+	// add
+	container c;
+	bench_sample s;
+	for(std::size_t i = 0; i < n; i += batch){
+		std::size_t end = i + batch < n ? i + batch : n;
+		bench_clock::time_point start = bench_clock::now();
+		for(std::size_t j = i; j < end; ++j)
+			Adapter::add(c, present[j]);
+		if(end == n)
+			Adapter::finish(c);
+		s.add(elapsed_ns(start), end - i);
+	}
+	report(opt, name, type, distribution, "add", s, first);
+
+	// find con chiavi presenti e assenti
+	const std::vector<T> *queries[2] = { &hits, &absent };
+	const char *operations[2] = { "find_hit", "find_miss" };
+	std::size_t found = 0;
+	for(int q = 0; q < 2; ++q){
+		bench_sample f;
+		const std::vector<T> &keys = *queries[q];
+		for(std::size_t i = 0; i < n; i += batch){
+			std::size_t end = i + batch < n ? i + batch : n;
+			bench_clock::time_point start = bench_clock::now();
+			for(std::size_t j = i; j < end; ++j)
+				found += Adapter::find(c, keys[j]);
+			f.add(elapsed_ns(start), end - i);
+		}
+		report(opt, name, type, distribution, operations[q], f, first);
+	}
+	if(found != n)
+		std::cerr << "risultati inattesi per " << name << " " << type << " " << distribution << std::endl;
+
+	// visita completa, un blocco ogni batch elementi
+	bench_sample it;
+	std::size_t visited = 0;
+	typename container::const_iterator i = c.begin(), ie = c.end();
+	while(i != ie){
+		std::size_t count = 0;
+		bench_clock::time_point start = bench_clock::now();
+		for(; i != ie && count < batch; ++i, ++count)
+			visited += (&*i != nullptr);
+		it.add(elapsed_ns(start), count);
+	}
+	report(opt, name, type, distribution, "iterate", it, first);
+
+	// subtree, sui primi elementi inseriti (vicini alla radice per
+	// l'albero senza bilanciamento)
+	if(Adapter::has_subtree){
+		bench_sample st;
+		std::size_t copied = 0;
+		for(std::size_t k = 0; k < std::min<std::size_t>(64, n); ++k){
+			bench_clock::time_point start = bench_clock::now();
+			copied += Adapter::subtree(c, hits[k]);
+			st.add(elapsed_ns(start), 1);
+		}
+		report(opt, name, type, distribution, "subtree", st, first);
+	}
+
+	// copia e clear dell'intero contenitore, ripetute
+	bench_sample cp, cl;
+	for(int r = 0; r < 5; ++r){
+		bench_clock::time_point start = bench_clock::now();
+		container copy(c);
+		cp.add(elapsed_ns(start), 1);
+
+		start = bench_clock::now();
+		copy.clear();
+		cl.add(elapsed_ns(start), 1);
+	}
+	report(opt, name, type, distribution, "copy", cp, first);
+	report(opt, name, type, distribution, "clear", cl, first);
+
+	if(visited != it.ops)
+		std::cerr << "visita incompleta per " << name << std::endl;
+}
+
+/**
+ * Misura tutti i contenitori per un tipo di dato
+*/
+template <typename T>
+void run_type(const bench_options &opt, bool &first) {
+	const char *distributions[] = { "sorted", "reverse", "random", "zipf" };
+
+	for(std::size_t d = 0; d < 4; ++d){
+		std::mt19937_64 rng(opt.seed + d);
+		std::vector<unsigned int> ranks = make_ranks(distributions[d], opt.size, rng);
+		std::vector<unsigned int> lookups = make_ranks(d == 3 ? "zipf" : "random", opt.size, rng);
+		bool degenerate = d < 2;
+
+		if(!degenerate)
+			run_container<T, bst_adapter<T, unbalanced> >(opt, "bst", distributions[d], ranks, lookups, first);
+		run_container<T, bst_adapter<T, avl_balance> >(opt, "bst_avl", distributions[d], ranks, lookups, first);
+		run_container<T, bst_adapter<T, red_black_balance> >(opt, "bst_red_black", distributions[d], ranks, lookups, first);
+		run_container<T, set_adapter<T> >(opt, "std_set", distributions[d], ranks, lookups, first);
+		run_container<T, vector_adapter<T> >(opt, "sorted_vector", distributions[d], ranks, lookups, first);
+	}
+}
+
+int main(int argc, char const *argv[]) {
+
+	bench_options opt;
+	for(int i = 1; i < argc; ++i){
+		if(std::strcmp(argv[i], "--json") == 0)
+			opt.json = true;
+		else if(std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+			opt.size = std::strtoul(argv[++i], nullptr, 10);
+		else if(std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			opt.seed = std::strtoul(argv[++i], nullptr, 10);
+		else{
+			std::cerr << "uso: " << argv[0] << " [--json] [--size n] [--seed s]" << std::endl;
+			return 1;
+		}
+	}
+
+	bool first = true;
+	if(opt.json)
+		std::cout << "{\n  \"size\": " << opt.size << ",\n  \"seed\": " << opt.seed << ",\n  \"batch\": " << opt.batch
+		          << ",\n  \"results\": [";
+	else
+		std::cout << "container,type,distribution,operation,ops,total_ms,ops_per_sec,p50_ns,p90_ns,p99_ns\n";
+
+	run_type<int>(opt, first);
+	run_type<std::string>(opt, first);
+	run_type<point>(opt, first);
+
+	if(opt.json)
+		std::cout << "\n  ]\n}" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,1058 @@
+#ifndef BPLUS_TREE_H
+#define BPLUS_TREE_H
+
+#include <ostream>
+#include <iostream>
+#include <iterator> // std::bidirectional_iterator_tag, std::reverse_iterator
+#include <cstddef>  // std::ptrdiff_t, std::size_t
+#include <memory>   // std::allocator, std::allocator_traits
+#include <new>      // placement new
+#include <type_traits> // std::aligned_storage, std::conditional
+#include <utility>  // std::move, std::forward, std::pair
+#include "bstree.h" // eccezioni comuni
+
+/**
+ * Classe generica che implementa un insieme ordinato con la stessa
+ * interfaccia di binary_search_tree (add, find, contains, subtree,
+ * const_iterator, size) ma con nodi B+-tree: ogni nodo occupa alcune linee
+ * di cache consecutive e allineate e contiene molti valori, quindi una
+ * ricerca visita pochi nodi invece di un nodo per livello binario.
+ *
+ * Il numero di valori per nodo è scelto a tempo di compilazione da
+ * sizeof(T) in modo che un nodo occupi node_bytes byte. I valori sono
+ * memorizzati solo nelle foglie; i nodi interni contengono copie dei valori
+ * come separatori. Le foglie sono collegate tra loro, quindi la visita in
+ * ordine scorre memoria contigua.
+ *
+ * Come per binary_search_tree l'ordinamento è definito dal funtore C e
+ * l'uguaglianza dal funtore E; valori equivalenti per C ma diversi per E
+ * sono inseriti dopo quelli già presenti.
+ *
+ * @brief Albero B+ con nodi allineati alle linee di cache
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ * @param A allocatore compatibile con std::allocator; con std::allocator i
+ *          nodi sono allocati da aligned_allocator, gli altri allocatori
+ *          devono rispettare alignof(T) come pool_allocator
+*/
+template <typename T, typename C, typename E, typename A = std::allocator<T> >
+class bplus_tree {
+
+public:
+
+    /**
+     * Dimensione di una linea di cache
+    */
+    static const std::size_t line_size = 64;
+
+    /**
+     * Dimensione di riferimento di un nodo: quattro linee di cache
+    */
+    static const std::size_t node_bytes = 4 * line_size;
+
+private:
+
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot;
+
+    struct leaf_node;
+
+    /**
+     * Intestazione comune ai nodi
+    */
+    struct node_base {
+        unsigned short count; // numero di valori nel nodo
+        bool leaf; // true se il nodo è una foglia
+
+        node_base(bool l): count(0), leaf(l) {}
+    };
+
+    /**
+     * Intestazione di una foglia
+    */
+    struct leaf_header : public node_base {
+        leaf_node *prev; // foglia precedente in ordine
+        leaf_node *next; // foglia successiva in ordine
+
+        leaf_header(): node_base(true), prev(nullptr), next(nullptr) {}
+    };
+
+    /**
+     * Intestazione di un nodo interno
+    */
+    struct inner_header : public node_base {
+        inner_header(): node_base(false) {}
+    };
+
+public:
+
+    /**
+     * Numero massimo di valori in una foglia (almeno 4)
+    */
+    static const std::size_t leaf_fanout =
+        (node_bytes - sizeof(leaf_header)) / sizeof(T) > 4 ?
+        (node_bytes - sizeof(leaf_header)) / sizeof(T) : 4;
+
+    /**
+     * Numero massimo di separatori in un nodo interno (almeno 4),
+     * che ha quindi fino a inner_fanout + 1 figli
+    */
+    static const std::size_t inner_fanout =
+        (node_bytes - sizeof(inner_header) - sizeof(void *)) / (sizeof(T) + sizeof(void *)) > 4 ?
+        (node_bytes - sizeof(inner_header) - sizeof(void *)) / (sizeof(T) + sizeof(void *)) : 4;
+
+private:
+
+    /**
+     * Foglia: valori ordinati e collegamenti alle foglie vicine
+     *
+     * @brief Foglia dell'albero
+    */
+    struct alignas(line_size) leaf_node : public leaf_header {
+        slot keys[leaf_fanout]; // valori, costruiti solo i primi count
+    };
+
+    /**
+     * Nodo interno: il figlio i contiene i valori compresi tra i
+     * separatori i-1 (incluso) e i (escluso)
+     *
+     * @brief Nodo interno dell'albero
+    */
+    struct alignas(line_size) inner_node : public inner_header {
+        node_base *children[inner_fanout + 1]; // figli, validi i primi count + 1
+        slot keys[inner_fanout]; // separatori, costruiti solo i primi count
+    };
+
+    /**
+     * Unità di allocazione: una linea di cache
+    */
+    struct alignas(line_size) cache_line {
+        char bytes[line_size];
+    };
+
+    static_assert(sizeof(leaf_node) % line_size == 0 && sizeof(inner_node) % line_size == 0,
+                  "i nodi devono occupare linee di cache intere");
+
+    /**
+     * In C++11 std::allocator non garantisce allineamenti oltre
+     * std::max_align_t: al suo posto si usa aligned_allocator
+    */
+    typedef typename std::conditional<std::is_same<A, std::allocator<T> >::value,
+        aligned_allocator<cache_line>,
+        typename std::allocator_traits<A>::template rebind_alloc<cache_line> >::type line_allocator;
+    typedef std::allocator_traits<line_allocator> line_traits;
+
+    /**
+     * Selettore del costruttore che riceve direttamente l'allocatore delle linee
+    */
+    struct line_alloc_tag {};
+
+    /**
+     * Altezza massima dell'albero: i nodi interni fuori dal bordo destro
+     * hanno almeno due figli
+    */
+    enum { max_height = 64 };
+
+    node_base *_root; // radice dell'albero
+    leaf_node *_first; // foglia con il valore minimo
+    leaf_node *_last; // foglia con il valore massimo
+    std::size_t _size; // numero di valori nell'albero
+
+    C _conf; // oggetto funtore per il confronto
+    E _eql; // oggetto funtore per l'uguaglianza
+
+    line_allocator _alloc; // allocatore delle linee di cache
+
+    static T &key(slot &s){
+        return *reinterpret_cast<T *>(&s);
+    }
+
+    static const T &key(const slot &s){
+        return *reinterpret_cast<const T *>(&s);
+    }
+
+    /**
+     * Numero di linee occupate da un nodo di tipo N
+    */
+    template <typename N>
+    static std::size_t lines_of(){
+        return sizeof(N) / line_size;
+    }
+
+    /**
+     * Alloca un nodo vuoto allineato all'inizio di una linea di cache
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename N>
+    N *create_node(){
+        cache_line *raw;
+        try{
+            raw = line_traits::allocate(_alloc, lines_of<N>());
+        }
+        catch(...){
+            throw NoNodeCreatedException();
+        }
+
+        return ::new (static_cast<void *>(raw)) N();
+    }
+
+    /**
+     * Distrugge i valori di un nodo e ne libera la memoria
+    */
+    template <typename N>
+    void free_node(N *n){
+        for(std::size_t i = 0; i < n->count; ++i)
+            key(n->keys[i]).~T();
+
+        cache_line *raw = reinterpret_cast<cache_line *>(n);
+        n->~N();
+        line_traits::deallocate(_alloc, raw, lines_of<N>());
+    }
+
+    /**
+     * Distrugge il sottoalbero radicato in n.
+     * La ricorsione è limitata dall'altezza, che è logaritmica.
+    */
+    void clear_helper(node_base *n){
+        if(n == nullptr)
+            return;
+
+        if(n->leaf){
+            free_node(static_cast<leaf_node *>(n));
+            return;
+        }
+
+        inner_node *in = static_cast<inner_node *>(n);
+        for(std::size_t i = 0; i <= in->count; ++i)
+            clear_helper(in->children[i]);
+        free_node(in);
+    }
+
+    /**
+     * Posizione del primo valore non minore di value in un array ordinato
+    */
+    std::size_t lower_index(const slot *keys, std::size_t count, const T &value) const {
+        std::size_t lo = 0, hi = count;
+        while(lo < hi){
+            std::size_t mid = (lo + hi) / 2;
+            if(_conf(key(keys[mid]), value))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    /**
+     * Posizione del primo valore maggiore di value in un array ordinato
+    */
+    std::size_t upper_index(const slot *keys, std::size_t count, const T &value) const {
+        std::size_t lo = 0, hi = count;
+        while(lo < hi){
+            std::size_t mid = (lo + hi) / 2;
+            if(_conf(value, key(keys[mid])))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+
+    /**
+     * Scende fino alla foglia che contiene il primo valore non minore di value
+    */
+    const leaf_node *find_leaf_lower(const T &value) const {
+        const node_base *n = _root;
+        while(!n->leaf){
+            const inner_node *in = static_cast<const inner_node *>(n);
+            n = in->children[lower_index(in->keys, in->count, value)];
+        }
+        return static_cast<const leaf_node *>(n);
+    }
+
+    /**
+     * Scende fino alla foglia in cui andrebbe inserito value
+    */
+    const leaf_node *find_leaf_upper(const T &value) const {
+        const node_base *n = _root;
+        while(!n->leaf){
+            const inner_node *in = static_cast<const inner_node *>(n);
+            n = in->children[upper_index(in->keys, in->count, value)];
+        }
+        return static_cast<const leaf_node *>(n);
+    }
+
+    /**
+     * Inserisce un valore nella posizione pos di un array di count valori
+    */
+    template <typename V>
+    static void insert_key(slot *keys, std::size_t count, std::size_t pos, V &&value){
+        if(pos == count){
+            ::new (&keys[count]) T(std::forward<V>(value));
+            return;
+        }
+
+        ::new (&keys[count]) T(std::move(key(keys[count - 1])));
+        for(std::size_t j = count - 1; j > pos; --j)
+            key(keys[j]) = std::move(key(keys[j - 1]));
+        key(keys[pos]) = std::forward<V>(value);
+    }
+
+    /**
+     * Sposta i valori [from, count) di src all'inizio di dst
+    */
+    static void move_keys(slot *src, std::size_t from, std::size_t count, slot *dst){
+        for(std::size_t j = from; j < count; ++j){
+            ::new (&dst[j - from]) T(std::move(key(src[j])));
+            key(src[j]).~T();
+        }
+    }
+
+    /**
+     * Inserisce nel nodo interno il separatore in posizione i e
+     * il figlio destro in posizione i + 1
+    */
+    template <typename V>
+    static void insert_child(inner_node *in, std::size_t i, V &&sep, node_base *right){
+        insert_key(in->keys, in->count, i, std::forward<V>(sep));
+        for(std::size_t j = in->count + 1; j > i + 1; --j)
+            in->children[j] = in->children[j - 1];
+        in->children[i + 1] = right;
+        in->count++;
+    }
+
+    /**
+     * Inserisce un valore se non è già presente.
+     * I nodi necessari alle divisioni sono allocati prima di modificare
+     * l'albero, così un errore di allocazione lo lascia intatto.
+     *
+     * @param value valore da inserire (copiato o spostato)
+     *
+     * @return true se il valore è stato inserito
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename V>
+    bool insert_value(V &&value){
+        if(_root == nullptr){
+            leaf_node *l = create_node<leaf_node>();
+            ::new (&l->keys[0]) T(std::forward<V>(value));
+            l->count = 1;
+            _root = _first = _last = l;
+            _size = 1;
+            return true;
+        }
+
+        inner_node *path[max_height];
+        std::size_t index[max_height];
+        std::size_t depth = 0;
+        bool rightmost = true; // il percorso segue sempre l'ultimo figlio
+
+        node_base *n = _root;
+        while(!n->leaf){
+            inner_node *in = static_cast<inner_node *>(n);
+            std::size_t i = upper_index(in->keys, in->count, value);
+            rightmost = rightmost && (i == in->count);
+            path[depth] = in;
+            index[depth] = i;
+            depth++;
+            n = in->children[i];
+        }
+
+        leaf_node *l = static_cast<leaf_node *>(n);
+        std::size_t pos = upper_index(l->keys, l->count, value);
+
+        // i valori equivalenti precedono pos, anche in foglie precedenti
+        const leaf_node *el = l;
+        std::size_t ei = pos;
+        while(el != nullptr){
+            if(ei == 0){
+                el = el->prev;
+                if(el != nullptr)
+                    ei = el->count;
+                continue;
+            }
+            const T &k = key(el->keys[ei - 1]);
+            if(_conf(k, value))
+                break;
+            if(_eql(k, value))
+                return false;
+            ei--;
+        }
+
+        if(l->count < leaf_fanout){
+            insert_key(l->keys, l->count, pos, std::forward<V>(value));
+            l->count++;
+            _size++;
+            return true;
+        }
+
+        // nodi da dividere: la foglia e gli antenati pieni consecutivi
+        std::size_t full = 0;
+        while(full < depth && path[depth - 1 - full]->count == inner_fanout)
+            full++;
+
+        leaf_node *r = create_node<leaf_node>();
+        inner_node *spare[max_height + 1];
+        std::size_t needed = full + (full == depth ? 1 : 0);
+        std::size_t made = 0;
+        try{
+            for(; made < needed; ++made)
+                spare[made] = create_node<inner_node>();
+        }
+        catch(...){
+            for(std::size_t j = 0; j < made; ++j)
+                free_node(spare[j]);
+            free_node(r);
+            throw;
+        }
+
+        // divisione della foglia: in coda all'albero la foglia resta piena
+        std::size_t split = (rightmost && pos == l->count) ? l->count : l->count / 2;
+        move_keys(l->keys, split, l->count, r->keys);
+        r->count = (unsigned short)(l->count - split);
+        l->count = (unsigned short) split;
+
+        r->prev = l;
+        r->next = l->next;
+        if(l->next != nullptr)
+            l->next->prev = r;
+        else
+            _last = r;
+        l->next = r;
+
+        if(pos >= split){
+            insert_key(r->keys, r->count, pos - split, std::forward<V>(value));
+            r->count++;
+        }
+        else{
+            insert_key(l->keys, l->count, pos, std::forward<V>(value));
+            l->count++;
+        }
+        _size++;
+
+        // risalita: inserimento del separatore nei padri
+        T sep(key(r->keys[0]));
+        node_base *right = r;
+        std::size_t s = 0;
+
+        while(depth > 0){
+            depth--;
+            inner_node *p = path[depth];
+            std::size_t i = index[depth];
+
+            if(p->count < inner_fanout){
+                insert_child(p, i, std::move(sep), right);
+                return true;
+            }
+
+            inner_node *q = spare[s++];
+
+            if(rightmost && i == p->count){
+                // in coda all'albero il nuovo nodo parte con il solo figlio
+                q->children[0] = right;
+                right = q;
+                continue;
+            }
+
+            std::size_t mid = p->count / 2;
+            T up(std::move(key(p->keys[mid])));
+            key(p->keys[mid]).~T();
+
+            move_keys(p->keys, mid + 1, p->count, q->keys);
+            for(std::size_t j = mid + 1; j <= p->count; ++j)
+                q->children[j - mid - 1] = p->children[j];
+            q->count = (unsigned short)(p->count - mid - 1);
+            p->count = (unsigned short) mid;
+
+            if(i <= mid)
+                insert_child(p, i, std::move(sep), right);
+            else
+                insert_child(q, i - mid - 1, std::move(sep), right);
+
+            sep = std::move(up);
+            right = q;
+        }
+
+        // divisa anche la radice: l'albero cresce di un livello
+        inner_node *root = spare[s];
+        ::new (&root->keys[0]) T(std::move(sep));
+        root->children[0] = _root;
+        root->children[1] = right;
+        root->count = 1;
+        _root = root;
+        return true;
+    }
+
+    /**
+     * Copia il sottoalbero radicato in n collegando le foglie copiate
+     * in coda a prev
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    node_base *copy_helper(const node_base *n, leaf_node *&prev){
+        if(n->leaf){
+            const leaf_node *src = static_cast<const leaf_node *>(n);
+            leaf_node *l = create_node<leaf_node>();
+            try{
+                for(; l->count < src->count; l->count++)
+                    ::new (&l->keys[l->count]) T(key(src->keys[l->count]));
+            }
+            catch(...){
+                free_node(l);
+                throw;
+            }
+
+            l->prev = prev;
+            if(prev != nullptr)
+                prev->next = l;
+            prev = l;
+            return l;
+        }
+
+        const inner_node *src = static_cast<const inner_node *>(n);
+        inner_node *in = create_node<inner_node>();
+        in->children[0] = nullptr;
+        try{
+            in->children[0] = copy_helper(src->children[0], prev);
+            for(; in->count < src->count; in->count++){
+                std::size_t i = in->count;
+                ::new (&in->keys[i]) T(key(src->keys[i]));
+                try{
+                    in->children[i + 1] = copy_helper(src->children[i + 1], prev);
+                }
+                catch(...){
+                    key(in->keys[i]).~T();
+                    throw;
+                }
+            }
+        }
+        catch(...){
+            if(in->children[0] != nullptr)
+                clear_helper(in);
+            else
+                free_node(in);
+            throw;
+        }
+        return in;
+    }
+
+    /**
+     * Numero di valori nel sottoalbero radicato in n
+    */
+    static std::size_t count_helper(const node_base *n){
+        if(n->leaf)
+            return n->count;
+
+        const inner_node *in = static_cast<const inner_node *>(n);
+        std::size_t c = 0;
+        for(std::size_t i = 0; i <= in->count; ++i)
+            c += count_helper(in->children[i]);
+        return c;
+    }
+
+    /**
+     * Sostituisce il contenuto (vuoto) dell'albero con una copia del
+     * sottoalbero radicato in n
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    void copy_from(const node_base *n){
+        leaf_node *prev = nullptr;
+        _root = copy_helper(n, prev);
+        _last = prev;
+
+        node_base *f = _root;
+        while(!f->leaf)
+            f = static_cast<inner_node *>(f)->children[0];
+        _first = static_cast<leaf_node *>(f);
+        _size = count_helper(_root);
+    }
+
+    /**
+     * Costruttore con l'allocatore delle linee, per gli alberi derivati
+    */
+    bplus_tree(const line_allocator &alloc, line_alloc_tag)
+        : _root(nullptr), _first(nullptr), _last(nullptr), _size(0), _alloc(alloc) {}
+
+public:
+
+    /**
+     * Costruttore di default
+    */
+    bplus_tree(): _root(nullptr), _first(nullptr), _last(nullptr), _size(0) {}
+
+    /**
+     * Costruttore con allocatore
+     *
+     * @param alloc allocatore dei nodi
+    */
+    explicit bplus_tree(const A &alloc)
+        : _root(nullptr), _first(nullptr), _last(nullptr), _size(0), _alloc(alloc) {}
+
+    /**
+     * Costruttore di copia
+     *
+     * @param other albero da copiare
+     *
+     * @throw eccezione di copiatura dell'albero
+    */
+    bplus_tree(const bplus_tree &other)
+        : _root(nullptr), _first(nullptr), _last(nullptr), _size(0),
+          _conf(other._conf), _eql(other._eql),
+          _alloc(line_traits::select_on_container_copy_construction(other._alloc)) {
+        if(other._root == nullptr)
+            return;
+
+        try{
+            copy_from(other._root);
+        }
+        catch(...){
+            _root = _first = _last = nullptr;
+            _size = 0;
+            throw NoTreeCopiedException();
+        }
+    }
+
+    /**
+     * Costruttore di spostamento: other resta vuoto
+     *
+     * @param other albero da spostare
+    */
+    bplus_tree(bplus_tree &&other)
+        : _root(other._root), _first(other._first), _last(other._last), _size(other._size),
+          _conf(other._conf), _eql(other._eql), _alloc(other._alloc) {
+        other._root = nullptr;
+        other._first = nullptr;
+        other._last = nullptr;
+        other._size = 0;
+    }
+
+    /**
+     * Distruttore
+    */
+    ~bplus_tree(){
+        clear();
+    }
+
+    /**
+     * Operatore di assegnamento
+     *
+     * @param other albero da copiare
+     *
+     * @throw eccezione di copiatura dell'albero
+    */
+    bplus_tree &operator=(const bplus_tree &other){
+        if(this != &other){
+            bplus_tree tmp(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    /**
+     * Operatore di assegnamento per spostamento
+     *
+     * @param other albero da spostare
+    */
+    bplus_tree &operator=(bplus_tree &&other){
+        if(this != &other){
+            bplus_tree tmp(std::move(other));
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    /**
+     * Scambia il contenuto di due alberi in tempo costante
+     *
+     * @param other albero da scambiare
+    */
+    void swap(bplus_tree &other){
+        std::swap(_root, other._root);
+        std::swap(_first, other._first);
+        std::swap(_last, other._last);
+        std::swap(_size, other._size);
+        std::swap(_conf, other._conf);
+        std::swap(_eql, other._eql);
+        std::swap(_alloc, other._alloc);
+    }
+
+    /**
+     * Cancella il contenuto dell'albero
+    */
+    void clear(){
+        clear_helper(_root);
+        _root = nullptr;
+        _first = nullptr;
+        _last = nullptr;
+        _size = 0;
+    }
+
+    /**
+     * Ritorna il numero di elementi nell'albero
+     *
+     * @return numero di elementi presenti nell'albero
+    */
+    std::size_t size() const {
+        return _size;
+    }
+
+    /**
+     * Ritorna l'altezza dell'albero in nodi
+     *
+     * @return altezza dell'albero (0 se vuoto)
+    */
+    unsigned int height() const {
+        unsigned int h = 0;
+        for(const node_base *n = _root; n != nullptr; ++h){
+            if(n->leaf)
+                n = nullptr;
+            else
+                n = static_cast<const inner_node *>(n)->children[0];
+        }
+        return h;
+    }
+
+    /**
+     * Inserisce un elemento nell'albero se non è già presente.
+     * Il nodo pieno che lo riceve viene diviso in due.
+     *
+     * @param value valore da inserire
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    void add(const T &value){
+        insert_value(value);
+    }
+
+    /**
+     * Inserisce un elemento nell'albero spostandolo
+     *
+     * @param value valore da inserire
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    void add(T &&value){
+        insert_value(std::move(value));
+    }
+
+    /**
+     * Iteratore costante bidirezionale: scorre i valori di una foglia e
+     * passa alla successiva tramite il collegamento tra foglie.
+     * Resta valido finché non viene inserito un valore nell'albero.
+     *
+     * @brief Iteratore costante dell'albero
+    */
+    class const_iterator{
+
+    private:
+        const leaf_node *_l; // foglia corrente, nullptr alla fine
+        std::size_t _i; // posizione nella foglia
+        const bplus_tree *_tree; // albero visitato, per decrementare end()
+
+        friend class bplus_tree;
+
+        const_iterator(const leaf_node *l, std::size_t i, const bplus_tree *tree) : _l(l), _i(i), _tree(tree) {}
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T                         value_type;
+        typedef ptrdiff_t                 difference_type;
+        typedef const T*                  pointer;
+        typedef const T&                  reference;
+
+        const_iterator() : _l(nullptr), _i(0), _tree(nullptr) {}
+
+        const_iterator(const const_iterator &other) : _l(other._l), _i(other._i), _tree(other._tree) {}
+
+        const_iterator& operator=(const const_iterator &other) {
+            _l = other._l;
+            _i = other._i;
+            _tree = other._tree;
+            return *this;
+        }
+
+        ~const_iterator() {}
+
+        /**
+         * Ritorna il dato riferito dall'iteratore (dereferenziamento)
+        */
+        reference operator*() const {
+            return key(_l->keys[_i]);
+        }
+
+        /**
+         * Ritorna il puntatore al dato riferito dall'iteratore
+        */
+        pointer operator->() const {
+            return &key(_l->keys[_i]);
+        }
+
+        /**
+         * Operatore di iterazione post-incremento
+        */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * Operatore di iterazione pre-incremento
+        */
+        const_iterator& operator++() {
+            if(++_i == _l->count){
+                _l = _l->next;
+                _i = 0;
+            }
+            return *this;
+        }
+
+        /**
+         * Operatore di iterazione post-decremento
+        */
+        const_iterator operator--(int) {
+            const_iterator tmp(*this);
+            --(*this);
+            return tmp;
+        }
+
+        /**
+         * Operatore di iterazione pre-decremento.
+         * Decrementare end() porta all'ultimo elemento.
+        */
+        const_iterator& operator--() {
+            if(_l == nullptr){
+                _l = _tree->_last;
+                _i = _l->count - 1;
+            }
+            else if(_i == 0){
+                _l = _l->prev;
+                _i = _l->count - 1;
+            }
+            else{
+                _i--;
+            }
+            return *this;
+        }
+
+        /**
+         * Uguaglianza
+        */
+        bool operator==(const const_iterator &other) const {
+            return _l == other._l && _i == other._i;
+        }
+
+        /**
+         * Diversità
+        */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    };
+
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /**
+     * Ritorna l'iteratore all'inizio della sequenza dati
+     *
+     * @return iteratore all'inizio della sequenza
+    */
+    const_iterator begin() const {
+        return const_iterator(_first, 0, this);
+    }
+
+    /**
+     * Ritorna l'iteratore alla fine della sequenza dati
+     *
+     * @return iteratore alla fine della sequenza
+    */
+    const_iterator end() const {
+        return const_iterator(nullptr, 0, this);
+    }
+
+    /**
+     * Ritorna l'iteratore all'inizio della sequenza dati in ordine inverso
+    */
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    /**
+     * Ritorna l'iteratore alla fine della sequenza dati in ordine inverso
+    */
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento non minore di value
+     *
+     * @param value valore da cercare
+    */
+    const_iterator lower_bound(const T &value) const {
+        if(_root == nullptr)
+            return end();
+
+        const leaf_node *l = find_leaf_lower(value);
+        std::size_t i = lower_index(l->keys, l->count, value);
+        if(i == l->count)
+            return const_iterator(l->next, 0, this);
+        return const_iterator(l, i, this);
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento maggiore di value
+     *
+     * @param value valore da cercare
+    */
+    const_iterator upper_bound(const T &value) const {
+        if(_root == nullptr)
+            return end();
+
+        const leaf_node *l = find_leaf_upper(value);
+        std::size_t i = upper_index(l->keys, l->count, value);
+        if(i == l->count)
+            return const_iterator(l->next, 0, this);
+        return const_iterator(l, i, this);
+    }
+
+    /**
+     * Cerca un elemento nell'albero: una ricerca binaria per livello,
+     * poi un confronto di uguaglianza tra i valori equivalenti.
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore all'elemento, end() se non presente
+    */
+    const_iterator find(const T &value) const {
+        const_iterator it = lower_bound(value);
+        for(; it != end() && !_conf(value, *it); ++it){
+            if(_eql(*it, value))
+                return it;
+        }
+        return end();
+    }
+
+    /**
+     * Determina se esiste un determinato elemento nell'albero
+     *
+     * @param value valore da cercare
+     *
+     * @return true se esiste l'elemento, false altrimenti
+    */
+    bool contains(const T &value) const {
+        return find(value) != end();
+    }
+
+    /**
+     * Ritorna il sottoalbero del nodo più alto che contiene value, come
+     * valore o come separatore. Il sottoalbero è una copia.
+     *
+     * @param value valore da cercare
+     *
+     * @return il sottoalbero ricercato, vuoto se value non è presente
+     *
+     * @throw eccezione di copiatura dell'albero
+    */
+    bplus_tree subtree(const T &value) const {
+        bplus_tree tmp(line_traits::select_on_container_copy_construction(_alloc), line_alloc_tag());
+        tmp._conf = _conf;
+        tmp._eql = _eql;
+
+        const node_base *n = _root;
+        while(n != nullptr){
+            const slot *keys = n->leaf ? static_cast<const leaf_node *>(n)->keys
+                                       : static_cast<const inner_node *>(n)->keys;
+            std::size_t i = upper_index(keys, n->count, value);
+
+            bool found = false;
+            for(std::size_t j = i; j > 0 && !_conf(key(keys[j - 1]), value); --j){
+                if(_eql(key(keys[j - 1]), value)){
+                    found = true;
+                    break;
+                }
+            }
+
+            if(found){
+                try{
+                    tmp.copy_from(n);
+                }
+                catch(...){
+                    tmp._root = tmp._first = tmp._last = nullptr;
+                    throw NoTreeCopiedException();
+                }
+                return tmp;
+            }
+
+            if(n->leaf)
+                break;
+            n = static_cast<const inner_node *>(n)->children[i];
+        }
+        return tmp;
+    }
+
+};
+
+/**
+ * Scambia il contenuto di due alberi in tempo costante
+*/
+template <typename T, typename C, typename E, typename A>
+void swap(bplus_tree<T,C,E,A> &a, bplus_tree<T,C,E,A> &b) {
+    a.swap(b);
+}
+
+/**
+ * Overload dell'operatore di stream << per un bplus_tree
+ *
+ * @brief Operatore <<
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ * @param A allocatore
+ *
+ * @return puntatore allo stream
+*/
+template <typename T, typename C, typename E, typename A>
+std::ostream &operator<<(std::ostream &os, const bplus_tree<T,C,E,A> &bstree) {
+
+    typename bplus_tree<T,C,E,A>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i)
+        os << *i << " ";
+
+    return os;
+}
+
+/**
+ * Stampa a schermo l'elenco dei valori dell'albero che soddisfano
+ * un predicato.
+ *
+ * @brief Stampa i valori dell'albero che soddisfano un predicato.
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ * @param P funtore del predicato
+ * @param A allocatore
+ * @param bstree albero di tipo T
+ * @param pred predicato
+*/
+template <typename T, typename C, typename E, typename P, typename A>
+void printIF(const bplus_tree<T,C,E,A> &bstree, P pred) {
+
+    typename bplus_tree<T,C,E,A>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i) {
+        if(pred(*i))
+            std::cout << *i << std::endl;
+    }
+
+}
+
+#endif
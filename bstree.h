@@ -2,9 +2,21 @@
 #define BSTREE_H
 
 #include <ostream>
-#include <iterator> // std::forward_iterator_tag
+#include <iterator> // std::bidirectional_iterator_tag, std::reverse_iterator
 #include <cstddef>  // std::ptrdiff_t
 #include <iostream>
+#include <memory>   // std::allocator, std::allocator_traits
+#include <type_traits> // std::is_trivially_destructible
+#include <utility>  // std::move, std::forward
+#include <thread>   // std::thread
+#include <atomic>   // std::atomic
+#include <mutex>    // std::mutex, std::lock_guard
+#include <vector>   // std::vector
+#include <exception> // std::exception_ptr
+#include <string>   // std::string
+#include <cstring>  // std::memcpy
+#include <cstdint>  // std::uint32_t, std::uint64_t
+#include "pool_allocator.h"
 
 /**
  * @brief Tentativo di copia dell'albero fallita.
@@ -29,486 +41,4356 @@ class NoNodeCreatedException: public std::exception {
 };
 
 /**
- * Classe generica che implementa un albero binario di ricerca.
+ * @brief Tentativo di inserire un nodo creato con un allocatore non compatibile
  * 
- * @brief Albero binario di ricerca
+ * @return Eccezione
+ */
+class IncompatibleAllocatorException: public std::exception {
+  virtual const char* what() const throw() {
+    return "nodo creato con un allocatore non compatibile";
+  }
+};
+
+/**
+ * @brief Scrittura dell'albero su stream fallita
+ * 
+ * @return Eccezione
+ */
+class NoTreeSavedException: public std::exception {
+  virtual const char* what() const throw() {
+    return "errore nella scrittura dell'albero";
+  }
+};
+
+/**
+ * @brief Lettura dell'albero da stream fallita (errore di I/O o formato non valido)
+ * 
+ * @return Eccezione
+ */
+class NoTreeLoadedException: public std::exception {
+  virtual const char* what() const throw() {
+    return "errore nella lettura dell'albero";
+  }
+};
+
+/**
+ * Politica di bilanciamento nulla: l'inserimento è una semplice discesa
+ * e la forma dell'albero dipende dall'ordine degli inserimenti.
+ * 
+ * @brief Nessun bilanciamento (default)
+*/
+struct unbalanced {
+    struct node_info {};
+};
+
+/**
+ * Politica di bilanciamento AVL: le altezze dei due sottoalberi di ogni
+ * nodo differiscono al più di uno, quindi l'altezza è al più ~1.44 log2(n).
+ * 
+ * @brief Bilanciamento AVL
+*/
+struct avl_balance {
+    struct node_info {
+        int height; // altezza del sottoalbero radicato nel nodo
+
+        node_info(): height(1) {}
+    };
+};
+
+/**
+ * Politica di bilanciamento red-black: ogni percorso radice-foglia contiene
+ * lo stesso numero di nodi neri, quindi l'altezza è al più 2 log2(n+1).
+ * 
+ * @brief Bilanciamento red-black
+*/
+struct red_black_balance {
+    struct node_info {
+        bool red; // colore del nodo
+
+        node_info(): red(true) {}
+    };
+};
+
+/**
+ * Politica splay: ogni nodo cercato con find o contains, inserito con add
+ * o padre di un nodo rimosso sale fino alla radice con rotazioni a coppie.
+ * Il costo ammortizzato resta O(log n) e i valori cercati spesso restano
+ * vicini alla radice, quindi con accessi molto sbilanciati le ricerche
+ * costano quasi O(1). Una ricerca fallita porta alla radice l'ultimo nodo
+ * visitato. Le rotazioni spostano anche i valori equivalenti per C ma
+ * diversi per E; le ricerche li trovano comunque scorrendo la sequenza di
+ * equivalenti vicina al punto di arrivo, come con AVL e rosso-nero.
+ * 
+ * Con questa politica find e contains modificano la forma dell'albero pur
+ * essendo const: non sono sicure con più lettori concorrenti, nemmeno se
+ * nessuno scrive, e invalidano le viste sui sottoalberi. Gli iteratori
+ * restano validi perché i nodi non cambiano.
+ * 
+ * @brief Albero splay
+*/
+struct splay_balance {
+    struct node_info {};
+};
+
+/**
+ * Politica semi-splay: variante più economica di splay_balance con gli
+ * stessi vincoli sulle ricerche const. Un nodo visitato viene ristrutturato
+ * solo se è più profondo di log2(n) + 1; in quel caso la risalita
+ * dimezza la profondità del percorso invece di portare il nodo alla
+ * radice: in un passo zig-zig ruota solo il nonno e prosegue dal padre.
+ * Le chiavi cercate spesso salgono in pochi accessi e restano vicine alla
+ * radice, mentre gli accessi a nodi già poco profondi non costano
+ * rotazioni.
+ * 
+ * @brief Albero semi-splay
+*/
+struct semi_splay_balance {
+    struct node_info {};
+};
+
+/**
+ * Etichetta per i costruttori da sequenza: la sequenza è ordinata secondo il
+ * funtore di comparazione ma può contenere duplicati consecutivi.
+ * 
+ * @brief Sequenza ordinata
+*/
+struct sorted_range_t {};
+const sorted_range_t sorted_range = sorted_range_t();
+
+/**
+ * Etichetta per i costruttori da sequenza: la sequenza è ordinata secondo il
+ * funtore di comparazione e non contiene duplicati.
+ * 
+ * @brief Sequenza ordinata e senza duplicati
+*/
+struct sorted_unique_range_t {};
+const sorted_unique_range_t sorted_unique_range = sorted_unique_range_t();
+
+/**
+ * Funzionalità opzionali dell'albero, combinabili con l'operatore |
+ * 
+ * @brief Funzionalità opzionali dell'albero
+*/
+enum bst_features {
+    bst_order_statistics = 1, ///< dimensione del sottoalbero in ogni nodo (rank, select)
+    bst_threaded = 2 ///< collegamenti al precedente e al successivo in ordine in ogni nodo
+};
+
+/**
+ * Dimensione del sottoalbero memorizzata nel nodo: assente
+ * 
+ * @brief Dimensione del sottoalbero (assente)
+*/
+template <bool S>
+struct bst_size_info {};
+
+/**
+ * Dimensione del sottoalbero memorizzata nel nodo
+ * 
+ * @brief Dimensione del sottoalbero
+*/
+template <>
+struct bst_size_info<true> {
+    std::size_t count; // numero di nodi del sottoalbero radicato nel nodo
+
+    bst_size_info(): count(1) {}
+};
+
+/**
+ * Collegamenti in ordine memorizzati nel nodo: assenti
+ * 
+ * @brief Collegamenti in ordine (assenti)
+*/
+template <bool S, typename N>
+struct bst_thread_info {};
+
+/**
+ * Collegamenti al nodo precedente e successivo nella visita in ordine,
+ * per incrementare e decrementare gli iteratori con un solo accesso
+ * 
+ * @brief Collegamenti in ordine
+*/
+template <typename N>
+struct bst_thread_info<true, N> {
+    N *prev; // nodo precedente in ordine, nullptr per il minimo
+    N *next; // nodo successivo in ordine, nullptr per il massimo
+
+    bst_thread_info(): prev(nullptr), next(nullptr) {}
+};
+
+template <typename X>
+struct bst_void {
+    typedef void type;
+};
+
+/**
+ * Indica se il funtore F dichiara is_transparent, cioè se confronta
+ * valori di tipo T anche con chiavi di altri tipi
+ * 
+ * @brief Funtore trasparente
+*/
+template <typename F, typename = void>
+struct bst_is_transparent : std::false_type {};
+
+template <typename F>
+struct bst_is_transparent<F, typename bst_void<typename F::is_transparent>::type> : std::true_type {};
+
+/**
+ * Abilita le ricerche per una chiave di tipo K solo se sia il funtore di
+ * confronto C sia quello di uguaglianza E sono trasparenti
+ * 
+ * @brief Ricerca eterogenea
+*/
+template <typename C, typename E, typename K, typename R>
+struct bst_enable_transparent
+    : std::enable_if<bst_is_transparent<C>::value && bst_is_transparent<E>::value, R> {};
+
+/**
+ * Funtore di uguaglianza segnaposto: l'uguaglianza è ricavata dal funtore
+ * di confronto. Con un confronto a tre vie ogni nodo visitato costa un
+ * solo confronto; con un confronto "minore di" due valori sono uguali se
+ * nessuno dei due precede l'altro.
+ * 
+ * @brief Uguaglianza ricavata dal confronto
+*/
+struct bst_derived_equal {};
+
+/**
+ * Indica se il funtore di confronto C è a tre vie, cioè ritorna un valore
+ * negativo, zero o positivo (oppure std::strong_ordering) invece di "a
+ * precede b". Il funtore lo dichiara con un tipo annidato is_three_way,
+ * come is_transparent per le ricerche eterogenee. Senza dichiarazione il
+ * risultato di C è sempre convertito in bool, qualunque sia il suo tipo.
+ * 
+ * @brief Confronto a tre vie
+*/
+template <typename C, typename = void>
+struct bst_is_three_way : std::false_type {};
+
+template <typename C>
+struct bst_is_three_way<C, typename bst_void<typename C::is_three_way>::type> : std::true_type {};
+
+/**
+ * Indica se l'uguaglianza E coincide con l'equivalenza del confronto C
+ * (nessuno dei due valori precede l'altro). In quel caso l'albero cerca
+ * con il solo C, un confronto per nodo se C è a tre vie. Vale per
+ * bst_derived_equal e va specializzata a true per le altre coppie
+ * equivalenti, come bst_natural_order.
  * 
+ * @brief Uguaglianza ricavabile dal confronto
+*/
+template <typename C, typename E>
+struct bst_equal_from_order : std::is_same<E, bst_derived_equal> {};
+
+/**
+ * Controlla il tipo del risultato di un confronto a tre vie: non può
+ * essere bool e, se aritmetico, deve avere segno
+*/
+template <typename R>
+struct bst_three_way_result : std::integral_constant<bool, !std::is_same<R, bool>::value &&
+    (!std::is_arithmetic<R>::value || std::is_signed<R>::value)> {};
+
+/**
+ * Determina se a precede b con il funtore di confronto conf,
+ * sia esso "minore di" o a tre vie (bst_is_three_way)
+*/
+template <typename C, typename X, typename Y>
+bool bst_less(const C &conf, const X &a, const Y &b, std::false_type) {
+    return conf(a, b) ? true : false;
+}
+
+template <typename C, typename X, typename Y>
+bool bst_less(const C &conf, const X &a, const Y &b, std::true_type) {
+    static_assert(bst_three_way_result<decltype(conf(a, b))>::value,
+                  "un confronto a tre vie deve ritornare un tipo con segno");
+    return conf(a, b) < 0;
+}
+
+template <typename C, typename X, typename Y>
+bool bst_less(const C &conf, const X &a, const Y &b) {
+    return bst_less(conf, a, b, bst_is_three_way<C>());
+}
+
+/**
+ * Ritorna -1, 0 o 1 se a precede, equivale o segue b. Con un confronto
+ * "minore di" serve un secondo confronto solo se a non precede b
+*/
+template <typename C, typename X, typename Y>
+int bst_order(const C &conf, const X &a, const Y &b, std::false_type) {
+    if(conf(a, b))
+        return -1;
+    return conf(b, a) ? 1 : 0;
+}
+
+template <typename C, typename X, typename Y>
+int bst_order(const C &conf, const X &a, const Y &b, std::true_type) {
+    static_assert(bst_three_way_result<decltype(conf(a, b))>::value,
+                  "un confronto a tre vie deve ritornare un tipo con segno");
+    const auto r = conf(a, b);
+    return r < 0 ? -1 : (r == 0 ? 0 : 1);
+}
+
+template <typename C, typename X, typename Y>
+int bst_order(const C &conf, const X &a, const Y &b) {
+    return bst_order(conf, a, b, bst_is_three_way<C>());
+}
+
+/**
+ * Uguaglianza con il funtore E
+*/
+template <typename C, typename E, typename X, typename Y>
+bool bst_equal(const C &, const E &eql, const X &a, const Y &b) {
+    return eql(a, b);
+}
+
+/**
+ * Uguaglianza ricavata dal funtore di confronto
+*/
+template <typename C, typename X, typename Y>
+bool bst_equal(const C &conf, const bst_derived_equal &, const X &a, const Y &b) {
+    return bst_order(conf, a, b) == 0;
+}
+
+/**
+ * Indica se il predicato P dichiara limiti monotoni sui valori di tipo T:
+ * below(x) vero se x e tutti i valori minori non soddisfano P, above(x)
+ * vero se x e tutti i valori maggiori non soddisfano P. Con questi limiti
+ * le ricerche saltano i sottoalberi interamente fuori dall'intervallo.
+ * "Minori" e "maggiori" sono secondo il funtore di confronto C dell'albero,
+ * non secondo l'operatore < del tipo: con un ordine diverso i limiti
+ * escluderebbero valori che soddisfano P.
+ *
+ * @brief Predicato con limiti monotoni
+*/
+template <typename P, typename T, typename = void>
+struct bst_has_bounds : std::false_type {};
+
+template <typename P, typename T>
+struct bst_has_bounds<P, T, typename bst_void<decltype(
+    std::declval<const P&>().below(std::declval<const T&>()) ||
+    std::declval<const P&>().above(std::declval<const T&>()))>::type> : std::true_type {};
+
+/**
+ * Intervallo di chiavi secondo il funtore di confronto C, usabile come
+ * predicato con limiti monotoni. Almeno uno dei due estremi è presente.
+ *
+ * @brief Intervallo di chiavi
+ *
  * @param T tipo del dato
  * @param C funtore di comparazione
- * @param E funtore di uguaglianza
 */
-template <typename T, typename C, typename E>
-class binary_search_tree {
+template <typename T, typename C>
+class bst_interval {
 
 private:
-    
+    T _lo; // estremo inferiore
+    T _hi; // estremo superiore
+    bool _has_lo; // false se l'intervallo non ha estremo inferiore
+    bool _has_hi; // false se l'intervallo non ha estremo superiore
+    bool _lo_open; // true se _lo è escluso
+    bool _hi_open; // true se _hi è escluso
+    C _conf; // oggetto funtore per il confronto
+
+    bst_interval(const T &lo, bool has_lo, bool lo_open, const T &hi, bool has_hi, bool hi_open)
+        : _lo(lo), _hi(hi), _has_lo(has_lo), _has_hi(has_hi), _lo_open(lo_open), _hi_open(hi_open) {}
+
+public:
+
     /**
-     * Struttura di supporto interna che implementa un nodo dell'albero
-     * 
-     * @brief Nodo dell'albero
+     * Intervallo chiuso [lo, hi]
     */
-    struct node {
-        
-        T value; // valore del dato inserito
-        node *parent; // padre del nodo
-        node *left; // figlio sinistro del nodo
-        node *right; // figlio destro del nodo
+    static bst_interval between(const T &lo, const T &hi) {
+        return bst_interval(lo, true, false, hi, true, false);
+    }
+
+    /**
+     * Valori x con !(x < lo)
+    */
+    static bst_interval at_least(const T &lo) {
+        return bst_interval(lo, true, false, lo, false, false);
+    }
+
+    /**
+     * Valori x con lo < x
+    */
+    static bst_interval greater_than(const T &lo) {
+        return bst_interval(lo, true, true, lo, false, false);
+    }
+
+    /**
+     * Valori x con !(hi < x)
+    */
+    static bst_interval at_most(const T &hi) {
+        return bst_interval(hi, false, false, hi, true, false);
+    }
+
+    /**
+     * Valori x con x < hi
+    */
+    static bst_interval less_than(const T &hi) {
+        return bst_interval(hi, false, false, hi, true, true);
+    }
+
+    /**
+     * Vero se x precede l'intervallo
+    */
+    bool below(const T &x) const {
+        if(!_has_lo)
+            return false;
+        return _lo_open ? !bst_less(_conf, _lo, x) : bst_less(_conf, x, _lo);
+    }
+
+    /**
+     * Vero se x segue l'intervallo
+    */
+    bool above(const T &x) const {
+        if(!_has_hi)
+            return false;
+        return _hi_open ? !bst_less(_conf, x, _hi) : bst_less(_conf, _hi, x);
+    }
+
+    /**
+     * Vero se x appartiene all'intervallo
+    */
+    bool operator()(const T &x) const {
+        return !below(x) && !above(x);
+    }
+
+};
+
+/**
+ * Predicato P ristretto a un intervallo I con limiti monotoni: soddisfatto
+ * dai valori dell'intervallo che soddisfano P
+ *
+ * @brief Predicato ristretto a un intervallo
+*/
+template <typename I, typename P>
+class bst_bounded_query {
+
+private:
+    I _interval; // intervallo con limiti monotoni
+    P _pred; // predicato sui valori dell'intervallo
+
+public:
+    bst_bounded_query(const I &interval, const P &pred): _interval(interval), _pred(pred) {}
+
+    template <typename X>
+    bool below(const X &x) const {
+        return _interval.below(x);
+    }
+
+    template <typename X>
+    bool above(const X &x) const {
+        return _interval.above(x);
+    }
+
+    template <typename X>
+    bool operator()(const X &x) const {
+        return _interval(x) && _pred(x);
+    }
+
+};
+
+/**
+ * Restringe il predicato pred all'intervallo interval
+ *
+ * @param interval intervallo con limiti monotoni (es. bst_interval)
+ * @param pred predicato
+ *
+ * @return predicato con i limiti di interval
+*/
+template <typename I, typename P>
+bst_bounded_query<I, P> bst_query(const I &interval, const P &pred) {
+    return bst_bounded_query<I, P>(interval, pred);
+}
+
+/**
+ * Scrittura bufferizzata su uno stream: i dati sono accumulati in un
+ * buffer e passati allo streambuf a blocchi grandi.
+ *
+ * @brief Scrittore binario bufferizzato
+*/
+class bst_binary_writer {
+
+private:
+    enum { buffer_size = 1 << 16 };
+
+    std::ostream &_os; // stream di destinazione
+    std::unique_ptr<char[]> _buffer; // dati non ancora scritti
+    std::size_t _used; // byte occupati nel buffer
+
+    bst_binary_writer(const bst_binary_writer &);
+    bst_binary_writer &operator=(const bst_binary_writer &);
+
+    void put(const char *p, std::size_t n) {
+        std::streambuf *sb = _os.rdbuf();
+        if(n > 0 && (sb == nullptr || sb->sputn(p, (std::streamsize)n) != (std::streamsize)n)) {
+            try {
+                _os.setstate(std::ios::badbit);
+            }
+            catch(const std::ios_base::failure &) {
+                // l'errore è segnalato dall'eccezione dell'albero
+            }
+            throw NoTreeSavedException();
+        }
+    }
+
+public:
+
+    /**
+     * @throw std::bad_alloc
+    */
+    explicit bst_binary_writer(std::ostream &os): _os(os), _buffer(new char[buffer_size]), _used(0) {}
+
+    /**
+     * Accoda n byte; i blocchi più grandi del buffer sono scritti direttamente
+     *
+     * @throw NoTreeSavedException se lo stream non accetta i dati
+    */
+    void write(const void *p, std::size_t n) {
+        if(_used + n > buffer_size) {
+            flush();
+            if(n > buffer_size) {
+                put(static_cast<const char *>(p), n);
+                return;
+            }
+        }
+        std::memcpy(_buffer.get() + _used, p, n);
+        _used += n;
+    }
+
+    /**
+     * Passa allo stream i dati accumulati nel buffer e lo svuota
+     *
+     * @throw NoTreeSavedException se lo stream non accetta i dati
+    */
+    void flush() {
+        put(_buffer.get(), _used);
+        _used = 0;
+    }
+
+};
+
+/**
+ * Lettura da uno stream tramite il suo streambuf, senza leggere oltre i
+ * byte richiesti: dopo l'albero lo stream può contenere altri dati.
+ *
+ * @brief Lettore binario
+*/
+class bst_binary_reader {
+
+private:
+    std::istream &_is; // stream di origine
+
+public:
+    explicit bst_binary_reader(std::istream &is): _is(is) {}
+
+    /**
+     * Legge esattamente n byte
+     *
+     * @throw NoTreeLoadedException se lo stream finisce prima
+    */
+    void read(void *p, std::size_t n) {
+        std::streambuf *sb = _is.rdbuf();
+        if(n > 0 && (sb == nullptr || sb->sgetn(static_cast<char *>(p), (std::streamsize)n) != (std::streamsize)n)) {
+            try {
+                _is.setstate(std::ios::failbit | std::ios::eofbit);
+            }
+            catch(const std::ios_base::failure &) {
+                // l'errore è segnalato dall'eccezione dell'albero
+            }
+            throw NoTreeLoadedException();
+        }
+    }
+
+};
+
+/**
+ * Etichetta del tipo dei valori, registrata nell'intestazione binaria per
+ * rifiutare un file scritto con un altro tipo anche se della stessa
+ * dimensione (int e float). Per i tipi aritmetici e le enumerazioni è
+ * ricavata da categoria, segno e dimensione; gli altri tipi hanno
+ * un'etichetta generica con la sola dimensione e possono specializzare
+ * bst_type_tag con un valore proprio.
+ *
+ * @brief Etichetta del tipo serializzato
+ *
+ * @param T tipo del dato
+*/
+template <typename T>
+struct bst_type_tag : std::integral_constant<std::uint32_t,
+    ((std::uint32_t)(std::is_same<T, bool>::value ? 'B' :
+                     std::is_floating_point<T>::value ? 'F' :
+                     std::is_integral<T>::value ? (std::is_signed<T>::value ? 'I' : 'U') :
+                     std::is_enum<T>::value ? 'E' : 'R') << 24) | (std::uint32_t)sizeof(T)> {};
+
+template <>
+struct bst_type_tag<std::string> : std::integral_constant<std::uint32_t, (std::uint32_t)'S' << 24> {};
+
+/**
+ * Codifica binaria dei valori di tipo T. Quella di default copia i byte
+ * del valore e vale per i tipi banalmente copiabili; per gli altri tipi va
+ * specializzata con lo stesso schema (fixed_size 0 se la lunghezza varia,
+ * type_tag diverso per ogni codifica). I byte sono nell'ordine della
+ * macchina che scrive, registrato nell'intestazione.
+ *
+ * @brief Codifica binaria di un valore
+ *
+ * @param T tipo del dato
+*/
+template <typename T>
+struct bst_serializer {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "bst_serializer va specializzato per i tipi non banalmente copiabili");
+
+    /**
+     * Byte di ogni valore, registrati nell'intestazione per riconoscere
+     * un file scritto con un altro tipo
+    */
+    static const std::uint32_t fixed_size = sizeof(T);
+
+    /**
+     * Etichetta del tipo, registrata nell'intestazione
+    */
+    static const std::uint32_t type_tag = bst_type_tag<T>::value;
+
+    static void write(bst_binary_writer &out, const T &value) {
+        out.write(&value, sizeof(T));
+    }
+
+    static T read(bst_binary_reader &in) {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type raw;
+        in.read(&raw, sizeof(T));
+        return *reinterpret_cast<const T *>(&raw);
+    }
+};
+
+/**
+ * Codifica di una stringa: lunghezza a 32 bit seguita dai caratteri
+*/
+template <>
+struct bst_serializer<std::string> {
+    static const std::uint32_t fixed_size = 0;
+    static const std::uint32_t type_tag = bst_type_tag<std::string>::value;
+
+    /**
+     * @throw NoTreeSavedException se la stringa ha 2^32 caratteri o più
+    */
+    static void write(bst_binary_writer &out, const std::string &value) {
+        if(value.size() > 0xffffffffu)
+            throw NoTreeSavedException();
+        std::uint32_t n = (std::uint32_t)value.size();
+        out.write(&n, sizeof(n));
+        out.write(value.data(), n);
+    }
+
+    static std::string read(bst_binary_reader &in) {
+        std::uint32_t n;
+        in.read(&n, sizeof(n));
+        std::string value;
+        // la stringa cresce a blocchi, così una lunghezza corrotta non
+        // alloca più dei byte davvero presenti nello stream
+        char chunk[4096];
+        while(n > 0) {
+            std::uint32_t k = n < sizeof(chunk) ? n : (std::uint32_t)sizeof(chunk);
+            in.read(chunk, k);
+            value.append(chunk, k);
+            n -= k;
+        }
+        return value;
+    }
+};
+
+/**
+ * Intestazione del formato binario di un albero, seguita dai valori in
+ * ordine codificati con bst_serializer
+ *
+ * @brief Intestazione del formato binario
+*/
+struct bst_binary_header {
+    enum { version = 2 };
+
+    /**
+     * Valore di byte_order scritto nell'ordine della macchina: letto su una
+     * macchina con l'ordine opposto risulta diverso
+    */
+    static const std::uint32_t native_order = 0x01020304u;
+
+    char magic[4]; // "BSTB"
+    std::uint32_t format; // versione del formato
+    std::uint32_t value_size; // bst_serializer<T>::fixed_size
+    std::uint32_t type_tag; // bst_serializer<T>::type_tag
+    std::uint32_t byte_order; // native_order della macchina che scrive
+    std::uint64_t count; // numero di valori
+
+    void write(bst_binary_writer &out) const {
+        out.write(magic, sizeof(magic));
+        out.write(&format, sizeof(format));
+        out.write(&value_size, sizeof(value_size));
+        out.write(&type_tag, sizeof(type_tag));
+        out.write(&byte_order, sizeof(byte_order));
+        out.write(&count, sizeof(count));
+    }
+
+    /**
+     * Legge e verifica l'intestazione: formato, dimensione ed etichetta del
+     * tipo, ordine dei byte
+     *
+     * @throw NoTreeLoadedException se l'intestazione non è valida
+    */
+    void read(bst_binary_reader &in, std::uint32_t expected_size, std::uint32_t expected_tag) {
+        in.read(magic, sizeof(magic));
+        in.read(&format, sizeof(format));
+        in.read(&value_size, sizeof(value_size));
+        in.read(&type_tag, sizeof(type_tag));
+        in.read(&byte_order, sizeof(byte_order));
+        in.read(&count, sizeof(count));
+        if(std::memcmp(magic, "BSTB", 4) != 0 || format != version || value_size != expected_size ||
+           type_tag != expected_tag || byte_order != native_order)
+            throw NoTreeLoadedException();
+    }
+};
+
+/**
+ * Esegue i lavori [0, count) su un gruppo di thread con il furto di lavoro.
+ * Ogni thread parte da un intervallo contiguo di lavori e li esegue in
+ * ordine; quando il suo intervallo è vuoto ruba la metà finale
+ * dell'intervallo di un altro thread, così i thread che finiscono prima
+ * aiutano quelli con i lavori più lunghi.
+ *
+ * @brief Esecuzione parallela con furto di lavoro
+*/
+class bst_work_stealing {
+
+private:
+
+    /**
+     * Lavori ancora da eseguire di un thread
+    */
+    struct range {
+        std::mutex lock;
+        std::size_t lo; // prossimo lavoro
+        std::size_t hi; // fine dell'intervallo
+    };
+
+    /**
+     * Prende il prossimo lavoro dal proprio intervallo
+    */
+    static bool take(range &r, std::size_t &i) {
+        std::lock_guard<std::mutex> guard(r.lock);
+        if(r.lo == r.hi)
+            return false;
+        i = r.lo++;
+        return true;
+    }
+
+    /**
+     * Ruba la metà finale dell'intervallo di un altro thread: il primo
+     * lavoro rubato viene eseguito subito, gli altri diventano il nuovo
+     * intervallo del ladro
+    */
+    static bool steal(range *ranges, unsigned int threads, unsigned int self, std::size_t &i) {
+        for(unsigned int k = 1; k < threads; ++k) {
+            range &victim = ranges[(self + k) % threads];
+            std::size_t lo, hi;
+            {
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if(victim.lo == victim.hi)
+                    continue;
+                lo = victim.lo + (victim.hi - victim.lo) / 2;
+                hi = victim.hi;
+                victim.hi = lo;
+            }
+
+            std::lock_guard<std::mutex> guard(ranges[self].lock);
+            ranges[self].lo = lo + 1;
+            ranges[self].hi = hi;
+            i = lo;
+            return true;
+        }
+        return false;
+    }
+
+public:
+
+    /**
+     * Esegue work(i) per ogni i in [0, count). Chiamate con indici diversi
+     * possono avvenire in parallelo. La prima eccezione lanciata da un
+     * lavoro ferma i thread e viene rilanciata al chiamante.
+     *
+     * @param count numero di lavori
+     * @param threads numero di thread, compreso il chiamante
+     * @param work lavoro da eseguire
+    */
+    template <typename W>
+    static void run(std::size_t count, unsigned int threads, W &work) {
+        if(threads > count)
+            threads = (unsigned int)count;
+        if(threads <= 1) {
+            for(std::size_t i = 0; i < count; ++i)
+                work(i);
+            return;
+        }
+
+        std::unique_ptr<range[]> ranges(new range[threads]);
+        for(unsigned int w = 0; w < threads; ++w) {
+            ranges[w].lo = count * w / threads;
+            ranges[w].hi = count * (w + 1) / threads;
+        }
+
+        std::atomic<bool> failed(false);
+        std::exception_ptr error;
+        std::mutex error_lock;
+
+        auto worker = [&](unsigned int self) {
+            std::size_t i;
+            while(!failed.load() && (take(ranges[self], i) || steal(ranges.get(), threads, self, i))) {
+                try {
+                    work(i);
+                }
+                catch(...) {
+                    std::lock_guard<std::mutex> guard(error_lock);
+                    if(!error)
+                        error = std::current_exception();
+                    failed.store(true);
+                }
+            }
+        };
+
+        // i lavori dei thread che non partono vengono rubati dagli altri
+        std::unique_ptr<std::thread[]> pool(new std::thread[threads - 1]);
+        unsigned int started = 0;
+        try {
+            for(; started < threads - 1; ++started)
+                pool[started] = std::thread(worker, started + 1);
+        }
+        catch(...) {
+            // si prosegue con i thread avviati
+        }
+        worker(0);
+        for(unsigned int i = 0; i < started; ++i)
+            pool[i].join();
+
+        if(error)
+            std::rethrow_exception(error);
+    }
+
+};
+
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F>
+class frozen_binary_search_tree; // definita in frozen_bstree.h
+
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F>
+class mapped_binary_search_tree; // definita in mapped_bstree.h
+
+/**
+ * Classe generica che implementa un albero binario di ricerca.
+ * 
+ * @brief Albero binario di ricerca
+ * 
+ * @param T tipo del dato
+ * @param C funtore di comparazione ("minore di" oppure a tre vie, vedi bst_is_three_way)
+ * @param E funtore di uguaglianza (bst_derived_equal per ricavarla da C)
+ * @param B politica di bilanciamento (unbalanced, avl_balance, red_black_balance, splay_balance, semi_splay_balance)
+ * @param A allocatore compatibile con std::allocator (es. pool_allocator)
+ * @param F funzionalità opzionali (combinazione di bst_features)
+*/
+template <typename T, typename C, typename E, typename B = unbalanced, typename A = std::allocator<T>, unsigned int F = 0>
+class binary_search_tree {
+
+private:
+
+    typedef std::integral_constant<bool, (F & bst_order_statistics) != 0> has_order_statistics;
+    typedef bst_size_info<has_order_statistics::value> size_info;
+    typedef std::integral_constant<bool, (F & bst_threaded) != 0> has_threads;
+    
+    /**
+     * Struttura di supporto interna che implementa un nodo dell'albero
+     * 
+     * @brief Nodo dell'albero
+    */
+    struct node : public B::node_info, public size_info, public bst_thread_info<has_threads::value, node> {
+        
+        T value; // valore del dato inserito
+        node *parent; // padre del nodo
+        node *left; // figlio sinistro del nodo
+        node *right; // figlio destro del nodo
+
+        /**
+         * Costruttore di default
+        */
+        node(): parent(nullptr), left(nullptr), right(nullptr) {}
+
+        /**
+         * Costruttore secondario che inizializza il nodo
+         * 
+         * @param v valore del dato
+        */
+        node(const T &v): value(v), parent(nullptr), left(nullptr), right(nullptr) {}
+
+        /**
+         * Costruttore secondario che inizializza il nodo spostando il dato
+         * 
+         * @param v valore del dato
+        */
+        node(T &&v): value(std::move(v)), parent(nullptr), left(nullptr), right(nullptr) {}
+        
+        /**
+         * Costruttore secondario che inizializza il nodo
+         * 
+         * @param v valore del dato
+         * @param p puntatore al padre
+         * @param n1 puntatore al figlio sinistro
+         * @param n2 puntatore al figlio destro
+        */
+        node(const T &v, node *p, node *n1, node *n2): value(v), parent(p), left(n1), right(n2) {}
+
+        /**
+         * Distruttore
+        */
+        ~node() {
+            parent = nullptr;
+            left = nullptr;
+            right = nullptr;
+        }
+
+    };
+
+    typedef typename std::allocator_traits<A>::template rebind_alloc<node> node_allocator;
+    typedef std::allocator_traits<node_allocator> node_traits;
+
+    mutable node *_root; // puntatore alla radice (cambia nelle ricerche con splay e semi-splay)
+    std::size_t _size; // numero di nodi nell'albero 
+
+    C _conf; // oggetto funtore per il confronto
+    E _eql; // oggetto funtore per l'uguaglianza
+
+    node_allocator _alloc; // allocatore dei nodi
+
+    /**
+     * Determina se a precede b
+    */
+    template <typename X, typename Y>
+    bool less(const X &a, const Y &b) const {
+        return bst_less(_conf, a, b);
+    }
+
+    /**
+     * Determina se a e b sono uguali
+    */
+    template <typename X, typename Y>
+    bool equal(const X &a, const Y &b) const {
+        return bst_equal(_conf, _eql, a, b);
+    }
+
+    /**
+     * Confronta la chiave cercata con il valore di un nodo durante la
+     * discesa: ritorna 0 se sono uguali, un valore negativo se la discesa
+     * prosegue a sinistra, positivo se prosegue a destra.
+     * Con l'uguaglianza ricavata dal confronto a tre vie costa una sola
+     * chiamata, con due funtori distinti ne costa due.
+    */
+    template <typename K>
+    int compare(const K &value, const T &node_value) const {
+        return compare(value, node_value, bst_equal_from_order<C, E>());
+    }
+
+    template <typename K>
+    int compare(const K &value, const T &node_value, std::true_type) const {
+        return bst_order(_conf, value, node_value);
+    }
+
+    template <typename K>
+    int compare(const K &value, const T &node_value, std::false_type) const {
+        if(_eql(node_value, value))
+            return 0;
+        return less(value, node_value) ? -1 : 1;
+    }
+
+    /**
+     * Alloca e costruisce un nodo tramite l'allocatore dell'albero
+     * 
+     * @param value valore del dato (copiato o spostato)
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename V>
+    node *create_node(V &&value){
+        node *n = nullptr;
+        try{
+            n = node_traits::allocate(_alloc, 1);
+            node_traits::construct(_alloc, n, std::forward<V>(value));
+        }
+        catch(...){
+            if(n != nullptr)
+                node_traits::deallocate(_alloc, n, 1);
+            throw NoNodeCreatedException();
+        }
+        return n;
+    }
+
+    /**
+     * Distrugge e dealloca un nodo tramite l'allocatore dell'albero
+     * 
+     * @param n nodo da rimuovere
+    */
+    void destroy_node(node *n){
+        node_traits::destroy(_alloc, n);
+        node_traits::deallocate(_alloc, n, 1);
+    }
+
+    /**
+     * Ritorna il nodo successivo in pre-ordine all'interno del sottoalbero
+     * radicato in top, usando i puntatori al padre al posto di uno stack
+     * 
+     * @param n nodo corrente
+     * @param top radice del sottoalbero visitato
+     * 
+     * @return nodo successivo, nullptr alla fine della visita
+    */
+    static const node *preorder_next(const node *n, const node *top){
+        if(n->left != nullptr)
+            return n->left;
+        if(n->right != nullptr)
+            return n->right;
+
+        while(n != top){
+            const node *p = n->parent;
+            if(p->left == n && p->right != nullptr)
+                return p->right;
+            n = p;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Funzione helper per la rimozione iterativa dei nodi.
+     * Ogni foglia viene staccata dal padre e distrutta, poi si risale:
+     * lo spazio usato non dipende dalla forma dell'albero.
+     * 
+     * @param n radice del sottoalbero da rimuovere
+    */
+    void clear_helper(node *n){
+        node *top = n;
+
+        while(n != nullptr){
+            if(n->left != nullptr){
+                n = n->left;
+            }
+            else if(n->right != nullptr){
+                n = n->right;
+            }
+            else{
+                node *p = (n == top) ? nullptr : n->parent;
+                if(p != nullptr){
+                    if(p->left == n)
+                        p->left = nullptr;
+                    else
+                        p->right = nullptr;
+                }
+                destroy_node(n);
+                n = p;
+            }
+        }
+    }
+
+    /**
+     * Crea la copia isolata di un nodo, con le informazioni di bilanciamento
+     * 
+     * @param to_copy nodo da copiare
+     * @param parent padre del nodo copia
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    node *clone_node(const node *to_copy, node *parent){
+        node *copy = create_node(to_copy->value);
+
+        // copia delle informazioni di bilanciamento
+        static_cast<typename B::node_info &>(*copy) = *to_copy;
+        static_cast<size_info &>(*copy) = *to_copy;
+
+        copy->parent = parent;
+        return copy;
+    }
+
+    /**
+     * Funzione helper per la copia iterativa dei nodi.
+     * La visita scende nel sorgente e nella copia in parallelo e usa i figli
+     * ancora nulli della copia per sapere quali rami restano da copiare.
+     * In caso di errore la copia parziale viene distrutta.
+     * 
+     * @param to_copy nodo da copiare
+     * @param parent padre del nodo copia 
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    node * copy_helper(const node *to_copy, node *parent = nullptr){
+
+        if(to_copy == nullptr){
+            return nullptr;
+        }
+
+        node *copy = clone_node(to_copy, parent);
+        const node *src = to_copy;
+        node *dst = copy;
+
+        try{
+            while(true){
+                if(src->left != nullptr && dst->left == nullptr){
+                    dst->left = clone_node(src->left, dst);
+                    src = src->left;
+                    dst = dst->left;
+                }
+                else if(src->right != nullptr && dst->right == nullptr){
+                    dst->right = clone_node(src->right, dst);
+                    src = src->right;
+                    dst = dst->right;
+                }
+                else if(src != to_copy){
+                    src = src->parent;
+                    dst = dst->parent;
+                }
+                else{
+                    break;
+                }
+            }
+        }
+        catch(...){
+            clear_helper(copy);
+            throw;
+        }
+
+        return copy;        
+    }
+
+    /**
+     * Funzione helper per la conta iterativa dei nodi
+     * 
+     * @param to_count nodo da usare come radice nella conta
+    */
+    static std::size_t count_helper(const node *to_count){
+
+        std::size_t c = 0;
+        for(const node *n = to_count; n != nullptr; n = preorder_next(n, to_count))
+            c++;
+
+        return c;
+
+    }
+
+    /**
+     * Distrugge una lista di nodi collegati tramite il figlio destro
+     * 
+     * @param list primo nodo della lista
+    */
+    void destroy_list(node *list){
+        while(list != nullptr){
+            node *next = list->right;
+            destroy_node(list);
+            list = next;
+        }
+    }
+
+    /**
+     * Crea una lista di nodi, collegati tramite il figlio destro, con i
+     * valori della sequenza. Ogni valore è allocato una sola volta; se dedup
+     * è true un valore uguale al precedente viene scartato prima di allocarlo.
+     * 
+     * @param first inizio della sequenza
+     * @param last fine della sequenza
+     * @param dedup true per scartare i duplicati consecutivi
+     * @param n numero di nodi creati
+     * 
+     * @return primo nodo della lista
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename It>
+    node *make_list(It first, It last, bool dedup, std::size_t &n){
+        node *head = nullptr;
+        node *tail = nullptr;
+        n = 0;
+
+        try{
+            for(; first != last; ++first){
+                if(dedup && tail != nullptr && equal(tail->value, *first))
+                    continue;
+
+                node *curr = create_node(*first);
+                if(tail == nullptr)
+                    head = curr;
+                else
+                    tail->right = curr;
+                tail = curr;
+                n++;
+            }
+        }
+        catch(...){
+            destroy_list(head);
+            throw;
+        }
+        return head;
+    }
+
+    /**
+     * Ordina (in modo stabile) i primi n nodi della lista con un merge sort
+     * e li stacca dalla lista
+     * 
+     * @param head primo nodo della lista, avanzato di n nodi
+     * @param n numero di nodi da ordinare (maggiore di 0)
+     * 
+     * @return lista ordinata
+    */
+    node *sort_list(node *&head, std::size_t n){
+        if(n == 1){
+            node *single = head;
+            head = head->right;
+            single->right = nullptr;
+            return single;
+        }
+
+        node *a = sort_list(head, n / 2);
+        node *b = sort_list(head, n - n / 2);
+
+        node *sorted = nullptr;
+        node **tail = &sorted;
+        while(a != nullptr && b != nullptr){
+            if(less(b->value, a->value)){
+                *tail = b;
+                b = b->right;
+            }
+            else{
+                *tail = a;
+                a = a->right;
+            }
+            tail = &(*tail)->right;
+        }
+        *tail = (a != nullptr) ? a : b;
+
+        return sorted;
+    }
+
+    /**
+     * Elimina da una lista ordinata i nodi uguali a uno precedente. I valori
+     * uguali sono equivalenti per C, quindi basta confrontare ogni nodo con
+     * quelli della sua sequenza di equivalenti.
+     * 
+     * @param list lista ordinata
+     * @param n numero di nodi, aggiornato
+    */
+    void unique_list(node *list, std::size_t &n){
+        node *run = list; // primo nodo della sequenza di equivalenti corrente
+        while(list != nullptr && list->right != nullptr){
+            node *next = list->right;
+            if(less(run->value, next->value)){
+                run = next;
+                list = next;
+                continue;
+            }
+
+            node *same = run;
+            while(same != next && !equal(same->value, next->value))
+                same = same->right;
+            if(same != next){
+                list->right = next->right;
+                destroy_node(next);
+                n--;
+            }
+            else{
+                list = next;
+            }
+        }
+    }
+
+    /**
+     * Costruisce un albero perfettamente bilanciato consumando in ordine
+     * n nodi dalla lista. Non esegue confronti.
+     * 
+     * @param head primo nodo della lista, avanzato di n nodi
+     * @param n numero di nodi del sottoalbero
+     * @param parent padre della radice del sottoalbero
+     * @param depth profondità della radice del sottoalbero
+     * @param full numero di livelli completi dell'intero albero
+     * 
+     * @return radice del sottoalbero
+    */
+    node *build_balanced(node *&head, std::size_t n, node *parent, unsigned int depth, unsigned int full){
+        if(n == 0)
+            return nullptr;
+
+        std::size_t nl = (n - 1) / 2;
+        node *l = build_balanced(head, nl, nullptr, depth + 1, full);
+
+        node *curr = head;
+        head = head->right;
+
+        curr->parent = parent;
+        curr->left = l;
+        if(l != nullptr)
+            l->parent = curr;
+        curr->right = build_balanced(head, n - 1 - nl, curr, depth + 1, full);
+
+        update_count(curr, has_order_statistics());
+        init_built(curr, depth, full, B());
+        return curr;
+    }
+
+    void init_built(node *, unsigned int, unsigned int, unbalanced) {}
+
+    void init_built(node *n, unsigned int, unsigned int, avl_balance){
+        update(n);
+    }
+
+    void init_built(node *n, unsigned int depth, unsigned int full, red_black_balance){
+        // i livelli completi sono neri, l'ultimo livello incompleto è rosso
+        n->red = (depth >= full);
+    }
+
+    void init_built(node *, unsigned int, unsigned int, splay_balance) {}
+
+    void init_built(node *, unsigned int, unsigned int, semi_splay_balance) {}
+
+    /**
+     * Sostituisce il contenuto (vuoto) dell'albero con un albero bilanciato
+     * costruito da una lista ordinata e senza duplicati
+     * 
+     * @param list lista ordinata
+     * @param n numero di nodi della lista
+    */
+    void build_from_list(node *list, std::size_t n){
+        thread_list(list, has_threads());
+
+        unsigned int full = 0;
+        while(((std::size_t) 2 << full) - 1 <= n)
+            full++;
+
+        _root = build_balanced(list, n, nullptr, 0, full);
+        _size = n;
+    }
+
+    void thread_list(node *, std::false_type) {}
+
+    /**
+     * Collega in ordine i nodi di una lista ordinata
+    */
+    void thread_list(node *list, std::true_type){
+        node *prev = nullptr;
+        for(node *n = list; n != nullptr; n = n->right){
+            n->prev = prev;
+            if(prev != nullptr)
+                prev->next = n;
+            prev = n;
+        }
+        if(prev != nullptr)
+            prev->next = nullptr;
+    }
+
+    void thread_tree(node *, std::false_type) {}
+
+    /**
+     * Ricostruisce i collegamenti in ordine di un albero appena copiato,
+     * visitandolo tramite i puntatori al padre
+    */
+    void thread_tree(node *root, std::true_type){
+        node *prev = nullptr;
+        for(node *n = const_cast<node *>(const_iterator::leftmost(root)); n != nullptr;
+            n = const_cast<node *>(const_iterator::get_next(n, root, std::false_type()))){
+            n->prev = prev;
+            if(prev != nullptr)
+                prev->next = n;
+            prev = n;
+        }
+        if(prev != nullptr)
+            prev->next = nullptr;
+    }
+
+    void thread_insert(node *, node *, bool, std::false_type) {}
+
+    /**
+     * Inserisce nella catena in ordine un nodo appena appeso a parent
+    */
+    void thread_insert(node *n, node *parent, bool left, std::true_type){
+        if(parent == nullptr){
+            n->prev = nullptr;
+            n->next = nullptr;
+            return;
+        }
+
+        if(left){
+            n->next = parent;
+            n->prev = parent->prev;
+        }
+        else{
+            n->prev = parent;
+            n->next = parent->next;
+        }
+        if(n->prev != nullptr)
+            n->prev->next = n;
+        if(n->next != nullptr)
+            n->next->prev = n;
+    }
+
+    void thread_erase(node *, std::false_type) {}
+
+    /**
+     * Toglie un nodo dalla catena in ordine
+    */
+    void thread_erase(node *n, std::true_type){
+        if(n->prev != nullptr)
+            n->prev->next = n->next;
+        if(n->next != nullptr)
+            n->next->prev = n->prev;
+        n->prev = nullptr;
+        n->next = nullptr;
+    }
+
+    /**
+     * Ramo da copiare in parallelo: il sottoalbero src va appeso
+     * come figlio di parent
+    */
+    struct copy_task {
+        const node *src; // radice del sottoalbero sorgente
+        node *parent; // padre della copia
+        bool left; // true se la copia è figlio sinistro
+    };
+
+    /**
+     * Pezzo di una visita parallela: un nodo da solo oppure tutto il
+     * sottoalbero radicato nel nodo
+    */
+    struct visit_piece {
+        const node *n; // nodo o radice del sottoalbero
+        bool whole; // true se il pezzo è il sottoalbero intero
+    };
+
+    /**
+     * Divide i valori dell'albero in pezzi in ordine: i nodi dei primi
+     * livelli da soli e i sottoalberi sottostanti interi, circa otto per
+     * thread, così i thread che finiscono prima possono rubarne altri
+     *
+     * @param threads numero di thread (0 per usare quelli disponibili)
+     * @param pieces pezzi in ordine di chiave
+     *
+     * @return numero di thread da usare
+    */
+    unsigned int split_visit(unsigned int threads, std::vector<visit_piece> &pieces) const {
+        if(threads == 0)
+            threads = std::thread::hardware_concurrency();
+        if(threads == 0)
+            threads = 1;
+
+        unsigned int depth = 0;
+        while(threads > 1 && (1u << depth) < threads * 8 && depth < 16)
+            depth++;
+
+        split_visit(_root, depth, pieces);
+        return threads;
+    }
+
+    void split_visit(const node *n, unsigned int depth, std::vector<visit_piece> &pieces) const {
+        if(n == nullptr)
+            return;
+        if(depth == 0){
+            visit_piece p = { n, true };
+            pieces.push_back(p);
+            return;
+        }
+        split_visit(n->left, depth - 1, pieces);
+        visit_piece p = { n, false };
+        pieces.push_back(p);
+        split_visit(n->right, depth - 1, pieces);
+    }
+
+    /**
+     * Chiama f su ogni valore del pezzo in ordine
+    */
+    template <typename Fn>
+    static void visit_in_order(const visit_piece &p, Fn &f){
+        if(!p.whole){
+            f(p.n->value);
+            return;
+        }
+        for(const node *n = const_iterator::leftmost(p.n); n != nullptr; n = const_iterator::get_next(n, p.n))
+            f(n->value);
+    }
+
+    /**
+     * Copia i primi livelli dell'albero fino alla profondità depth e
+     * registra i sottoalberi sottostanti come rami da copiare in parallelo
+     * 
+     * @param to_copy nodo da copiare
+     * @param parent padre del nodo copia
+     * @param depth livelli ancora da copiare
+     * @param tasks rami registrati
+     * @param count numero di rami registrati
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    node *copy_top(const node *to_copy, node *parent, unsigned int depth, copy_task *tasks, unsigned int &count){
+        node *copy = clone_node(to_copy, parent);
+        const node *children[2] = { to_copy->left, to_copy->right };
+
+        for(int i = 0; i < 2; ++i){
+            if(children[i] == nullptr)
+                continue;
+
+            if(depth == 0){
+                copy_task t = { children[i], copy, i == 0 };
+                tasks[count++] = t;
+                continue;
+            }
+
+            try{
+                node *c = copy_top(children[i], copy, depth - 1, tasks, count);
+                if(i == 0)
+                    copy->left = c;
+                else
+                    copy->right = c;
+            }
+            catch(...){
+                clear_helper(copy);
+                throw;
+            }
+        }
+        return copy;
+    }
+
+    /**
+     * Sostituisce nel padre p il figlio old con n.
+     * Se p è nullo n diventa la nuova radice.
+    */
+    void replace_child(node *p, node *old, node *n){
+        if(p == nullptr)
+            _root = n;
+        else if(p->left == old)
+            p->left = n;
+        else
+            p->right = n;
+
+        if(n != nullptr)
+            n->parent = p;
+    }
+
+    /**
+     * Ritorna il numero di nodi del sottoalbero radicato in n.
+     * Costo costante se l'albero memorizza le dimensioni dei sottoalberi,
+     * lineare altrimenti.
+     * 
+     * @param n radice del sottoalbero (può essere nullo)
+    */
+    static std::size_t count_of(const node *n){
+        return count_of(n, has_order_statistics());
+    }
+
+    static std::size_t count_of(const node *n, std::true_type){
+        return n == nullptr ? 0 : n->count;
+    }
+
+    static std::size_t count_of(const node *n, std::false_type){
+        return count_helper(n);
+    }
+
+    /**
+     * Ritorna il k-esimo nodo (da 0) in ordine del sottoalbero radicato in n
+     * 
+     * @param n radice del sottoalbero
+     * @param k posizione, minore della dimensione del sottoalbero
+    */
+    static const node *select_node(const node *n, std::size_t k){
+        while(n != nullptr){
+            std::size_t l = count_of(n->left);
+            if(k < l){
+                n = n->left;
+            }
+            else if(k == l){
+                return n;
+            }
+            else{
+                k -= l + 1;
+                n = n->right;
+            }
+        }
+        return n;
+    }
+
+    /**
+     * Conta gli elementi minori di value (o minori o uguali se inclusive)
+     * scendendo dalla radice e sommando le dimensioni dei sottoalberi
+     * lasciati a sinistra
+    */
+    template <typename K>
+    std::size_t count_less(const K &value, bool inclusive) const {
+        std::size_t c = 0;
+        const node *curr = _root;
+
+        while(curr != nullptr){
+            int order = compare(value, curr->value);
+            if(order == 0)
+                return c + count_of(curr->left) + (inclusive ? 1 : 0);
+
+            if(order < 0){
+                curr = curr->left;
+            }
+            else{
+                c += count_of(curr->left) + 1;
+                curr = curr->right;
+            }
+        }
+        return c;
+    }
+
+    /**
+     * Copia il sottoalbero radicato nel nodo uguale a value
+     * 
+     * @throw eccezione di copiatura dell'albero
+    */
+    template <typename K>
+    binary_search_tree subtree_key(const K &value) const {
+        node *parent;
+        bool left;
+        node *curr = find_position(value, parent, left);
+        binary_search_tree tmp(node_traits::select_on_container_copy_construction(_alloc));
+
+        if(curr != nullptr){
+            try{
+                tmp._root = tmp.copy_helper(curr);
+                tmp._size = count_of(curr);
+                tmp.thread_tree(tmp._root, has_threads());
+            }
+            catch(...){
+                tmp.clear();
+                throw NoTreeCopiedException();
+            }
+        }
+
+        return tmp;
+    }
+
+    /**
+     * Ritorna il primo nodo del sottoalbero n non minore di value
+    */
+    template <typename K>
+    const node *lower_bound_node(const node *n, const K &value) const {
+        const node *candidate = nullptr;
+
+        while(n != nullptr){
+            if(less(n->value, value)){
+                n = n->right;
+            }
+            else{
+                candidate = n;
+                n = n->left;
+            }
+        }
+        return candidate;
+    }
+
+    /**
+     * Ritorna il primo nodo del sottoalbero n maggiore di value
+    */
+    template <typename K>
+    const node *upper_bound_node(const node *n, const K &value) const {
+        const node *candidate = nullptr;
+
+        while(n != nullptr){
+            if(less(value, n->value)){
+                candidate = n;
+                n = n->left;
+            }
+            else{
+                n = n->right;
+            }
+        }
+        return candidate;
+    }
+
+    /**
+     * Aggiunge delta alla dimensione di n e di tutti i suoi antenati
+    */
+    static void add_count(node *n, long delta, std::true_type){
+        for(; n != nullptr; n = n->parent)
+            n->count += delta;
+    }
+
+    static void add_count(node *, long, std::false_type) {}
+
+    static void update_count(node *n, std::true_type){
+        n->count = 1 + count_of(n->left) + count_of(n->right);
+    }
+
+    static void update_count(node *, std::false_type) {}
+
+    /**
+     * Ricalcola le informazioni del nodo che dipendono dai figli
+    */
+    void update(node *n){
+        update_count(n, has_order_statistics());
+        update(n, B());
+    }
+
+    void update(node *, unbalanced) {}
+
+    void update(node *n, avl_balance){
+        int hl = avl_height(n->left);
+        int hr = avl_height(n->right);
+        n->height = 1 + (hl > hr ? hl : hr);
+    }
+
+    void update(node *, red_black_balance) {}
+
+    void update(node *, splay_balance) {}
+
+    void update(node *, semi_splay_balance) {}
+
+    /**
+     * Rotazione a sinistra attorno a x (il figlio destro prende il suo posto)
+    */
+    void rotate_left(node *x){
+        node *y = x->right;
+
+        x->right = y->left;
+        if(y->left != nullptr)
+            y->left->parent = x;
+
+        replace_child(x->parent, x, y);
+        y->left = x;
+        x->parent = y;
+
+        update(x);
+        update(y);
+    }
+
+    /**
+     * Rotazione a destra attorno a x (il figlio sinistro prende il suo posto)
+    */
+    void rotate_right(node *x){
+        node *y = x->left;
+
+        x->left = y->right;
+        if(y->right != nullptr)
+            y->right->parent = x;
+
+        replace_child(x->parent, x, y);
+        y->right = x;
+        x->parent = y;
+
+        update(x);
+        update(y);
+    }
+
+    /**
+     * Ribilancia l'albero dopo l'inserimento del nodo n
+    */
+    void rebalance_insert(node *n){
+        rebalance_insert(n, B());
+    }
+
+    void rebalance_insert(node *, unbalanced) {}
+
+    static int avl_height(const node *n){
+        return n == nullptr ? 0 : n->height;
+    }
+
+    /**
+     * Risale da n verso la radice ricalcolando le altezze e ruotando
+     * i nodi sbilanciati. Si ferma quando un'altezza non cambia.
+    */
+    void avl_fixup(node *n){
+        while(n != nullptr){
+            int old = n->height;
+            update(n);
+
+            int bal = avl_height(n->left) - avl_height(n->right);
+            if(bal > 1){
+                if(avl_height(n->left->left) < avl_height(n->left->right))
+                    rotate_left(n->left);
+                rotate_right(n);
+                n = n->parent;
+            }
+            else if(bal < -1){
+                if(avl_height(n->right->right) < avl_height(n->right->left))
+                    rotate_right(n->right);
+                rotate_left(n);
+                n = n->parent;
+            }
+            else if(n->height == old){
+                return;
+            }
+
+            n = n->parent;
+        }
+    }
+
+    void rebalance_insert(node *n, avl_balance){
+        avl_fixup(n->parent);
+    }
+
+    static bool is_red(const node *n){
+        return n != nullptr && n->red;
+    }
+
+    void rebalance_insert(node *n, red_black_balance){
+        while(is_red(n->parent)){
+            node *p = n->parent;
+            node *g = p->parent; // esiste perché la radice è nera
+
+            if(p == g->left){
+                node *u = g->right;
+                if(is_red(u)){
+                    p->red = false;
+                    u->red = false;
+                    g->red = true;
+                    n = g;
+                    continue;
+                }
+                if(n == p->right){
+                    rotate_left(p);
+                    n = p;
+                    p = n->parent;
+                }
+                p->red = false;
+                g->red = true;
+                rotate_right(g);
+            }
+            else{
+                node *u = g->left;
+                if(is_red(u)){
+                    p->red = false;
+                    u->red = false;
+                    g->red = true;
+                    n = g;
+                    continue;
+                }
+                if(n == p->left){
+                    rotate_right(p);
+                    n = p;
+                    p = n->parent;
+                }
+                p->red = false;
+                g->red = true;
+                rotate_left(g);
+            }
+        }
+        _root->red = false;
+    }
+
+    void rebalance_insert(node *n, splay_balance){
+        splay(n);
+    }
+
+    void rebalance_insert(node *n, semi_splay_balance){
+        semi_splay(n);
+    }
+
+    /**
+     * Porta x alla radice: due rotazioni alla volta, prima quella del nonno
+     * se x e il padre sono figli dallo stesso lato (zig-zig), altrimenti
+     * prima quella del padre (zig-zag); una sola rotazione se il padre è la
+     * radice (zig)
+    */
+    void splay(node *x){
+        while(x->parent != nullptr){
+            node *p = x->parent;
+            node *g = p->parent;
+
+            if(g == nullptr){
+                if(x == p->left)
+                    rotate_right(p);
+                else
+                    rotate_left(p);
+            }
+            else if((x == p->left) == (p == g->left)){
+                if(x == p->left){
+                    rotate_right(g);
+                    rotate_right(p);
+                }
+                else{
+                    rotate_left(g);
+                    rotate_left(p);
+                }
+            }
+            else{
+                if(x == p->left){
+                    rotate_right(p);
+                    rotate_left(g);
+                }
+                else{
+                    rotate_left(p);
+                    rotate_right(g);
+                }
+            }
+        }
+    }
+
+    /**
+     * Dimezza la profondità del percorso da x alla radice se x è più
+     * profondo di log2(n) + 1. Nei passi zig-zag x sale di due livelli
+     * come nello splay; nei passi zig-zig ruota solo il nonno, il padre
+     * prende il suo posto e la risalita prosegue dal padre.
+    */
+    void semi_splay(node *x){
+        unsigned int depth = 0;
+        for(node *n = x; n->parent != nullptr; n = n->parent)
+            depth++;
+        unsigned int limit = 1;
+        for(std::size_t n = _size; n > 1; n >>= 1)
+            limit++;
+        if(depth <= limit)
+            return;
+
+        while(x->parent != nullptr && x->parent->parent != nullptr){
+            node *p = x->parent;
+            node *g = p->parent;
+
+            if((x == p->left) == (p == g->left)){
+                if(x == p->left)
+                    rotate_right(g);
+                else
+                    rotate_left(g);
+                x = p;
+            }
+            else if(x == p->left){
+                rotate_right(p);
+                rotate_left(g);
+            }
+            else{
+                rotate_left(p);
+                rotate_right(g);
+            }
+        }
+    }
+
+    /**
+     * Registra l'accesso a un nodo: con splay_balance lo porta alla radice,
+     * con semi_splay_balance ne accorcia il percorso se è troppo profondo.
+     * Le rotazioni toccano solo i nodi e la radice (mutable), quindi le
+     * ricerche possono restare const.
+     * 
+     * @param n nodo visitato, può essere nullo
+    */
+    void accessed(node *n) const {
+        accessed(n, B());
+    }
+
+    template <typename P>
+    void accessed(node *, P) const {}
+
+    void accessed(node *n, splay_balance) const {
+        if(n != nullptr)
+            const_cast<binary_search_tree *>(this)->splay(n);
+    }
+
+    void accessed(node *n, semi_splay_balance) const {
+        if(n != nullptr)
+            const_cast<binary_search_tree *>(this)->semi_splay(n);
+    }
+
+    /**
+     * Cerca il nodo uguale a value per le ricerche pubbliche e registra
+     * l'accesso al nodo trovato o, se la ricerca fallisce, all'ultimo nodo
+     * visitato
+     * 
+     * @param value chiave da cercare
+     * 
+     * @return nodo trovato, nullptr se assente
+    */
+    template <typename K>
+    node *find_accessed(const K &value) const {
+        node *parent;
+        bool left;
+        node *n = find_position(value, parent, left);
+        accessed(n != nullptr ? n : parent);
+        return n;
+    }
+
+    /**
+     * Ribilancia l'albero dopo la rimozione di un nodo
+     * 
+     * @param x nodo che ha preso il posto di quello rimosso (può essere nullo)
+     * @param xp padre di x
+     * @param removed informazioni di bilanciamento del nodo tolto dalla sua posizione
+    */
+    void rebalance_erase(node *x, node *xp, const typename B::node_info &removed){
+        rebalance_erase(x, xp, removed, B());
+    }
+
+    void rebalance_erase(node *, node *, const typename B::node_info &, unbalanced) {}
+
+    void rebalance_erase(node *, node *xp, const typename B::node_info &, avl_balance){
+        avl_fixup(xp);
+    }
+
+    void rebalance_erase(node *, node *xp, const typename B::node_info &, splay_balance){
+        if(xp != nullptr)
+            splay(xp);
+    }
+
+    void rebalance_erase(node *, node *xp, const typename B::node_info &, semi_splay_balance){
+        if(xp != nullptr)
+            semi_splay(xp);
+    }
+
+    void rebalance_erase(node *x, node *xp, const typename B::node_info &removed, red_black_balance){
+        if(removed.red)
+            return;
+
+        while(x != _root && !is_red(x)){
+            if(x == xp->left){
+                node *w = xp->right;
+                if(is_red(w)){
+                    w->red = false;
+                    xp->red = true;
+                    rotate_left(xp);
+                    w = xp->right;
+                }
+                if(!is_red(w->left) && !is_red(w->right)){
+                    w->red = true;
+                    x = xp;
+                    xp = x->parent;
+                }
+                else{
+                    if(!is_red(w->right)){
+                        w->left->red = false;
+                        w->red = true;
+                        rotate_right(w);
+                        w = xp->right;
+                    }
+                    w->red = xp->red;
+                    xp->red = false;
+                    w->right->red = false;
+                    rotate_left(xp);
+                    x = _root;
+                }
+            }
+            else{
+                node *w = xp->left;
+                if(is_red(w)){
+                    w->red = false;
+                    xp->red = true;
+                    rotate_right(xp);
+                    w = xp->left;
+                }
+                if(!is_red(w->left) && !is_red(w->right)){
+                    w->red = true;
+                    x = xp;
+                    xp = x->parent;
+                }
+                else{
+                    if(!is_red(w->left)){
+                        w->right->red = false;
+                        w->red = true;
+                        rotate_left(w);
+                        w = xp->left;
+                    }
+                    w->red = xp->red;
+                    xp->red = false;
+                    w->left->red = false;
+                    rotate_right(xp);
+                    x = _root;
+                }
+            }
+        }
+        if(x != nullptr)
+            x->red = false;
+    }
+
+    /**
+     * Cerca il nodo con il valore dato oppure la posizione in cui inserirlo
+     * 
+     * @param value valore da cercare
+     * @param parent ultimo nodo visitato, padre del nuovo nodo
+     * @param left true se il nuovo nodo va inserito come figlio sinistro
+     * 
+     * @return nodo con il valore cercato, nullptr se non presente
+    */
+    template <typename K>
+    node *find_position(const K &value, node *&parent, bool &left) const {
+        return find_position(value, parent, left, _root);
+    }
+
+    /**
+     * Come find_position, ma la discesa parte dal nodo start, il cui
+     * sottoalbero deve contenere la posizione di value
+    */
+    template <typename K>
+    node *find_position(const K &value, node *&parent, bool &left, node *start) const {
+        node *curr = start;
+        node *pred = nullptr; // ultimo nodo lasciato a sinistra del percorso
+        parent = start == nullptr ? nullptr : start->parent;
+        left = parent != nullptr && parent->left == start;
+
+        while(curr != nullptr){
+
+            int order = compare(value, curr->value);
+            if(order == 0)
+                return curr;
+
+            parent = curr;
+            left = order < 0;
+            if(left){
+                curr = curr->left;
+            }
+            else{
+                pred = curr;
+                curr = curr->right;
+            }
+
+        }
+
+        if(pred == nullptr && start != _root && parent != nullptr)
+            pred = const_cast<node *>(const_iterator::get_prev(parent));
+        return find_equivalent(value, pred, nullptr, bst_equal_from_order<C, E>());
+    }
+
+    /**
+     * Completa una discesa senza esito: i valori equivalenti per C ma
+     * diversi per E sono inseriti dopo quelli già presenti, ma le rotazioni
+     * dei bilanciamenti possono spostarli a sinistra del percorso. In ordine
+     * restano contigui e terminano subito prima della posizione trovata,
+     * quindi si scorrono all'indietro a partire da pred. Con l'uguaglianza
+     * ricavata dal confronto non ci sono valori del genere.
+     * 
+     * @param value valore cercato
+     * @param pred nodo che precede la posizione di value
+     * @param top radice del sottoalbero in cui cercare, nullptr per l'intero albero
+     * 
+     * @return nodo uguale a value, nullptr se non presente
+    */
+    template <typename K>
+    node *find_equivalent(const K &value, node *pred, const node *top, std::false_type) const {
+        while(pred != nullptr && !less(pred->value, value)){
+            if(_eql(pred->value, value))
+                return pred;
+            pred = const_cast<node *>(const_iterator::get_prev(pred, top));
+        }
+        return nullptr;
+    }
+
+    template <typename K>
+    node *find_equivalent(const K &, node *, const node *, std::true_type) const {
+        return nullptr;
+    }
+
+    /**
+     * Risale dal nodo f fino al primo nodo il cui sottoalbero contiene la
+     * posizione di value. Gli antenati che non limitano l'intervallo nella
+     * direzione di value si attraversano senza confronti; ci si ferma sul
+     * primo nodo il cui limite supera value, quindi per chiavi vicine al
+     * dito i confronti nella salita e nella discesa restano pochi.
+     * 
+     * @param f nodo di partenza (non nullo)
+     * @param value chiave cercata
+     * @param next primo nodo maggiore del sottoalbero ritornato quando
+     *             serve a lower_bound, altrimenti nullptr
+     * 
+     * @return radice del sottoalbero da cui scendere
+    */
+    template <typename K>
+    node *finger_climb(node *f, const K &value, node *&next) const {
+        node *x = f;
+        next = nullptr;
+
+        if(less(value, x->value)){
+            // limite inferiore: primo antenato di cui x sta a destra
+            for(;;){
+                node *c = x;
+                while(c->parent != nullptr && c == c->parent->left)
+                    c = c->parent;
+                node *bound = c->parent;
+                if(bound == nullptr || less(bound->value, value))
+                    break;
+                x = bound;
+                if(!less(value, x->value))
+                    break;
+            }
+        }
+        else if(less(x->value, value)){
+            // limite superiore: primo antenato di cui x sta a sinistra
+            for(;;){
+                node *c = x;
+                while(c->parent != nullptr && c == c->parent->right)
+                    c = c->parent;
+                node *bound = c->parent;
+                if(bound == nullptr || less(value, bound->value)){
+                    next = bound;
+                    break;
+                }
+                x = bound;
+                if(!less(x->value, value))
+                    break;
+            }
+        }
+        return x;
+    }
+
+    /**
+     * Come find_position, partendo dal nodo f invece che dalla radice
+     * 
+     * @param f nodo di partenza, nullptr per partire dalla radice
+    */
+    template <typename K>
+    node *finger_position(node *f, const K &value, node *&parent, bool &left) const {
+        if(f == nullptr)
+            return find_position(value, parent, left);
+
+        node *next;
+        return find_position(value, parent, left, finger_climb(f, value, next));
+    }
+
+    /**
+     * Come lower_bound_node sull'intero albero, partendo dal nodo f
+     * 
+     * @param f nodo di partenza, nullptr per partire dalla radice
+    */
+    template <typename K>
+    const node *finger_lower_bound(node *f, const K &value) const {
+        if(f == nullptr)
+            return lower_bound_node(_root, value);
+
+        node *next;
+        const node *n = lower_bound_node(finger_climb(f, value, next), value);
+        return n != nullptr ? n : next;
+    }
+
+    /**
+     * Collega un nodo isolato nella posizione trovata da find_position
+     * e ribilancia l'albero
+     * 
+     * @param n nodo da collegare
+     * @param parent padre del nodo
+     * @param left true se il nodo è figlio sinistro
+    */
+    void link_node(node *n, node *parent, bool left){
+        n->parent = parent;
+        n->left = nullptr;
+        n->right = nullptr;
+        static_cast<typename B::node_info &>(*n) = typename B::node_info();
+        static_cast<size_info &>(*n) = size_info();
+
+        if(parent == nullptr)
+            _root = n;
+        else if(left)
+            parent->left = n;
+        else
+            parent->right = n;
+
+        _size++;
+        add_count(parent, 1, has_order_statistics());
+        thread_insert(n, parent, left, has_threads());
+        rebalance_insert(n);
+    }
+
+    /**
+     * Scollega un nodo dall'albero senza distruggerlo e ribilancia l'albero.
+     * Se il nodo ha due figli il suo successore ne prende il posto, quindi
+     * nessun altro nodo cambia valore.
+     * 
+     * @param z nodo da scollegare
+    */
+    void unlink_node(node *z){
+        node *x; // nodo che prende il posto di quello tolto
+        node *xp; // padre di x
+        typename B::node_info removed = *z;
+
+        thread_erase(z, has_threads());
+
+        if(z->left == nullptr){
+            x = z->right;
+            xp = z->parent;
+            replace_child(z->parent, z, x);
+        }
+        else if(z->right == nullptr){
+            x = z->left;
+            xp = z->parent;
+            replace_child(z->parent, z, x);
+        }
+        else{
+            node *y = z->right;
+            while(y->left != nullptr)
+                y = y->left;
+
+            removed = *y;
+            x = y->right;
+
+            if(y->parent == z){
+                xp = y;
+            }
+            else{
+                xp = y->parent;
+                replace_child(y->parent, y, x);
+                y->right = z->right;
+                y->right->parent = y;
+            }
+
+            replace_child(z->parent, z, y);
+            y->left = z->left;
+            y->left->parent = y;
+            static_cast<typename B::node_info &>(*y) = *z;
+            static_cast<size_info &>(*y) = *z;
+        }
+
+        z->parent = nullptr;
+        z->left = nullptr;
+        z->right = nullptr;
+        _size--;
+        add_count(xp, -1, has_order_statistics());
+
+        rebalance_erase(x, xp, removed);
+    }
+
+    /**
+     * Nodo da cui parte una ricerca con suggerimento: il nodo dell'iteratore
+     * o, per end(), l'elemento massimo. L'iteratore di un altro albero o di
+     * una vista non è un suggerimento valido: la ricerca parte dalla radice.
+     * 
+     * @param hint nodo dell'iteratore
+     * @param top radice della vista dell'iteratore
+     * @param tree albero dell'iteratore
+     * 
+     * @return nodo di partenza, nullptr per partire dalla radice
+    */
+    node *hint_node(const node *hint, const node *top, const binary_search_tree *tree) const {
+        if(tree != this || top != nullptr)
+            return nullptr;
+        if(hint != nullptr)
+            return const_cast<node *>(hint);
+
+        node *n = _root;
+        while(n != nullptr && n->right != nullptr)
+            n = n->right;
+        return n;
+    }
+
+    /**
+     * Inserisce un valore se non è già presente, cercandone la posizione
+     * a partire dal nodo f
+     * 
+     * @param f nodo di partenza, nullptr per partire dalla radice
+     * @param value valore da inserire (copiato o spostato)
+     * 
+     * @return nodo inserito o già presente con lo stesso valore
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename V>
+    node *insert_near(node *f, V &&value){
+        node *parent;
+        bool left;
+
+        node *n = finger_position(f, value, parent, left);
+        if(n != nullptr){
+            accessed(n);
+            return n;
+        }
+
+        n = create_node(std::forward<V>(value));
+        link_node(n, parent, left);
+        return n;
+    }
+
+    /**
+     * Inserisce un valore se non è già presente.
+     * Il nodo viene allocato solo dopo aver verificato l'assenza del valore.
+     * 
+     * @param value valore da inserire (copiato o spostato)
+     * 
+     * @return true se il valore è stato inserito
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename V>
+    bool insert_value(V &&value){
+        node *parent;
+        bool left;
+
+        node *n = find_position(value, parent, left);
+        if(n != nullptr){
+            accessed(n);
+            return false;
+        }
+
+        link_node(create_node(std::forward<V>(value)), parent, left);
+        return true;
+    }
+
+public:
+    
+    /**
+     * Costruttore di default 
+    */
+    binary_search_tree(): _root(nullptr), _size(0) {}
+
+    /**
+     * Costruttore con allocatore
+     * 
+     * @param alloc allocatore da usare per i nodi
+    */
+    explicit binary_search_tree(const A &alloc): _root(nullptr), _size(0), _alloc(alloc) {}
+
+    /**
+     * Costruttore da una sequenza qualsiasi di valori.
+     * I valori vengono ordinati e privati dei duplicati, poi l'albero
+     * bilanciato è costruito in tempo lineare.
+     * 
+     * @param first inizio della sequenza
+     * @param last fine della sequenza
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename It>
+    binary_search_tree(It first, It last): binary_search_tree() {
+        assign(first, last);
+    }
+
+    /**
+     * Costruttore da una sequenza ordinata, eventualmente con duplicati
+     * consecutivi. Costo lineare e un solo confronto di uguaglianza per valore.
+     * 
+     * @param first inizio della sequenza
+     * @param last fine della sequenza
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename It>
+    binary_search_tree(sorted_range_t, It first, It last): binary_search_tree() {
+        assign(sorted_range, first, last);
+    }
+
+    /**
+     * Costruttore da una sequenza ordinata e senza duplicati.
+     * Costo lineare e nessun confronto.
+     * 
+     * @param first inizio della sequenza
+     * @param last fine della sequenza
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename It>
+    binary_search_tree(sorted_unique_range_t, It first, It last): binary_search_tree() {
+        assign(sorted_unique_range, first, last);
+    }
+
+    /**
+     * Costruttore di copia
+     * 
+     * @param other albero da copiare
+     * 
+     * @throw eccezione di copiatura dell'albero
+    */
+    binary_search_tree(const binary_search_tree &other)
+        : _root(nullptr), _size(0),
+          _alloc(node_traits::select_on_container_copy_construction(other._alloc)) {
+
+        try {
+            _root = copy_helper(other._root);
+            _size = other._size;
+            thread_tree(_root, has_threads());
+        }
+        catch(...) {
+            clear();
+            throw NoTreeCopiedException();
+        }
+
+    }
+
+    /**
+     * Costruttore di spostamento: prende i nodi di other senza copiarli.
+     * other resta vuoto.
+     * 
+     * @param other albero da spostare
+    */
+    binary_search_tree(binary_search_tree &&other)
+        : _root(other._root), _size(other._size),
+          _conf(other._conf), _eql(other._eql), _alloc(other._alloc) {
+        other._root = nullptr;
+        other._size = 0;
+    }
+
+    /**
+     * Operatore di assegnamento
+     * 
+     * @param other albero da copiare
+     * 
+     * @return reference a this
+     * 
+     * @throw eccezione di allocazione di memoria
+    */
+    binary_search_tree &operator=(const binary_search_tree &other) {
+        if(this != &other) {
+            binary_search_tree tmp(other);
+            std::swap(_root,tmp._root);
+            std::swap(_size,tmp._size);
+            std::swap(_alloc,tmp._alloc);
+        }
+        return *this;
+	}
+
+    /**
+     * Operatore di assegnamento per spostamento.
+     * I nodi di this vengono distrutti, quelli di other passano a this.
+     * 
+     * @param other albero da spostare
+     * 
+     * @return reference a this
+    */
+    binary_search_tree &operator=(binary_search_tree &&other) {
+        if(this != &other) {
+            binary_search_tree tmp(std::move(other));
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    /**
+     * Scambia il contenuto di due alberi in tempo costante
+     * 
+     * @param other albero da scambiare
+    */
+    void swap(binary_search_tree &other) {
+        std::swap(_root,other._root);
+        std::swap(_size,other._size);
+        std::swap(_conf,other._conf);
+        std::swap(_eql,other._eql);
+        std::swap(_alloc,other._alloc);
+    }
+
+    /**
+     * Distruttore
+    */
+    ~binary_search_tree(){
+        clear();
+    }
+
+    /**
+     * Cancella il contenuto dell'albero.
+     * Se T non ha distruttore e l'allocatore è un pool non condiviso,
+     * l'arena viene rilasciata in blocco senza visitare i nodi.
+    */
+    void clear(){
+        if(std::is_trivially_destructible<T>::value && release_arena(_alloc)){
+            _root = nullptr;
+            _size = 0;
+            return;
+        }
+        clear_helper(_root);
+        _root = nullptr;
+        _size = 0;
+    }
+
+    /**
+     * Sostituisce il contenuto dell'albero con i valori di una sequenza
+     * qualsiasi: i nodi sono allocati una volta, ordinati con un merge sort,
+     * privati dei duplicati e collegati in un albero perfettamente bilanciato.
+     * In caso di errore l'albero resta invariato.
+     * 
+     * @param first inizio della sequenza
+     * @param last fine della sequenza
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename It>
+    void assign(It first, It last){
+        binary_search_tree tmp(node_traits::select_on_container_copy_construction(_alloc));
+        std::size_t n;
+        node *list = tmp.make_list(first, last, false, n);
+
+        if(n > 0){
+            list = tmp.sort_list(list, n);
+            tmp.unique_list(list, n);
+        }
+        tmp.build_from_list(list, n);
+        swap(tmp);
+    }
+
+    /**
+     * Sostituisce il contenuto dell'albero con i valori di una sequenza
+     * ordinata in tempo lineare. I duplicati consecutivi sono scartati
+     * prima di allocare il nodo.
+     * 
+     * @param first inizio della sequenza
+     * @param last fine della sequenza
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename It>
+    void assign(sorted_range_t, It first, It last){
+        binary_search_tree tmp(node_traits::select_on_container_copy_construction(_alloc));
+        std::size_t n;
+        node *list = tmp.make_list(first, last, true, n);
+        tmp.build_from_list(list, n);
+        swap(tmp);
+    }
+
+    /**
+     * Sostituisce il contenuto dell'albero con i valori di una sequenza
+     * ordinata e senza duplicati, in tempo lineare e senza confronti.
+     * 
+     * @param first inizio della sequenza
+     * @param last fine della sequenza
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename It>
+    void assign(sorted_unique_range_t, It first, It last){
+        binary_search_tree tmp(node_traits::select_on_container_copy_construction(_alloc));
+        std::size_t n;
+        node *list = tmp.make_list(first, last, false, n);
+        tmp.build_from_list(list, n);
+        swap(tmp);
+    }
+
+    /**
+     * Scrive l'albero in formato binario: un'intestazione con la versione
+     * del formato, dimensione ed etichetta del tipo, ordine dei byte e
+     * numero di valori, poi i valori in ordine codificati
+     * con bst_serializer<T>, passati allo stream a blocchi da 64 KiB.
+     * 
+     * @param os stream di destinazione (aperto in modalità binaria)
+     * 
+     * @throw NoTreeSavedException se lo stream non accetta i dati
+    */
+    void save(std::ostream &os) const {
+        bst_binary_writer out(os);
+        bst_binary_header h = { { 'B', 'S', 'T', 'B' }, bst_binary_header::version,
+                                bst_serializer<T>::fixed_size, bst_serializer<T>::type_tag,
+                                bst_binary_header::native_order, _size };
+        h.write(out);
+
+        for(const node *n = const_iterator::leftmost(_root); n != nullptr; n = const_iterator::get_next(n))
+            bst_serializer<T>::write(out, n->value);
+        out.flush();
+    }
+
+    /**
+     * Sostituisce il contenuto dell'albero con quello scritto da save.
+     * I valori sono letti direttamente nei nodi, collegati in lista e
+     * trasformati in un albero bilanciato in tempo lineare: oltre ai nodi
+     * non serve altra memoria. Se i valori non risultano ordinati e
+     * distinti vengono ordinati come in assign. Lo stream non viene letto
+     * oltre la fine dell'albero. In caso di errore l'albero resta invariato.
+     * 
+     * @param is stream di origine (aperto in modalità binaria)
+     * 
+     * @throw NoTreeLoadedException se lo stream è troncato o non valido
+     * @throw eccezione sulla creazione del nodo
+    */
+    void load(std::istream &is){
+        bst_binary_reader in(is);
+        bst_binary_header h;
+        h.read(in, bst_serializer<T>::fixed_size, bst_serializer<T>::type_tag);
+
+        binary_search_tree tmp(node_traits::select_on_container_copy_construction(_alloc));
+        node *head = nullptr;
+        node *tail = nullptr;
+        bool sorted = true;
+        std::size_t n = 0;
+
+        try{
+            for(; n < h.count; ++n){
+                node *curr = tmp.create_node(bst_serializer<T>::read(in));
+                if(tail == nullptr){
+                    head = curr;
+                }
+                else{
+                    tail->right = curr;
+                    sorted = sorted && less(tail->value, curr->value);
+                }
+                tail = curr;
+            }
+        }
+        catch(...){
+            tmp.destroy_list(head);
+            throw;
+        }
+
+        if(!sorted){
+            head = tmp.sort_list(head, n);
+            tmp.unique_list(head, n);
+        }
+        tmp.build_from_list(head, n);
+        swap(tmp);
+    }
+
+    /**
+     * Ritorna una copia profonda dell'albero costruita in parallelo:
+     * i primi livelli sono copiati dal thread chiamante, i sottoalberi
+     * sottostanti sono clonati in modo indipendente dai thread di lavoro.
+     * Se l'allocatore non è std::allocator la copia è sequenziale, perché
+     * non è garantito che possa essere usato da più thread.
+     * 
+     * @param threads numero di thread (0 per usare quelli disponibili)
+     * 
+     * @return la copia dell'albero
+     * 
+     * @throw eccezione di copiatura dell'albero
+    */
+    binary_search_tree parallel_copy(unsigned int threads = 0) const {
+        if(threads == 0)
+            threads = std::thread::hardware_concurrency();
+
+        if(threads <= 1 || _root == nullptr ||
+           !std::is_same<node_allocator, std::allocator<node> >::value)
+            return binary_search_tree(*this);
+
+        // circa quattro rami per thread per distribuire il carico
+        unsigned int depth = 1;
+        while((1u << depth) < threads * 4 && depth < 16)
+            depth++;
+
+        binary_search_tree tmp(node_traits::select_on_container_copy_construction(_alloc));
+        std::unique_ptr<copy_task[]> tasks(new copy_task[1u << (depth + 1)]);
+        unsigned int count = 0;
+
+        try{
+            tmp._root = tmp.copy_top(_root, nullptr, depth - 1, tasks.get(), count);
+        }
+        catch(...){
+            throw NoTreeCopiedException();
+        }
+
+        std::atomic<unsigned int> next(0);
+        std::atomic<bool> failed(false);
+
+        // ogni thread prende il prossimo ramo libero e lo copia
+        auto worker = [&]() {
+            unsigned int i;
+            while(!failed.load() && (i = next.fetch_add(1)) < count){
+                try{
+                    node *c = tmp.copy_helper(tasks[i].src, tasks[i].parent);
+                    if(tasks[i].left)
+                        tasks[i].parent->left = c;
+                    else
+                        tasks[i].parent->right = c;
+                }
+                catch(...){
+                    failed.store(true);
+                }
+            }
+        };
+
+        std::unique_ptr<std::thread[]> pool(new std::thread[threads - 1]);
+        unsigned int started = 0;
+        try{
+            for(; started < threads - 1; ++started)
+                pool[started] = std::thread(worker);
+        }
+        catch(...){
+            // si prosegue con i thread avviati
+        }
+        worker();
+        for(unsigned int i = 0; i < started; ++i)
+            pool[i].join();
+
+        if(failed.load()){
+            tmp.clear();
+            throw NoTreeCopiedException();
+        }
+
+        tmp._size = _size;
+        tmp.thread_tree(tmp._root, has_threads());
+        return tmp;
+    }
+
+    /**
+     * Chiama f su tutti i valori dell'albero dividendo il lavoro per
+     * sottoalberi tra più thread. L'ordine delle chiamate non è definito e
+     * chiamate diverse possono avvenire in parallelo.
+     *
+     * @param f funtore chiamato con ogni valore
+     * @param threads numero di thread (0 per usare quelli disponibili)
+     *
+     * @throw la prima eccezione lanciata da f
+    */
+    template <typename Fn>
+    void parallel_for_each(Fn f, unsigned int threads = 0) const {
+        std::vector<visit_piece> pieces;
+        threads = split_visit(threads, pieces);
+
+        auto work = [&](std::size_t i) {
+            visit_in_order(pieces[i], f);
+        };
+        bst_work_stealing::run(pieces.size(), threads, work);
+    }
+
+    /**
+     * Combina in parallelo tutti i valori dell'albero con un'operazione
+     * associativa. Ogni sottoalbero viene ridotto da un thread e i
+     * risultati parziali sono combinati in ordine di chiave, quindi il
+     * risultato è quello di init op x1 op x2 ... anche se op non è
+     * commutativa.
+     *
+     * @param init valore iniziale
+     * @param op operazione associativa R op(R, R); i valori sono convertiti in R
+     * @param threads numero di thread (0 per usare quelli disponibili)
+     *
+     * @return il risultato della riduzione
+     *
+     * @throw la prima eccezione lanciata da op
+    */
+    template <typename R, typename Op>
+    R parallel_reduce(R init, Op op, unsigned int threads = 0) const {
+        std::vector<visit_piece> pieces;
+        threads = split_visit(threads, pieces);
+
+        std::vector<R> partial(pieces.size(), init);
+        std::vector<char> used(pieces.size(), 0);
+
+        auto work = [&](std::size_t i) {
+            bool first = true;
+            R acc(init);
+            auto fold = [&](const T &value) {
+                acc = first ? R(value) : op(acc, R(value));
+                first = false;
+            };
+            visit_in_order(pieces[i], fold);
+            partial[i] = acc;
+            used[i] = !first;
+        };
+        bst_work_stealing::run(pieces.size(), threads, work);
+
+        for(std::size_t i = 0; i < pieces.size(); ++i){
+            if(used[i])
+                init = op(init, partial[i]);
+        }
+        return init;
+    }
+
+    /**
+     * Conta in parallelo i valori che soddisfano un predicato
+     *
+     * @param pred predicato, chiamato in parallelo
+     * @param threads numero di thread (0 per usare quelli disponibili)
+     *
+     * @return numero di valori che soddisfano il predicato
+     *
+     * @throw la prima eccezione lanciata da pred
+    */
+    template <typename P>
+    std::size_t parallel_count_if(P pred, unsigned int threads = 0) const {
+        std::vector<visit_piece> pieces;
+        threads = split_visit(threads, pieces);
+
+        std::vector<std::size_t> counts(pieces.size(), 0);
+        auto work = [&](std::size_t i) {
+            std::size_t c = 0;
+            auto count = [&](const T &value) {
+                if(pred(value))
+                    c++;
+            };
+            visit_in_order(pieces[i], count);
+            counts[i] = c;
+        };
+        bst_work_stealing::run(pieces.size(), threads, work);
+
+        std::size_t total = 0;
+        for(std::size_t i = 0; i < counts.size(); ++i)
+            total += counts[i];
+        return total;
+    }
+
+    /**
+     * Copia in out, in ordine di chiave, i valori che soddisfano un
+     * predicato. Il predicato è valutato in parallelo; la scrittura su out
+     * avviene nel thread chiamante dopo la valutazione.
+     *
+     * @param out iteratore di output
+     * @param pred predicato, chiamato in parallelo
+     * @param threads numero di thread (0 per usare quelli disponibili)
+     *
+     * @return l'iteratore di output dopo l'ultimo valore scritto
+     *
+     * @throw la prima eccezione lanciata da pred
+    */
+    template <typename O, typename P>
+    O parallel_copy_if(O out, P pred, unsigned int threads = 0) const {
+        std::vector<visit_piece> pieces;
+        threads = split_visit(threads, pieces);
+
+        std::vector<std::vector<const T*> > hits(pieces.size());
+        auto work = [&](std::size_t i) {
+            std::vector<const T*> &h = hits[i];
+            auto select = [&](const T &value) {
+                if(pred(value))
+                    h.push_back(&value);
+            };
+            visit_in_order(pieces[i], select);
+        };
+        bst_work_stealing::run(pieces.size(), threads, work);
+
+        for(std::size_t i = 0; i < hits.size(); ++i){
+            for(std::size_t j = 0; j < hits[i].size(); ++j)
+                *out++ = *hits[i][j];
+        }
+        return out;
+    }
+
+    /**
+     * Ritorna una copia dell'allocatore usato dall'albero
+     * 
+     * @return allocatore
+    */
+    A get_allocator() const {
+        return A(_alloc);
+    }
+
+    /**
+     * Ritorna il numero di elementi nell'albero
+     * 
+     * @return numero di elementi presenti nell'albero
+    */
+    std::size_t size() const {
+        return _size;
+    }
+
+    /**
+     * Ritorna l'altezza dell'albero, cioè il numero di nodi del percorso
+     * più lungo dalla radice a una foglia. La visita usa i puntatori al padre
+     * e non la ricorsione, quindi funziona anche su alberi degeneri.
+     * 
+     * @return altezza dell'albero (0 se vuoto)
+    */
+    unsigned int height() const {
+        unsigned int h = 0;
+        unsigned int depth = 0;
+        const node *prev = nullptr;
+        const node *curr = _root;
+
+        while(curr != nullptr){
+            const node *next;
+
+            if(prev == curr->parent){
+                // arrivo dal padre: scendo a sinistra, poi a destra
+                depth++;
+                if(depth > h)
+                    h = depth;
+                if(curr->left != nullptr)
+                    next = curr->left;
+                else if(curr->right != nullptr)
+                    next = curr->right;
+                else
+                    next = curr->parent;
+            }
+            else if(prev == curr->left && curr->right != nullptr){
+                // arrivo dal figlio sinistro: scendo a destra
+                next = curr->right;
+            }
+            else{
+                next = curr->parent;
+            }
+
+            if(next == curr->parent)
+                depth--;
+            prev = curr;
+            curr = next;
+        }
+
+        return h;
+    }
+
+    /**
+     * Determina se esiste un determinato elemento nell'albero.
+     * L'uguaglianza e il confronto sono definiti mediante i relativi funtori.
+     * 
+     * @param value valore da cercare
+     * 
+     * @return true se esiste l'elemento, false altrimenti
+    */
+    bool contains(const T &value) const {
+        return find_accessed(value) != nullptr;
+    }
+
+    /**
+     * Determina se esiste un elemento uguale alla chiave, senza costruire
+     * un valore di tipo T. Disponibile se C ed E dichiarano is_transparent.
+     * 
+     * @param key chiave confrontabile con T
+     * 
+     * @return true se esiste l'elemento, false altrimenti
+    */
+    template <typename K>
+    typename bst_enable_transparent<C,E,K,bool>::type contains(const K &key) const {
+        return find_accessed(key) != nullptr;
+    }
+
+    /**
+     * Restituisce un determinato sottoalbero dell'albero principale.
+     * L'uguaglianza e il confronto sono definiti mediante i relativi funtori.
+     * 
+     * @param value valore che sarà radice del sottoalbero
+     * 
+     * @return il sottoalbero ricercato
+     * 
+     * @throw eccezione di copiatura dell'albero
+    */
+    binary_search_tree subtree(const T &value) const {
+        return subtree_key(value);
+    }
+
+    /**
+     * Restituisce il sottoalbero radicato nell'elemento uguale alla chiave.
+     * Disponibile se C ed E dichiarano is_transparent.
+     * 
+     * @param key chiave confrontabile con T
+     * 
+     * @return il sottoalbero ricercato
+     * 
+     * @throw eccezione di copiatura dell'albero
+    */
+    template <typename K>
+    typename bst_enable_transparent<C,E,K,binary_search_tree>::type subtree(const K &key) const {
+        return subtree_key(key);
+    }
+
+    /**
+     * Ritorna il numero di elementi minori di value, cioè la posizione
+     * (da 0) che value ha o avrebbe nell'ordinamento. Costo O(log n).
+     * Richiede bst_order_statistics.
+     * 
+     * @param value valore di cui calcolare la posizione
+     * 
+     * @return numero di elementi minori di value
+    */
+    std::size_t rank(const T &value) const {
+        static_assert(has_order_statistics::value, "rank richiede bst_order_statistics");
+        return count_less(value, false);
+    }
+
+    /**
+     * Ritorna il numero di elementi minori della chiave.
+     * Disponibile se C ed E dichiarano is_transparent.
+     * 
+     * @param key chiave confrontabile con T
+    */
+    template <typename K>
+    typename bst_enable_transparent<C,E,K,std::size_t>::type rank(const K &key) const {
+        static_assert(has_order_statistics::value, "rank richiede bst_order_statistics");
+        return count_less(key, false);
+    }
+
+    /**
+     * Ritorna il numero di elementi compresi nell'intervallo chiuso [lo, hi]
+     * in O(log n). Richiede bst_order_statistics.
+     * 
+     * @param lo estremo inferiore
+     * @param hi estremo superiore
+     * 
+     * @return numero di elementi x con lo <= x <= hi
+    */
+    std::size_t count_range(const T &lo, const T &hi) const {
+        static_assert(has_order_statistics::value, "count_range richiede bst_order_statistics");
+        if(less(hi, lo))
+            return 0;
+        return count_less(hi, true) - count_less(lo, false);
+    }
+
+    /**
+     * Ritorna il numero di elementi compresi nell'intervallo chiuso [lo, hi]
+     * di chiavi. Disponibile se C ed E dichiarano is_transparent.
+     * 
+     * @param lo estremo inferiore
+     * @param hi estremo superiore
+    */
+    template <typename K>
+    typename bst_enable_transparent<C,E,K,std::size_t>::type count_range(const K &lo, const K &hi) const {
+        static_assert(has_order_statistics::value, "count_range richiede bst_order_statistics");
+        // le chiavi non sono confrontate tra loro: con hi < lo gli elementi
+        // non maggiori di hi sono un sottoinsieme di quelli minori di lo
+        std::size_t below = count_less(lo, false);
+        std::size_t upto = count_less(hi, true);
+        return upto > below ? upto - below : 0;
+    }
+
+    /**
+     * Inserisce un elemento nell'albero nella posizione opportuna.
+     * I confronti necessari sono eseguiti mediante il funtore di confronto.
+     * Il nodo viene allocato solo se l'elemento non è già presente.
+     * 
+     * @param value valore da inserire
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    void add(const T& value){
+        insert_value(value);
+    }
+
+    /**
+     * Inserisce un elemento nell'albero spostandolo nel nuovo nodo.
+     * 
+     * @param value valore da inserire
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    void add(T&& value){
+        insert_value(std::move(value));
+    }
+
+    /**
+     * Costruisce un elemento a partire dagli argomenti e lo inserisce.
+     * L'elemento è costruito sullo stack per il confronto e spostato nel
+     * nodo solo se non è già presente, quindi un duplicato non alloca nodi.
+     * 
+     * @param args argomenti del costruttore di T
+     * 
+     * @return true se l'elemento è stato inserito
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    template <typename... Args>
+    bool emplace(Args&&... args){
+        T value(std::forward<Args>(args)...);
+        return insert_value(std::move(value));
+    }
+
+    /**
+     * Nodo estratto da un albero. Possiede il nodo e lo distrugge se non
+     * viene reinserito in un albero.
+     * 
+     * @brief Nodo estratto dall'albero
+    */
+    class node_type {
+
+    private:
+        node *_n; // nodo posseduto
+        node_allocator _alloc; // allocatore che ha creato il nodo
+
+        friend class binary_search_tree;
+
+        node_type(node *n, const node_allocator &alloc) : _n(n), _alloc(alloc) {}
+
+        node_type(const node_type &);
+        node_type &operator=(const node_type &);
+
+        void reset(){
+            if(_n != nullptr){
+                node_traits::destroy(_alloc, _n);
+                node_traits::deallocate(_alloc, _n, 1);
+                _n = nullptr;
+            }
+        }
+
+    public:
+        node_type() : _n(nullptr) {}
+
+        node_type(node_type &&other) : _n(other._n), _alloc(other._alloc) {
+            other._n = nullptr;
+        }
+
+        node_type &operator=(node_type &&other) {
+            if(this != &other){
+                reset();
+                _n = other._n;
+                _alloc = other._alloc;
+                other._n = nullptr;
+            }
+            return *this;
+        }
+
+        ~node_type() {
+            reset();
+        }
+
+        /**
+         * Ritorna true se non possiede alcun nodo
+        */
+        bool empty() const {
+            return _n == nullptr;
+        }
+
+        /**
+         * Ritorna il dato contenuto nel nodo
+        */
+        T &value() const {
+            return _n->value;
+        }
+
+    };
+
+    /**
+     * Estrae dall'albero il nodo con il valore dato senza deallocarlo.
+     * L'albero viene ribilanciato secondo la politica scelta.
+     * 
+     * @param value valore da estrarre
+     * 
+     * @return nodo estratto, vuoto se il valore non è presente
+    */
+    node_type extract(const T &value){
+        node *parent;
+        bool left;
+        node *n = find_position(value, parent, left);
+
+        if(n == nullptr)
+            return node_type();
+
+        unlink_node(n);
+        return node_type(n, _alloc);
+    }
+
+    /**
+     * Inserisce un nodo estratto da un albero con allocatore compatibile,
+     * senza riallocarlo. Se il valore è già presente il nodo resta in nh.
+     * 
+     * @param nh nodo da inserire
+     * 
+     * @return true se il nodo è stato inserito
+     * 
+     * @throw eccezione sull'allocatore non compatibile
+    */
+    bool insert(node_type &&nh){
+        if(nh.empty())
+            return false;
+
+        if(!(nh._alloc == _alloc))
+            throw IncompatibleAllocatorException();
+
+        node *parent;
+        bool left;
+        if(find_position(nh._n->value, parent, left) != nullptr)
+            return false;
+
+        link_node(nh._n, parent, left);
+        nh._n = nullptr;
+        return true;
+    }
+
+    /**
+     * Iteratore costante bidirezionale dell'albero
+     * 
+     * @brief Iteratore costante dell'albero 
+    */
+    class const_iterator{
+
+    private:
+        const node *_n;
+        const node *_top; // radice del sottoalbero visitato, nullptr per l'intero albero
+        const binary_search_tree *_tree; // albero visitato, per decrementare end()
+
+        friend class binary_search_tree; 
+ 
+        /**
+         * Costruttore privato di inizializzazione 
+         * 
+         * Usato dalla classe container tipicamente nei metodi begin e end
+         * 
+         * @param n nodo riferito
+         * @param top radice del sottoalbero oltre la quale la visita si ferma
+         * @param tree albero visitato
+        */
+        const_iterator(const node *n, const node *top, const binary_search_tree *tree) : _n(n), _top(top), _tree(tree) { }
+
+        /**
+         * Restituisce il successivo nodo tramite l'ordinamento scelto,
+         * senza uscire dal sottoalbero radicato in top
+        */
+        static const node* get_next(const node *n, const node *top = nullptr){
+            return get_next(n, top, has_threads());
+        }
+
+        /**
+         * Successore tramite i collegamenti in ordine, in un solo accesso.
+         * Le viste su un sottoalbero risalgono i padri per non uscirne.
+        */
+        static const node* get_next(const node *n, const node *top, std::true_type){
+            if(top == nullptr)
+                return n->next;
+            return get_next(n, top, std::false_type());
+        }
+
+        /**
+         * Successore tramite i puntatori ai figli e al padre
+        */
+        static const node* get_next(const node *n, const node *top, std::false_type){
+
+			// se posso andare a destra ci vado. e poi tutto a sinistra.
+            if(n->right != nullptr){
+                n = n->right;
+                while(n->left != nullptr){
+                    n = n->left;
+                }
+
+                return n;
+            }
+
+            // altrimenti 
+            while(true){
+                if(n == top || n->parent == nullptr){
+                    n = nullptr;
+                    return n;
+                }
+                if(n->parent->left == n){
+                    n = n->parent;
+                    return n;
+                }
+                n = n->parent;
+            }
+
+            return n;
+        }
+
+        /**
+         * Restituisce il precedente nodo tramite l'ordinamento scelto,
+         * senza uscire dal sottoalbero radicato in top
+        */
+        static const node* get_prev(const node *n, const node *top = nullptr){
+            return get_prev(n, top, has_threads());
+        }
+
+        static const node* get_prev(const node *n, const node *top, std::true_type){
+            if(top == nullptr)
+                return n->prev;
+            return get_prev(n, top, std::false_type());
+        }
+
+        static const node* get_prev(const node *n, const node *top, std::false_type){
+
+            // se posso andare a sinistra ci vado. e poi tutto a destra.
+            if(n->left != nullptr){
+                n = n->left;
+                while(n->right != nullptr){
+                    n = n->right;
+                }
+
+                return n;
+            }
+
+            while(true){
+                if(n == top || n->parent == nullptr){
+                    return nullptr;
+                }
+                if(n->parent->right == n){
+                    return n->parent;
+                }
+                n = n->parent;
+            }
+        }
+
+        /**
+         * Ritorna il primo nodo del sottoalbero radicato in n
+        */
+        static const node* leftmost(const node *n){
+            if(n != nullptr){
+                while(n->left != nullptr)
+                    n = n->left;
+            }
+            return n;
+        }
+
+        /**
+         * Ritorna l'ultimo nodo del sottoalbero visitato
+        */
+        const node* last() const {
+            const node *n = (_top != nullptr) ? _top : _tree->_root;
+            if(n != nullptr){
+                while(n->right != nullptr)
+                    n = n->right;
+            }
+            return n;
+        }
+
+        /**
+         * Avanza di k posizioni con il successore, un passo alla volta
+        */
+        static const node* advance(const node *n, const node *top, std::ptrdiff_t k, std::false_type){
+            for(; n != nullptr && k > 0; --k)
+                n = get_next(n, top);
+            return n;
+        }
+
+        /**
+         * Arretra di k posizioni con il predecessore, un passo alla volta
+        */
+        static const node* retreat(const node *n, const node *top, std::ptrdiff_t k, std::false_type){
+            for(; n != nullptr && k > 0; --k)
+                n = get_prev(n, top);
+            return n;
+        }
+
+        /**
+         * Arretra di k posizioni usando le dimensioni dei sottoalberi,
+         * in modo simmetrico ad advance
+        */
+        static const node* retreat(const node *n, const node *top, std::ptrdiff_t k, std::true_type){
+            std::size_t steps = (std::size_t) k;
+
+            while(n != nullptr && steps > 0){
+                std::size_t l = count_of(n->left);
+                if(steps <= l)
+                    return select_node(n->left, l - steps);
+
+                steps -= l;
+                while(n != top && n->parent != nullptr && n->parent->left == n)
+                    n = n->parent;
+                n = (n == top) ? nullptr : n->parent;
+                steps--;
+            }
+            return n;
+        }
+
+        /**
+         * Avanza di k posizioni usando le dimensioni dei sottoalberi:
+         * se il k-esimo successivo è nel sottoalbero destro ci si scende,
+         * altrimenti si salta il sottoalbero destro e si risale al primo
+         * antenato di cui n sta a sinistra.
+        */
+        static const node* advance(const node *n, const node *top, std::ptrdiff_t k, std::true_type){
+            std::size_t steps = (std::size_t) k;
+
+            while(n != nullptr && steps > 0){
+                std::size_t r = count_of(n->right);
+                if(steps <= r)
+                    return select_node(n->right, steps - 1);
+
+                steps -= r;
+                while(n != top && n->parent != nullptr && n->parent->right == n)
+                    n = n->parent;
+                n = (n == top) ? nullptr : n->parent;
+                steps--;
+            }
+            return n;
+        }
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T                         value_type;
+        typedef ptrdiff_t                 difference_type;
+        typedef const T*                  pointer;
+        typedef const T&                  reference;
+
+        const_iterator() : _n(nullptr), _top(nullptr), _tree(nullptr) {}
+
+        const_iterator(const const_iterator &other) : _n(other._n), _top(other._top), _tree(other._tree) {}
+
+        const_iterator& operator=(const const_iterator &other) {
+			_n = other._n;
+			_top = other._top;
+			_tree = other._tree;
+			return *this;
+		}
+
+        ~const_iterator() {}
+
+        /**
+         * Ritorna il dato riferito dall'iteratore (dereferenziamento)
+        */ 
+        reference operator*() const {
+            return _n->value;
+        }
+
+        /**
+         * Ritorna il puntatore al dato riferito dall'iteratore
+        */
+        pointer operator->() const {
+            return &(_n->value);
+        }
+
+        /**
+         * Operatore di iterazione post-incremento
+        */
+        const_iterator operator++(int) {
+			const_iterator tmp(*this);
+			
+            _n = get_next(_n, _top);
+
+            return tmp;
+
+        }
+
+        /**
+         * Operatore di iterazione pre-incremento
+        */
+        const_iterator& operator++() {
+            
+            _n = get_next(_n, _top);
+
+			return *this;
+
+        }
+
+        /**
+         * Operatore di iterazione post-decremento
+        */
+        const_iterator operator--(int) {
+            const_iterator tmp(*this);
+            --(*this);
+            return tmp;
+        }
 
         /**
-         * Costruttore di default
+         * Operatore di iterazione pre-decremento.
+         * Decrementare end() porta all'ultimo elemento.
         */
-        node(): parent(nullptr), left(nullptr), right(nullptr) {}
+        const_iterator& operator--() {
+            if(_n == nullptr)
+                _n = last();
+            else
+                _n = get_prev(_n, _top);
+            return *this;
+        }
 
         /**
-         * Costruttore secondario che inizializza il nodo
+         * Sposta l'iteratore di k posizioni (indietro se k è negativo).
+         * Costo O(log n) se l'albero memorizza le dimensioni dei sottoalberi
+         * (bst_order_statistics), O(|k|) altrimenti.
+         * Oltre l'ultimo elemento l'iteratore diventa end().
          * 
-         * @param v valore del dato
+         * @param k numero di posizioni
         */
-        node(const T &v): value(v), parent(nullptr), left(nullptr), right(nullptr) {}
-        
+        const_iterator& operator+=(difference_type k) {
+            if(k >= 0){
+                _n = advance(_n, _top, k, has_order_statistics());
+            }
+            else if(_n == nullptr){
+                _n = retreat(last(), _top, -k - 1, has_order_statistics());
+            }
+            else{
+                _n = retreat(_n, _top, -k, has_order_statistics());
+            }
+            return *this;
+        }
+
         /**
-         * Costruttore secondario che inizializza il nodo
+         * Sposta l'iteratore indietro di k posizioni
          * 
-         * @param v valore del dato
-         * @param p puntatore al padre
-         * @param n1 puntatore al figlio sinistro
-         * @param n2 puntatore al figlio destro
+         * @param k numero di posizioni
         */
-        node(const T &v, node *p, node *n1, node *n2): value(v), parent(n1), left(n1), right(n2) {}
+        const_iterator& operator-=(difference_type k) {
+            return *this += -k;
+        }
 
         /**
-         * Distruttore
+         * Ritorna un iteratore spostato indietro di k posizioni
+         * 
+         * @param k numero di posizioni
         */
-        ~node() {
-            parent = nullptr;
-            left = nullptr;
-            right = nullptr;
+        const_iterator operator-(difference_type k) const {
+            const_iterator tmp(*this);
+            tmp -= k;
+            return tmp;
         }
 
-    };
-
-    node *_root; // puntatore alla radice dell'albero
-    unsigned int _size; // numero di nodi nell'albero 
+        /**
+         * Ritorna un iteratore avanzato di k posizioni
+         * 
+         * @param k numero di posizioni
+        */
+        const_iterator operator+(difference_type k) const {
+            const_iterator tmp(*this);
+            tmp += k;
+            return tmp;
+        }
 
-    C _conf; // oggetto funtore per il confronto
-    E _eql; // oggetto funtore per l'uguaglianza
+        /**
+         * Uguaglianza
+        */
+        bool operator==(const const_iterator &other) const {
+            return (_n == other._n);
+        }
 
-    /**
-     * Funzione helper per la rimozione ricorsiva dei nodi
-     * 
-     * @param n nodo da rimuovere
-    */
-    void clear_helper(node *n){
-        if(n != nullptr){
-            clear_helper(n->left);
-            clear_helper(n->right);
-            delete n;
-            _size--;
-            n = nullptr;
+        /**
+         * Diversità
+        */
+        bool operator!=(const const_iterator &other) const {
+            return (_n != other._n);
         }
-    }
 
+    };
+    
     /**
-     * Funzione helper per la copia ricorsiva dei nodi
-     * 
-     * @param to_copy nodo da copiare
-     * @param parent padre del nodo copia 
+     * Ritorna l'iteratore all'inizio della sequenza dati
      * 
-     * @throw eccezione sulla creazione del nodo
+     * @return iteratore all'inizio della sequenza
     */
-    node * copy_helper(const node *to_copy, node *parent = nullptr) const{
-
-        if(to_copy == nullptr){
-            return nullptr;
-        }
+    const_iterator begin() const {
+        const node *curr;
         
-        node *copy;
-        try{
-            copy = new node(to_copy->value);
+        curr = _root;
+        if(curr == nullptr){
+            return const_iterator(curr, nullptr, this);
         }
-        catch(...){
-            throw NoNodeCreatedException();
+
+        while(curr->left != nullptr){
+            curr = curr->left;
         }
-              
-        copy->parent = parent;
-        copy->left  = copy_helper(to_copy->left, copy);
-        copy->right = copy_helper(to_copy->right, copy);
 
-        return copy;        
+        return const_iterator(curr, nullptr, this);
     }
 
     /**
-     * Funzione helper per la conta ricorsiva dei nodi
+     * Ritorna l'iteratore alla fine della sequenza dati
      * 
-     * @param to_count nodo da usare come radice nella conta
+     * @return iteratore alla fine della sequenza
     */
-    int count_helper(const node *to_count) const{
-
-        if(to_count == nullptr){
-            return 0;
-        }
-        
-        int l = count_helper(to_count->left);
-        int r = count_helper(to_count->right);
+    const_iterator end() const {
+        return const_iterator(nullptr, nullptr, this);
+    }
 
-        return l + r + 1;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
+    /**
+     * Ritorna l'iteratore all'inizio della sequenza dati in ordine inverso
+     * 
+     * @return iteratore all'ultimo elemento
+    */
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
     }
 
-public:
-    
     /**
-     * Costruttore di default 
+     * Ritorna l'iteratore alla fine della sequenza dati in ordine inverso
+     * 
+     * @return iteratore prima del primo elemento
     */
-    binary_search_tree(): _root(nullptr), _size(0) {}
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
 
     /**
-     * Costruttore di copia
+     * Cerca un elemento nell'albero in O(altezza).
+     * L'uguaglianza e il confronto sono definiti mediante i relativi funtori.
      * 
-     * @param other albero da copiare
+     * @param value valore da cercare
      * 
-     * @throw eccezione di copiatura dell'albero
+     * @return iteratore all'elemento, end() se non presente
     */
-    binary_search_tree(const binary_search_tree &other) : _root(nullptr), _size(0) {
-
-        try {
-            _root = copy_helper(other._root);
-            _size = other._size;
-        }
-        catch(...) {
-            clear();
-            throw NoTreeCopiedException();
-        }
-
+    const_iterator find(const T &value) const {
+        return const_iterator(find_accessed(value), nullptr, this);
     }
 
     /**
-     * Operatore di assegnamento
+     * Cerca l'elemento uguale alla chiave senza costruire un valore di
+     * tipo T. Disponibile se C ed E dichiarano is_transparent; i funtori
+     * sono chiamati come C(K, T), C(T, K) ed E(T, K).
      * 
-     * @param other albero da copiare
+     * @param key chiave confrontabile con T
      * 
-     * @return reference a this
+     * @return iteratore all'elemento, end() se non presente
+    */
+    template <typename K>
+    typename bst_enable_transparent<C,E,K,const_iterator>::type find(const K &key) const {
+        return const_iterator(find_accessed(key), nullptr, this);
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento non minore di value.
+     * Usa solo il funtore di confronto, una volta per livello.
      * 
-     * @throw eccezione di allocazione di memoria
+     * @param value valore da cercare
+     * 
+     * @return iteratore al primo elemento x con !(x < value)
     */
-    binary_search_tree &operator=(const binary_search_tree &other) {
-        if(this != &other) {
-            binary_search_tree tmp(other);
-            std::swap(_root,tmp._root);
-            std::swap(_size,tmp._size);
-        }
-        return *this;
-	}
+    const_iterator lower_bound(const T &value) const {
+        return const_iterator(lower_bound_node(_root, value), nullptr, this);
+    }
 
     /**
-     * Distruttore
+     * Ritorna l'iteratore al primo elemento non minore della chiave.
+     * Disponibile se C ed E dichiarano is_transparent.
+     * 
+     * @param key chiave confrontabile con T
     */
-    ~binary_search_tree(){
-        clear();
+    template <typename K>
+    typename bst_enable_transparent<C,E,K,const_iterator>::type lower_bound(const K &key) const {
+        return const_iterator(lower_bound_node(_root, key), nullptr, this);
     }
 
     /**
-     * Cancella il contenuto dell'albero
+     * Ritorna l'iteratore al primo elemento maggiore di value.
+     * Usa solo il funtore di confronto, una volta per livello.
+     * 
+     * @param value valore da cercare
+     * 
+     * @return iteratore al primo elemento x con value < x
     */
-    void clear(){
-        clear_helper(_root);
-        _root = nullptr;
+    const_iterator upper_bound(const T &value) const {
+        return const_iterator(upper_bound_node(_root, value), nullptr, this);
     }
 
     /**
-     * Ritorna il numero di elementi nell'albero
+     * Ritorna l'iteratore al primo elemento maggiore della chiave.
+     * Disponibile se C ed E dichiarano is_transparent.
      * 
-     * @return numero di elementi presenti nell'albero
+     * @param key chiave confrontabile con T
     */
-    unsigned int size() const {
-        return _size;
+    template <typename K>
+    typename bst_enable_transparent<C,E,K,const_iterator>::type upper_bound(const K &key) const {
+        return const_iterator(upper_bound_node(_root, key), nullptr, this);
     }
 
     /**
-     * Determina se esiste un determinato elemento nell'albero.
-     * L'uguaglianza e il confronto sono definiti mediante i relativi funtori.
+     * Ritorna l'intervallo degli elementi equivalenti a value
      * 
      * @param value valore da cercare
      * 
-     * @return true se esiste l'elemento, false altrimenti
+     * @return coppia (lower_bound(value), upper_bound(value))
     */
-    bool find(const T &value) const {
-        const node *curr = _root;
-
-        while(curr != nullptr){
+    std::pair<const_iterator, const_iterator> equal_range(const T &value) const {
+        return std::make_pair(lower_bound(value), upper_bound(value));
+    }
 
-            if(_eql(curr->value, value))
-                return true;
-            
-            if(_conf(value, curr->value)) 
-                curr = curr->left;
-            else
-                curr = curr->right;
+    /**
+     * Ritorna l'intervallo degli elementi equivalenti alla chiave.
+     * Disponibile se C ed E dichiarano is_transparent.
+     * 
+     * @param key chiave confrontabile con T
+    */
+    template <typename K>
+    typename bst_enable_transparent<C,E,K,std::pair<const_iterator, const_iterator> >::type
+    equal_range(const K &key) const {
+        return std::make_pair(lower_bound(key), upper_bound(key));
+    }
 
-        }
-        return false;
+    /**
+     * Inserisce un elemento cercandone la posizione a partire da hint
+     * invece che dalla radice: si risale con i collegamenti al padre solo
+     * finché il valore resta fuori dal sottoalbero, poi si scende. Per
+     * inserimenti quasi ordinati, passando ogni volta l'iteratore ritornato
+     * dall'inserimento precedente, il costo dipende dalla distanza d dal
+     * suggerimento (O(log d) in media) invece che da log n. Con end() la
+     * ricerca parte dall'elemento massimo; con un iteratore di un altro
+     * albero o di una vista parte dalla radice.
+     * 
+     * @param hint iteratore di questo albero vicino alla posizione del valore
+     * @param value valore da inserire
+     * 
+     * @return iteratore all'elemento inserito o già presente
+     * 
+     * @throw eccezione sulla creazione del nodo
+    */
+    const_iterator add(const_iterator hint, const T &value){
+        return const_iterator(insert_near(hint_node(hint._n, hint._top, hint._tree), value), nullptr, this);
     }
 
     /**
-     * Restituisce un determinato sottoalbero dell'albero principale.
-     * L'uguaglianza e il confronto sono definiti mediante i relativi funtori.
+     * Inserisce un elemento spostandolo, partendo dalla posizione hint
      * 
-     * @param value valore che sarà radice del sottoalbero
+     * @param hint iteratore di questo albero vicino alla posizione del valore
+     * @param value valore da inserire
      * 
-     * @return il sottoalbero ricercato
+     * @return iteratore all'elemento inserito o già presente
      * 
-     * @throw eccezione di copiatura dell'albero
+     * @throw eccezione sulla creazione del nodo
     */
-    binary_search_tree subtree(const T &value) const {
-        node *curr = _root;
-        binary_search_tree<T,C,E> tmp;
+    const_iterator add(const_iterator hint, T &&value){
+        return const_iterator(insert_near(hint_node(hint._n, hint._top, hint._tree), std::move(value)), nullptr, this);
+    }
 
-        while(curr != nullptr){
+    /**
+     * Dito per ricerche con località: ricorda l'ultimo nodo visitato e ogni
+     * operazione parte da lì, risalendo verso la radice solo quanto serve.
+     * Se le chiavi cercate sono vicine tra loro (blocchi quasi ordinati,
+     * finestre scorrevoli) il costo dipende dalla distanza d dalla chiave
+     * precedente, O(log d) in media, invece che da log n.
+     * 
+     * Il dito resta valido dopo inserimenti e rimozioni di altri elementi,
+     * perché i nodi non cambiano valore; non è più valido se viene rimosso
+     * il suo elemento o se l'albero viene svuotato.
+     * 
+     * @brief Dito per ricerche vicine
+    */
+    class finger_type {
 
-            if(_eql(curr->value, value)){
+    private:
+        binary_search_tree *_tree; // albero visitato
+        node *_n; // ultimo nodo visitato, nullptr per partire dalla radice
 
-                try{
-                    tmp._root = copy_helper(curr);
-                    tmp._size = count_helper(curr);
-                }
-                catch(...){
-                    tmp.clear();
-                    throw NoTreeCopiedException();
-                }
+        friend class binary_search_tree;
 
-                return tmp;
+        explicit finger_type(binary_search_tree *tree) : _tree(tree), _n(nullptr) {}
 
-            }
-            
-            if(_conf(value, curr->value)) 
-                curr = curr->left;
-            else
-                curr = curr->right;
+    public:
 
+        /**
+         * Cerca un elemento partendo dall'ultima posizione. Il dito si
+         * sposta sull'elemento trovato o sull'ultimo nodo visitato.
+         * 
+         * @param value valore da cercare
+         * 
+         * @return iteratore all'elemento, end() se non presente
+        */
+        const_iterator find(const T &value){
+            node *parent;
+            bool left;
+            node *n = _tree->finger_position(_n, value, parent, left);
+            _n = n != nullptr ? n : parent;
+            _tree->accessed(_n);
+            return const_iterator(n, nullptr, _tree);
         }
 
-        return tmp;
-    }
+        /**
+         * Determina se esiste un elemento, partendo dall'ultima posizione
+         * 
+         * @param value valore da cercare
+         * 
+         * @return true se esiste l'elemento, false altrimenti
+        */
+        bool contains(const T &value){
+            return find(value) != _tree->end();
+        }
 
-    /**
-     * Inserisce un elemento nell'albero nella posizione opportuna.
-     * I confronti necessari sono eseguiti mediante il funtore di confronto.
-     * 
-     * @param value valore da inserire
-     * 
-     * @throw eccezione sulla creazione del nodo
-    */
-    void add(const T& value){
-        
-        node *tmp;
-        try{
-            tmp = new node(value);
+        /**
+         * Ritorna l'iteratore al primo elemento non minore di value,
+         * partendo dall'ultima posizione, e vi sposta il dito
+         * 
+         * @param value valore da cercare
+         * 
+         * @return iteratore al primo elemento x con !(x < value)
+        */
+        const_iterator lower_bound(const T &value){
+            const node *n = _tree->finger_lower_bound(_n, value);
+            if(n != nullptr)
+                _n = const_cast<node *>(n);
+            return const_iterator(n, nullptr, _tree);
         }
-        catch(...){
-            throw NoNodeCreatedException();
+
+        /**
+         * Inserisce un elemento partendo dall'ultima posizione e vi sposta
+         * il dito
+         * 
+         * @param value valore da inserire
+         * 
+         * @return iteratore all'elemento inserito o già presente
+         * 
+         * @throw eccezione sulla creazione del nodo
+        */
+        const_iterator add(const T &value){
+            _n = _tree->insert_near(_n, value);
+            return const_iterator(_n, nullptr, _tree);
         }
 
-        if(_root == nullptr){
-            _root = tmp;
-            _size++;
-            return;
+        /**
+         * Ritorna l'iteratore all'ultima posizione, end() se il dito non è
+         * ancora stato usato
+        */
+        const_iterator position() const {
+            return const_iterator(_n, nullptr, _tree);
         }
 
-        node *prec = _root;
-        node *curr = _root;
-        
-        while(curr != nullptr){
+    };
 
-            if(_eql(curr->value, value)){
-                delete tmp;
-                return;
-            }
-            
-            prec = curr;
-            if(_conf(value, curr->value))
-                curr = curr->left;
-            else
-                curr = curr->right;
+    /**
+     * Ritorna un dito per ricerche e inserimenti vicini. Il primo uso
+     * parte dalla radice.
+     * 
+     * @return dito sull'albero
+    */
+    finger_type finger(){
+        return finger_type(this);
+    }
 
-        }
-        
-        tmp->parent = prec;
+    typedef bst_interval<T,C> interval_type;
+
+    /**
+     * Scrive in out, in ordine, i valori che soddisfano il predicato.
+     * Se il predicato dichiara limiti monotoni (below e above, come
+     * interval_type o bst_query) la visita parte dal primo valore non
+     * below e si ferma al primo above, quindi costa O(log n + k) con k
+     * valori nell'intervallo; altrimenti visita tutto l'albero.
+     *
+     * @param pred predicato, eventualmente con limiti monotoni
+     * @param out iteratore di output (es. std::ostream_iterator)
+     *
+     * @return l'iteratore di output dopo l'ultimo valore scritto
+    */
+    template <typename P, typename O>
+    O query_if(const P &pred, O out) const {
+        return query_if(pred, out, bst_has_bounds<P, T>());
+    }
+
+    typedef frozen_binary_search_tree<T,C,E,B,A,F> frozen_type;
+
+    /**
+     * Ritorna una copia immutabile dell'albero in un array contiguo in
+     * ordine di Eytzinger, per ricerche ripetute senza seguire puntatori.
+     * Richiede frozen_bstree.h; con thaw() si torna a un albero modificabile.
+     * 
+     * @return albero congelato
+     * 
+     * @throw eccezione di copiatura dell'albero
+    */
+    frozen_type freeze() const {
+        return frozen_type(*this);
+    }
 
-        if(_conf(value, prec->value))
-            prec->left = tmp;
-        else
-            prec->right = tmp;
+    typedef mapped_binary_search_tree<T,C,E,B,A,F> image_type;
 
-        _size++;
+    /**
+     * Scrive l'immagine dell'albero su file: i nodi hanno figli a distanze
+     * relative e il file si può mappare in memoria con open_image senza
+     * ricostruire l'albero. Richiede mapped_bstree.h e un tipo banalmente
+     * copiabile.
+     * 
+     * @param path percorso del file
+     * 
+     * @throw NoTreeSavedException se il file non può essere scritto
+    */
+    void save_image(const char *path) const {
+        image_type::save(*this, path);
+    }
 
+    /**
+     * Mappa in memoria un'immagine scritta da save_image. L'apertura legge
+     * e verifica solo l'intestazione, in tempo costante; i nodi sono
+     * caricati dal sistema operativo alla prima visita.
+     * 
+     * @param path percorso del file
+     * 
+     * @return albero in sola lettura
+     * 
+     * @throw NoTreeLoadedException se il file manca o non è valido
+    */
+    static image_type open_image(const char *path) {
+        return image_type(path);
     }
 
     /**
-     * Iteratore costante dell'albero
+     * Vista non proprietaria di un sottoalbero. Non copia e non alloca nodi:
+     * la visita parte dal nodo radice della vista e si ferma al confine del
+     * sottoalbero. La vista non è più valida dopo una modifica dell'albero.
      * 
-     * @brief Iteratore costante dell'albero 
+     * @brief Vista su un sottoalbero
     */
-    class const_iterator{
+    class view_type {
 
     private:
-        const node *_n;
+        const binary_search_tree *_tree; // albero di appartenenza
+        const node *_top; // radice del sottoalbero, nullptr se vuoto
 
-        friend class binary_search_tree; 
- 
-        /**
-         * Costruttore privato di inizializzazione 
-         * 
-         * Usato dalla classe container tipicamente nei metodi begin e end
-        */
-        const_iterator(const node *n) : _n(n) { }
+        friend class binary_search_tree;
+
+        view_type(const binary_search_tree *tree, const node *top) : _tree(tree), _top(top) {}
+
+    public:
+        view_type() : _tree(nullptr), _top(nullptr) {}
 
         /**
-         * Restituisce il successivo nodo tramite l'ordinamento scelto
+         * Ritorna l'iteratore al primo elemento del sottoalbero
         */
-        const node* get_next(const node *n){
+        const_iterator begin() const {
+            const node *curr = _top;
+            if(curr == nullptr)
+                return end();
 
-			// se posso andare a destra ci vado. e poi tutto a sinistra.
-            if(n->right != nullptr){
-                n = n->right;
-                while(n->left != nullptr){
-                    n = n->left;
-                }
+            while(curr->left != nullptr)
+                curr = curr->left;
 
-                return n;
-            }
+            return const_iterator(curr, _top, _tree);
+        }
 
-            // altrimenti 
-            while(true){
-                if(n->parent == nullptr){
-                    n = nullptr;
-                    return n;
-                }
-                if(n->parent->left == n){
-                    n = n->parent;
-                    return n;
-                }
-                n = n->parent;
-            }
+        /**
+         * Ritorna l'iteratore alla fine del sottoalbero
+        */
+        const_iterator end() const {
+            return const_iterator(nullptr, _top, _tree);
+        }
 
-            return n;
+        /**
+         * Ritorna l'iteratore all'ultimo elemento del sottoalbero in ordine inverso
+        */
+        const_reverse_iterator rbegin() const {
+            return const_reverse_iterator(end());
         }
 
-    public:
-        typedef std::forward_iterator_tag iterator_category;
-        typedef T                         value_type;
-        typedef ptrdiff_t                 difference_type;
-        typedef const T*                  pointer;
-        typedef const T&                  reference;
+        /**
+         * Ritorna l'iteratore alla fine del sottoalbero in ordine inverso
+        */
+        const_reverse_iterator rend() const {
+            return const_reverse_iterator(begin());
+        }
 
-        const_iterator() : _n(nullptr) {}
+        /**
+         * Cerca il valore nel sottoalbero, scendendo dalla radice della vista
+         * 
+         * @param value valore da cercare
+         * 
+         * @return iteratore all'elemento, end() se non presente
+        */
+        const_iterator find(const T &value) const {
+            return find_key(value);
+        }
 
-        const_iterator(const const_iterator &other) : _n(other._n) {}
+        /**
+         * Cerca la chiave nel sottoalbero senza costruire un valore di tipo T.
+         * Disponibile se C ed E dichiarano is_transparent.
+        */
+        template <typename K>
+        typename bst_enable_transparent<C,E,K,const_iterator>::type find(const K &key) const {
+            return find_key(key);
+        }
 
-        const_iterator& operator=(const const_iterator &other) {
-			_n = other._n;
-			return *this;
-		}
+        /**
+         * Determina se il valore appartiene al sottoalbero
+         * 
+         * @param value valore da cercare
+         * 
+         * @return true se esiste l'elemento, false altrimenti
+        */
+        bool contains(const T &value) const {
+            return find(value) != end();
+        }
 
-        ~const_iterator() {}
+        /**
+         * Determina se la chiave appartiene al sottoalbero.
+         * Disponibile se C ed E dichiarano is_transparent.
+        */
+        template <typename K>
+        typename bst_enable_transparent<C,E,K,bool>::type contains(const K &key) const {
+            return find_key(key) != end();
+        }
 
         /**
-         * Ritorna il dato riferito dall'iteratore (dereferenziamento)
-        */ 
-        reference operator*() const {
-            return _n->value;
+         * Ritorna l'iteratore al primo elemento del sottoalbero non minore di value
+        */
+        const_iterator lower_bound(const T &value) const {
+            return const_iterator(_tree->lower_bound_node(_top, value), _top, _tree);
+        }
+
+        template <typename K>
+        typename bst_enable_transparent<C,E,K,const_iterator>::type lower_bound(const K &key) const {
+            return const_iterator(_tree->lower_bound_node(_top, key), _top, _tree);
         }
 
         /**
-         * Ritorna il puntatore al dato riferito dall'iteratore
+         * Ritorna l'iteratore al primo elemento del sottoalbero maggiore di value
         */
-        pointer operator->() const {
-            return &(_n->value);
+        const_iterator upper_bound(const T &value) const {
+            return const_iterator(_tree->upper_bound_node(_top, value), _top, _tree);
         }
 
+        template <typename K>
+        typename bst_enable_transparent<C,E,K,const_iterator>::type upper_bound(const K &key) const {
+            return const_iterator(_tree->upper_bound_node(_top, key), _top, _tree);
+        }
+
+    private:
+
         /**
-         * Operatore di iterazione post-incremento
+         * Scende dalla radice della vista cercando value
         */
-        const_iterator operator++(int) {
-			const_iterator tmp(*this);
-			
-            _n = get_next(_n);
+        template <typename K>
+        const_iterator find_key(const K &value) const {
+            const node *curr = _top;
+            const node *pred = nullptr;
 
-            return tmp;
+            while(curr != nullptr){
+                int order = _tree->compare(value, curr->value);
+                if(order == 0)
+                    return const_iterator(curr, _top, _tree);
+
+                if(order < 0){
+                    curr = curr->left;
+                }
+                else{
+                    pred = curr;
+                    curr = curr->right;
+                }
+            }
 
+            curr = _tree->find_equivalent(value, const_cast<node *>(pred), _top, bst_equal_from_order<C, E>());
+            return curr != nullptr ? const_iterator(curr, _top, _tree) : end();
         }
 
+    public:
+
         /**
-         * Operatore di iterazione pre-incremento
+         * Ritorna il numero di elementi del sottoalbero.
+         * Costo costante con bst_order_statistics, lineare altrimenti.
         */
-        const_iterator& operator++() {
-            
-            _n = get_next(_n);
-
-			return *this;
+        std::size_t size() const {
+            return count_of(_top);
+        }
 
+        /**
+         * Ritorna true se la vista non contiene elementi
+        */
+        bool empty() const {
+            return _top == nullptr;
         }
 
         /**
-         * Uguaglianza
+         * Overload dell'operatore di stream << per una vista
         */
-        bool operator==(const const_iterator &other) const {
-            return (_n == other._n);
+        friend std::ostream &operator<<(std::ostream &os, const view_type &view) {
+            for(const_iterator i = view.begin(), ie = view.end(); i != ie; ++i)
+                os << *i << " ";
+            return os;
         }
 
         /**
-         * Diversità
+         * Stampa a schermo i valori della vista che soddisfano un predicato
+         * 
+         * @param view vista sul sottoalbero
+         * @param pred predicato
         */
-        bool operator!=(const const_iterator &other) const {
-            return (_n != other._n);
+        template <typename P>
+        friend void printIF(const view_type &view, P pred) {
+            for(const_iterator i = view.begin(), ie = view.end(); i != ie; ++i) {
+                if(pred(*i))
+                    std::cout << *i << std::endl;
+            }
         }
 
     };
-    
+
     /**
-     * Ritorna l'iteratore all'inizio della sequenza dati
+     * Ritorna una vista sul sottoalbero radicato nel nodo con il valore dato,
+     * senza copiarlo. Costo O(altezza) e nessuna allocazione.
      * 
-     * @return iteratore all'inizio della sequenza
+     * @param value valore che sarà radice del sottoalbero
+     * 
+     * @return la vista, vuota se il valore non è presente
     */
-    const_iterator begin() const {
-        const node *curr;
-        
-        curr = _root;
-        if(curr == nullptr){
-            return const_iterator(curr);
+    view_type subtree_view(const T &value) const {
+        node *parent;
+        bool left;
+        return view_type(this, find_position(value, parent, left));
+    }
+
+    /**
+     * Ritorna una vista sul sottoalbero radicato nell'elemento uguale alla
+     * chiave. Disponibile se C ed E dichiarano is_transparent.
+     * 
+     * @param key chiave confrontabile con T
+    */
+    template <typename K>
+    typename bst_enable_transparent<C,E,K,view_type>::type subtree_view(const K &key) const {
+        node *parent;
+        bool left;
+        return view_type(this, find_position(key, parent, left));
+    }
+
+    /**
+     * Ritorna l'iteratore al k-esimo elemento più piccolo (da 0) in O(log n).
+     * Richiede bst_order_statistics.
+     * 
+     * @param k posizione dell'elemento
+     * 
+     * @return iteratore all'elemento, end() se k >= size()
+    */
+    const_iterator select(std::size_t k) const {
+        static_assert(has_order_statistics::value, "select richiede bst_order_statistics");
+        if(k >= _size)
+            return end();
+        return const_iterator(select_node(_root, k), nullptr, this);
+    }
+
+    /**
+     * Rimuove dall'albero l'elemento con il valore dato.
+     * L'albero viene ribilanciato secondo la politica scelta.
+     * 
+     * @param value valore da rimuovere
+     * 
+     * @return numero di elementi rimossi (0 o 1)
+    */
+    std::size_t erase(const T &value){
+        node *parent;
+        bool left;
+        node *n = find_position(value, parent, left);
+
+        if(n == nullptr)
+            return 0;
+
+        unlink_node(n);
+        destroy_node(n);
+        return 1;
+    }
+
+    /**
+     * Rimuove l'elemento riferito dall'iteratore.
+     * Gli iteratori agli altri elementi restano validi.
+     * 
+     * @param pos iteratore a un elemento dell'albero
+     * 
+     * @return iteratore all'elemento successivo
+    */
+    const_iterator erase(const_iterator pos){
+        node *n = const_cast<node *>(pos._n);
+        const_iterator next(const_iterator::get_next(n), nullptr, this);
+
+        unlink_node(n);
+        destroy_node(n);
+        return next;
+    }
+
+    /**
+     * Rimuove gli elementi nell'intervallo [first, last).
+     * Se gli elementi sono pochi rispetto all'albero vengono rimossi uno a uno,
+     * altrimenti l'albero viene ricostruito bilanciato con i nodi rimasti
+     * senza nuove allocazioni: il costo è O(min(k log n, n)).
+     * 
+     * @param first primo elemento da rimuovere
+     * @param last elemento successivo all'ultimo da rimuovere
+     * 
+     * @return last
+    */
+    const_iterator erase(const_iterator first, const_iterator last){
+        std::size_t k = 0;
+        std::size_t log_n = 1;
+        for(std::size_t n = _size; n > 1; n >>= 1)
+            log_n++;
+
+        // conta gli elementi fino a quando conviene la ricostruzione
+        const_iterator i = first;
+        for(; i != last && k * log_n <= _size; ++i)
+            k++;
+
+        if(i == last){
+            while(first != last)
+                first = erase(first);
+            return last;
         }
 
-        while(curr->left != nullptr){
-            curr = curr->left;
+        const node *from = first._n;
+        const node *to = last._n;
+        bool inside = false;
+        rebuild_erasing([&](const node *n) -> bool {
+            if(n == from)
+                inside = true;
+            if(n == to)
+                inside = false;
+            return inside;
+        });
+        return last;
+    }
+
+    /**
+     * Rimuove tutti gli elementi che soddisfano il predicato.
+     * L'albero viene visitato una volta e ricostruito bilanciato con i nodi
+     * rimasti, senza nuove allocazioni.
+     * 
+     * @param pred predicato sul valore
+     * 
+     * @return numero di elementi rimossi
+     * 
+     * @throw eccezione lanciata da pred: nessun elemento viene rimosso e
+     *        l'albero è ricostruito bilanciato con tutti i valori
+    */
+    template <typename P>
+    std::size_t erase_if(P pred){
+        return rebuild_erasing([&](const node *n) -> bool {
+            return pred(n->value);
+        });
+    }
+
+private:
+
+    template <typename P, typename O>
+    O query_if(const P &pred, O out, std::false_type) const {
+        for(const node *n = const_iterator::leftmost(_root); n != nullptr; n = const_iterator::get_next(n)){
+            if(pred(n->value))
+                *out++ = n->value;
+        }
+        return out;
+    }
+
+    template <typename P, typename O>
+    O query_if(const P &pred, O out, std::true_type) const {
+        // primo nodo non below: come lower_bound, perché below è monotono
+        const node *first = nullptr;
+        for(const node *n = _root; n != nullptr; ){
+            if(pred.below(n->value)){
+                n = n->right;
+            }
+            else{
+                first = n;
+                n = n->left;
+            }
         }
 
-        return const_iterator(curr);
+        for(const node *n = first; n != nullptr && !pred.above(n->value); n = const_iterator::get_next(n)){
+            if(pred(n->value))
+                *out++ = n->value;
+        }
+        return out;
     }
 
     /**
-     * Ritorna l'iteratore alla fine della sequenza dati
+     * Visita l'albero in ordine, distrugge i nodi per cui remove è vero e
+     * ricostruisce un albero bilanciato con i nodi rimasti.
+     * I nodi visitati sono messi in una lista in ordine tramite il figlio
+     * destro e quelli da rimuovere sono segnati facendo puntare il figlio
+     * sinistro a sé stessi: la visita legge solo i collegamenti dei nodi non
+     * ancora visitati e dei padri. Se remove lancia un'eccezione i nodi
+     * restanti vengono aggiunti alla lista e l'albero è ricostruito con
+     * tutti i valori prima di rilanciarla.
      * 
-     * @return iteratore alla fine della sequenza
+     * @param remove funzione che indica se rimuovere un nodo
+     * 
+     * @return numero di nodi rimossi
+     * 
+     * @throw eccezione lanciata da remove, con l'albero invariato nei valori
     */
-    const_iterator end() const {
-        return const_iterator(nullptr);
+    template <typename R>
+    std::size_t rebuild_erasing(R remove){
+        node *all = nullptr; // nodi visitati, in ordine
+        node **tail = &all;
 
-        const node *curr;
-        
-        curr = _root;
-        if(curr == nullptr){
-            return const_iterator(curr);
+        const node *curr = begin()._n;
+        try{
+            while(curr != nullptr){
+                node *m = const_cast<node *>(curr);
+                bool drop = remove(m);
+                curr = const_iterator::get_next(curr);
+
+                m->left = drop ? m : nullptr;
+                *tail = m;
+                tail = &m->right;
+            }
+        }
+        catch(...){
+            while(curr != nullptr){
+                node *m = const_cast<node *>(curr);
+                curr = const_iterator::get_next(curr);
+
+                m->left = nullptr;
+                *tail = m;
+                tail = &m->right;
+            }
+            *tail = nullptr;
+            build_from_list(all, _size);
+            throw;
         }
+        *tail = nullptr;
+
+        node *kept = nullptr;
+        node **kept_tail = &kept;
+        node *removed = nullptr;
+        std::size_t n = 0;
+        std::size_t r = 0;
 
-        while(curr->right != nullptr){
-            curr = curr->right;
+        while(all != nullptr){
+            node *m = all;
+            all = m->right;
+
+            if(m->left == m){
+                m->right = removed;
+                removed = m;
+                r++;
+            }
+            else{
+                *kept_tail = m;
+                kept_tail = &m->right;
+                n++;
+            }
         }
+        *kept_tail = nullptr;
 
-        return const_iterator(curr);
+        destroy_list(removed);
+        build_from_list(kept, n);
+        return r;
     }
-    
 
 };
 
+/**
+ * Scambia il contenuto di due alberi in tempo costante
+ * 
+ * @param a primo albero
+ * @param b secondo albero
+*/
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F>
+void swap(binary_search_tree<T,C,E,B,A,F> &a, binary_search_tree<T,C,E,B,A,F> &b) {
+    a.swap(b);
+}
+
 /**
  * Overload dell'operatore di stream << per un binary_search_tree
  * 
@@ -517,13 +4399,16 @@ public:
  * @param T tipo del dato
  * @param C funtore di comparazione
  * @param E funtore di uguaglianza
+ * @param B politica di bilanciamento
+ * @param A allocatore
+ * @param F funzionalità opzionali
  * 
  * @return puntatore allo stream
 */
-template <typename T, typename C, typename E>
-std::ostream &operator<<(std::ostream &os, const binary_search_tree<T,C,E> &bstree) {
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F>
+std::ostream &operator<<(std::ostream &os, const binary_search_tree<T,C,E,B,A,F> &bstree) {
 
-    typename binary_search_tree<T,C,E>::const_iterator i,ie;
+    typename binary_search_tree<T,C,E,B,A,F>::const_iterator i,ie;
 
     i = bstree.begin();
     ie = bstree.end();
@@ -536,6 +4421,37 @@ std::ostream &operator<<(std::ostream &os, const binary_search_tree<T,C,E> &bstr
     return os;
 }
 
+/**
+ * Legge un albero scritto con binary_search_tree::save, in tempo lineare.
+ * In caso di errore imposta failbit e, come gli altri operatori >>, lancia
+ * l'eccezione di load solo se is.exceptions() comprende failbit.
+ * 
+ * @brief Operatore >>
+ * 
+ * @param is stream di origine (aperto in modalità binaria)
+ * @param bstree albero da sostituire
+ * 
+ * @return lo stream
+*/
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F>
+std::istream &operator>>(std::istream &is, binary_search_tree<T,C,E,B,A,F> &bstree) {
+    try {
+        bstree.load(is);
+    }
+    catch(...) {
+        bool rethrow = (is.exceptions() & std::ios::failbit) != 0;
+        try {
+            is.setstate(std::ios::failbit);
+        }
+        catch(const std::ios_base::failure &) {
+            // si rilancia l'eccezione originale
+        }
+        if(rethrow)
+            throw;
+    }
+    return is;
+}
+
 /**
  * Funzione globale printIF.
  * Stampa a schermo l'elenco dei valori dell'albero che soddisfano un predicato.
@@ -546,24 +4462,103 @@ std::ostream &operator<<(std::ostream &os, const binary_search_tree<T,C,E> &bstr
  * @param C funtore di comparazione
  * @param E funtore di uguaglianza
  * @param P funtore del predicato 
+ * @param B politica di bilanciamento
+ * @param A allocatore
+ * @param F funzionalità opzionali
+ * @param bstree albero di tipo T
+ * @param pred predicato
+*/
+template <typename T, typename C, typename E, typename P, typename B, typename A, unsigned int F>
+void printIF(const binary_search_tree<T,C,E,B,A,F> &bstree, P pred) {
+    printIF(bstree, pred, std::cout);
+}
+
+/**
+ * Scrive su uno stream l'elenco dei valori dell'albero che soddisfano un
+ * predicato, uno per riga. Se il predicato dichiara limiti monotoni (es.
+ * binary_search_tree::interval_type o bst_query) i sottoalberi fuori
+ * dall'intervallo non vengono visitati.
+ *
+ * @brief Scrive i valori dell'albero che soddisfano un predicato.
+ *
  * @param bstree albero di tipo T
  * @param pred predicato
+ * @param os stream di output
 */
-template <typename T, typename C, typename E, typename P>
-void printIF(const binary_search_tree<T,C,E> &bstree, P pred) {
+template <typename T, typename C, typename E, typename P, typename B, typename A, unsigned int F>
+void printIF(const binary_search_tree<T,C,E,B,A,F> &bstree, P pred, std::ostream &os) {
+    bstree.query_if(pred, std::ostream_iterator<T>(os, "\n"));
+}
 
-    typename binary_search_tree<T,C,E>::const_iterator i,ie;
+/**
+ * Chiama f su tutti i valori dell'albero in parallelo
+ *
+ * @param bstree albero
+ * @param f funtore chiamato con ogni valore
+ * @param threads numero di thread (0 per usare quelli disponibili)
+*/
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F, typename Fn>
+void parallel_for_each(const binary_search_tree<T,C,E,B,A,F> &bstree, Fn f, unsigned int threads = 0) {
+    bstree.parallel_for_each(f, threads);
+}
 
-	i = bstree.begin();
-	ie = bstree.end();
-	
-	while(i!=ie) {
-		if(pred(*i)) {
-			std::cout << *i << std::endl;
-		}
-		++i;
-	}
+/**
+ * Combina in parallelo i valori dell'albero con un'operazione associativa
+ *
+ * @param bstree albero
+ * @param init valore iniziale
+ * @param op operazione associativa
+ * @param threads numero di thread (0 per usare quelli disponibili)
+ *
+ * @return il risultato della riduzione, in ordine di chiave
+*/
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F, typename R, typename Op>
+R parallel_reduce(const binary_search_tree<T,C,E,B,A,F> &bstree, R init, Op op, unsigned int threads = 0) {
+    return bstree.parallel_reduce(init, op, threads);
+}
+
+/**
+ * Conta in parallelo i valori che soddisfano un predicato
+ *
+ * @param bstree albero
+ * @param pred predicato
+ * @param threads numero di thread (0 per usare quelli disponibili)
+ *
+ * @return numero di valori che soddisfano il predicato
+*/
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F, typename P>
+std::size_t parallel_count_if(const binary_search_tree<T,C,E,B,A,F> &bstree, P pred, unsigned int threads = 0) {
+    return bstree.parallel_count_if(pred, threads);
+}
+
+/**
+ * Copia in ordine i valori che soddisfano un predicato valutandolo in parallelo
+ *
+ * @param bstree albero
+ * @param out iteratore di output
+ * @param pred predicato
+ * @param threads numero di thread (0 per usare quelli disponibili)
+ *
+ * @return l'iteratore di output dopo l'ultimo valore scritto
+*/
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F, typename O, typename P>
+O parallel_copy_if(const binary_search_tree<T,C,E,B,A,F> &bstree, O out, P pred, unsigned int threads = 0) {
+    return bstree.parallel_copy_if(out, pred, threads);
+}
 
+/**
+ * Versione parallela di printIF: il predicato è valutato in parallelo e
+ * i valori sono stampati in ordine di chiave, come in printIF.
+ *
+ * @brief Stampa in parallelo i valori dell'albero che soddisfano un predicato.
+ *
+ * @param bstree albero di tipo T
+ * @param pred predicato
+ * @param threads numero di thread (0 per usare quelli disponibili)
+*/
+template <typename T, typename C, typename E, typename P, typename B, typename A, unsigned int F>
+void parallel_printIF(const binary_search_tree<T,C,E,B,A,F> &bstree, P pred, unsigned int threads = 0) {
+    bstree.parallel_copy_if(std::ostream_iterator<T>(std::cout, "\n"), pred, threads);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,697 @@
+#ifndef COMPACT_BSTREE_H
+#define COMPACT_BSTREE_H
+
+#include <cassert>
+#include <ostream>
+#include <iostream>
+#include <iterator> // std::forward_iterator_tag
+#include <cstddef>  // std::ptrdiff_t, std::size_t
+#include <cstdint>  // std::uint8_t, std::uint32_t
+#include <type_traits> // std::true_type
+#include <utility>  // std::move, std::swap
+#include <vector>   // std::vector
+#include "bstree.h"
+
+/**
+ * Albero AVL con i nodi in un unico vettore contiguo, collegati da indici
+ * a 32 bit invece che da puntatori. Il nodo non ha il collegamento al
+ * padre: inserimenti e rimozioni ricordano il percorso in uno stack e gli
+ * iteratori tengono lo stack degli antenati. Per un albero di int il nodo
+ * occupa 16 byte (valore, due indici e l'altezza) contro i 40 circa del
+ * nodo con tre puntatori, e copiare l'albero significa copiare il vettore.
+ *
+ * Il vettore resta denso: la rimozione sposta l'ultimo nodo nel posto
+ * liberato. Ogni inserimento o rimozione invalida gli iteratori: le
+ * rotazioni cambiano gli antenati dei nodi e lo stack salvato
+ * nell'iteratore non corrisponde più all'albero.
+ * L'albero contiene al più 2^32 - 2 elementi. Valori equivalenti per C
+ * ma diversi per E sono ammessi: se una ricerca arriva accanto a valori
+ * equivalenti, li scorre tutti prima di concludere che il valore manca.
+ *
+ * @brief Albero AVL compatto con indici a 32 bit
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+*/
+template <typename T, typename C, typename E>
+class compact_binary_search_tree {
+
+    typedef std::uint32_t index; // posizione di un nodo nel vettore
+
+    static const index nil = 0xffffffffu; // figlio assente
+
+    /**
+     * Altezza massima di un albero AVL con meno di 2^32 nodi, con margine
+    */
+    enum { max_height = 64 };
+
+    /**
+     * Nodo dell'albero
+     *
+     * @brief Nodo dell'albero
+    */
+    struct node {
+        T value; // valore del dato
+        index left; // figlio sinistro, nil se assente
+        index right; // figlio destro, nil se assente
+        std::uint8_t height; // altezza del sottoalbero radicato nel nodo
+
+        explicit node(const T &v): value(v), left(nil), right(nil), height(1) {}
+    };
+
+    std::vector<node> _nodes; // nodi dell'albero, senza posti liberi
+    index _root; // radice, nil se vuoto
+
+    C _conf; // oggetto funtore per il confronto
+    E _eql; // oggetto funtore per l'uguaglianza
+
+    /**
+     * Confronta una chiave con il valore di un nodo: 0 se sono uguali,
+     * negativo se la discesa prosegue a sinistra, positivo altrimenti
+    */
+    int compare(const T &value, const T &node_value) const {
+        return compare(value, node_value, bst_equal_from_order<C, E>());
+    }
+
+    int compare(const T &value, const T &node_value, std::true_type) const {
+        return bst_order(_conf, value, node_value);
+    }
+
+    int compare(const T &value, const T &node_value, std::false_type) const {
+        if(_eql(node_value, value))
+            return 0;
+        return bst_less(_conf, value, node_value) ? -1 : 1;
+    }
+
+    int height_of(index i) const {
+        return i == nil ? 0 : _nodes[i].height;
+    }
+
+    void update(index i) {
+        int l = height_of(_nodes[i].left);
+        int r = height_of(_nodes[i].right);
+        _nodes[i].height = (std::uint8_t)(1 + (l > r ? l : r));
+    }
+
+    index rotate_right(index x) {
+        index y = _nodes[x].left;
+        _nodes[x].left = _nodes[y].right;
+        update(x);
+        _nodes[y].right = x;
+        update(y);
+        return y;
+    }
+
+    index rotate_left(index x) {
+        index y = _nodes[x].right;
+        _nodes[x].right = _nodes[y].left;
+        update(x);
+        _nodes[y].left = x;
+        update(y);
+        return y;
+    }
+
+    /**
+     * Ribilancia il nodo i
+     *
+     * @return nuova radice del sottoalbero
+    */
+    index balance(index i) {
+        update(i);
+        int bal = height_of(_nodes[i].left) - height_of(_nodes[i].right);
+
+        if(bal > 1) {
+            index l = _nodes[i].left;
+            if(height_of(_nodes[l].left) < height_of(_nodes[l].right))
+                _nodes[i].left = rotate_left(l);
+            return rotate_right(i);
+        }
+        if(bal < -1) {
+            index r = _nodes[i].right;
+            if(height_of(_nodes[r].right) < height_of(_nodes[r].left))
+                _nodes[i].right = rotate_right(r);
+            return rotate_left(i);
+        }
+        return i;
+    }
+
+    /**
+     * Sostituisce nel padre (o nella radice) il figlio from con to
+    */
+    void relink(index parent, index from, index to) {
+        if(parent == nil)
+            _root = to;
+        else if(_nodes[parent].left == from)
+            _nodes[parent].left = to;
+        else
+            _nodes[parent].right = to;
+    }
+
+    /**
+     * Ribilancia i nodi del percorso, dal più profondo alla radice
+    */
+    void rebalance(const index *path, int depth) {
+        for(int k = depth - 1; k >= 0; --k) {
+            index sub = balance(path[k]);
+            if(sub != path[k])
+                relink(k == 0 ? nil : path[k - 1], path[k], sub);
+        }
+    }
+
+    /**
+     * Vero se la discesa verso value, fallita, è passata a destra di un
+     * nodo equivalente: dopo le rotazioni l'uguale può stare nell'altro
+     * ramo di un equivalente
+     *
+     * @param pred ultimo nodo superato verso destra, nil se nessuno
+    */
+    bool equivalent_miss(index pred, const T &value) const {
+        return !bst_equal_from_order<C, E>::value && pred != nil &&
+            !bst_less(_conf, _nodes[pred].value, value);
+    }
+
+    /**
+     * Cerca tra gli equivalenti a value nel sottoalbero i il nodo target
+     * o, se target è nil, il nodo uguale a value. In ogni equivalente
+     * esplora entrambi i figli, quindi costa O(log n + k) con k numero di
+     * equivalenti. path riceve gli antenati del nodo trovato.
+     *
+     * @return indice del nodo, nil se assente
+    */
+    index find_equivalent(index i, const T &value, index target, index *path, int &depth) const {
+        while(i != nil) {
+            if(bst_less(_conf, value, _nodes[i].value)) {
+                path[depth++] = i;
+                i = _nodes[i].left;
+            } else if(bst_less(_conf, _nodes[i].value, value)) {
+                path[depth++] = i;
+                i = _nodes[i].right;
+            } else {
+                if(target != nil ? i == target : _eql(_nodes[i].value, value))
+                    return i;
+                int d = depth;
+                path[depth++] = i;
+                index found = find_equivalent(_nodes[i].left, value, target, path, depth);
+                if(found != nil)
+                    return found;
+                depth = d + 1;
+                i = _nodes[i].right;
+            }
+        }
+        return nil;
+    }
+
+    /**
+     * Cerca il nodo uguale a value ricordando gli antenati in path. Se
+     * manca, path e order descrivono il punto di inserimento
+     *
+     * @param order verso dell'ultimo passo della discesa
+     *
+     * @return indice del nodo, nil se assente
+    */
+    index locate(const T &value, index *path, int &depth, int &order) const {
+        index pred = nil;
+        depth = 0;
+        order = 0;
+
+        for(index i = _root; i != nil;) {
+            order = compare(value, _nodes[i].value);
+            if(order == 0)
+                return i;
+            if(order > 0)
+                pred = i;
+            path[depth++] = i;
+            i = order < 0 ? _nodes[i].left : _nodes[i].right;
+        }
+
+        if(equivalent_miss(pred, value)) {
+            index scan[max_height];
+            int found_depth = 0;
+            index found = find_equivalent(_root, value, nil, scan, found_depth);
+            if(found != nil) {
+                for(depth = 0; depth < found_depth; ++depth)
+                    path[depth] = scan[depth];
+                return found;
+            }
+        }
+        return nil;
+    }
+
+    /**
+     * Porta l'ultimo nodo del vettore nel posto libero hole, aggiornando il
+     * collegamento del padre, e accorcia il vettore. Il padre si ritrova
+     * scendendo con compare, lo stesso ordine usato da add; se le rotazioni
+     * hanno portato il nodo sotto un altro equivalente la discesa lo
+     * manca e la ricerca passa per tutti gli equivalenti
+    */
+    void compact(index hole) {
+        index last = (index)(_nodes.size() - 1);
+        if(hole != last) {
+            index parent = nil;
+            index i = _root;
+            while(i != last && i != nil) {
+                parent = i;
+                i = compare(_nodes[last].value, _nodes[i].value) < 0 ? _nodes[i].left : _nodes[i].right;
+            }
+            if(i == nil) {
+                index path[max_height];
+                int depth = 0;
+                i = find_equivalent(_root, _nodes[last].value, last, path, depth);
+                parent = depth == 0 ? nil : path[depth - 1];
+            }
+            assert(i == last);
+            relink(parent, last, hole);
+            _nodes[hole] = std::move(_nodes[last]);
+        }
+        _nodes.pop_back();
+    }
+
+public:
+
+    /**
+     * Costruttore di default: albero vuoto
+    */
+    compact_binary_search_tree(): _root(nil) {}
+
+    /**
+     * Costruttore da una sequenza di valori
+     *
+     * @param first inizio della sequenza
+     * @param last fine della sequenza
+     *
+     * @throw NoNodeCreatedException se l'albero è pieno
+    */
+    template <typename It>
+    compact_binary_search_tree(It first, It last): _root(nil) {
+        for(; first != last; ++first)
+            add(*first);
+    }
+
+    /**
+     * Costruttore di copia: copia il vettore dei nodi
+     *
+     * @param other albero da copiare
+    */
+    compact_binary_search_tree(const compact_binary_search_tree &other)
+        : _nodes(other._nodes), _root(other._root), _conf(other._conf), _eql(other._eql) {}
+
+    /**
+     * Costruttore di spostamento
+     *
+     * @param other albero da spostare, resta vuoto
+    */
+    compact_binary_search_tree(compact_binary_search_tree &&other)
+        : _nodes(std::move(other._nodes)), _root(other._root), _conf(other._conf), _eql(other._eql) {
+        other._nodes.clear();
+        other._root = nil;
+    }
+
+    /**
+     * Assegnamento per copia o per spostamento
+     *
+     * @param other albero da assegnare
+     *
+     * @return reference a this
+    */
+    compact_binary_search_tree &operator=(compact_binary_search_tree other) {
+        swap(other);
+        return *this;
+    }
+
+    /**
+     * Ritorna il numero di elementi nell'albero
+     *
+     * @return numero di elementi presenti nell'albero
+    */
+    std::size_t size() const {
+        return _nodes.size();
+    }
+
+    /**
+     * Ritorna l'altezza dell'albero
+     *
+     * @return altezza dell'albero, 0 se vuoto
+    */
+    unsigned int height() const {
+        return (unsigned int)height_of(_root);
+    }
+
+    /**
+     * Byte occupati da un nodo
+    */
+    static std::size_t node_size() {
+        return sizeof(node);
+    }
+
+    /**
+     * Ritorna il numero di nodi che l'albero può contenere senza riallocare
+    */
+    std::size_t capacity() const {
+        return _nodes.capacity();
+    }
+
+    /**
+     * Prepara lo spazio per n elementi
+     *
+     * @param n numero di elementi
+    */
+    void reserve(std::size_t n) {
+        _nodes.reserve(n);
+    }
+
+    /**
+     * Libera lo spazio non usato dal vettore dei nodi
+    */
+    void shrink_to_fit() {
+        _nodes.shrink_to_fit();
+    }
+
+    /**
+     * Aggiunge un elemento all'albero. Invalida gli iteratori.
+     *
+     * @param value valore da aggiungere
+     *
+     * @throw NoNodeCreatedException se l'albero è pieno
+    */
+    void add(const T &value) {
+        index path[max_height];
+        int depth;
+        int order;
+
+        if(locate(value, path, depth, order) != nil)
+            return;
+
+        if(_nodes.size() >= nil - 1)
+            throw NoNodeCreatedException();
+
+        index n = (index)_nodes.size();
+        _nodes.push_back(node(value));
+
+        if(depth == 0)
+            _root = n;
+        else if(order < 0)
+            _nodes[path[depth - 1]].left = n;
+        else
+            _nodes[path[depth - 1]].right = n;
+
+        rebalance(path, depth);
+    }
+
+    /**
+     * Rimuove dall'albero l'elemento con il valore dato. Invalida gli
+     * iteratori.
+     *
+     * @param value valore da rimuovere
+     *
+     * @return numero di elementi rimossi (0 o 1)
+    */
+    std::size_t erase(const T &value) {
+        index path[max_height];
+        int depth;
+        int order;
+
+        index i = locate(value, path, depth, order);
+        if(i == nil)
+            return 0;
+
+        index removed = i;
+        if(_nodes[i].left != nil && _nodes[i].right != nil) {
+            // il successore prende il posto del valore e si stacca lui
+            path[depth++] = i;
+            removed = _nodes[i].right;
+            while(_nodes[removed].left != nil) {
+                path[depth++] = removed;
+                removed = _nodes[removed].left;
+            }
+            _nodes[i].value = std::move(_nodes[removed].value);
+        }
+
+        index child = _nodes[removed].left != nil ? _nodes[removed].left : _nodes[removed].right;
+        relink(depth == 0 ? nil : path[depth - 1], removed, child);
+        rebalance(path, depth);
+        compact(removed);
+        return 1;
+    }
+
+    /**
+     * Determina se esiste un determinato elemento nell'albero
+     *
+     * @param value valore da cercare
+     *
+     * @return true se esiste l'elemento, false altrimenti
+    */
+    bool contains(const T &value) const {
+        index path[max_height];
+        int depth;
+        int order;
+
+        return locate(value, path, depth, order) != nil;
+    }
+
+    /**
+     * Svuota l'albero, mantenendo lo spazio del vettore
+    */
+    void clear() {
+        _nodes.clear();
+        _root = nil;
+    }
+
+    /**
+     * Scambia il contenuto con un altro albero
+     *
+     * @param other albero da scambiare
+    */
+    void swap(compact_binary_search_tree &other) {
+        _nodes.swap(other._nodes);
+        std::swap(_root, other._root);
+        std::swap(_conf, other._conf);
+        std::swap(_eql, other._eql);
+    }
+
+    /**
+     * Iteratore costante dell'albero, con uno stack degli antenati
+     *
+     * @brief Iteratore costante dell'albero
+    */
+    class const_iterator{
+
+    private:
+        index _stack[max_height]; // antenati ancora da visitare
+        int _top; // numero di nodi nello stack
+        const compact_binary_search_tree *_tree; // albero visitato
+
+        friend class compact_binary_search_tree;
+
+        explicit const_iterator(const compact_binary_search_tree *tree) : _top(0), _tree(tree) {}
+
+        /**
+         * Impila i e tutti i suoi discendenti a sinistra
+        */
+        void push_left(index i) {
+            for(; i != nil; i = _tree->_nodes[i].left)
+                _stack[_top++] = i;
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T                         value_type;
+        typedef ptrdiff_t                 difference_type;
+        typedef const T*                  pointer;
+        typedef const T&                  reference;
+
+        const_iterator() : _top(0), _tree(nullptr) {}
+
+        const_iterator(const const_iterator &other) : _top(other._top), _tree(other._tree) {
+            for(int i = 0; i < _top; ++i)
+                _stack[i] = other._stack[i];
+        }
+
+        const_iterator& operator=(const const_iterator &other) {
+            _top = other._top;
+            _tree = other._tree;
+            for(int i = 0; i < _top; ++i)
+                _stack[i] = other._stack[i];
+            return *this;
+        }
+
+        ~const_iterator() {}
+
+        /**
+         * Ritorna il dato riferito dall'iteratore (dereferenziamento)
+        */
+        reference operator*() const {
+            return _tree->_nodes[_stack[_top - 1]].value;
+        }
+
+        /**
+         * Ritorna il puntatore al dato riferito dall'iteratore
+        */
+        pointer operator->() const {
+            return &(_tree->_nodes[_stack[_top - 1]].value);
+        }
+
+        /**
+         * Operatore di iterazione post-incremento
+        */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * Operatore di iterazione pre-incremento
+        */
+        const_iterator& operator++() {
+            index i = _stack[--_top];
+            push_left(_tree->_nodes[i].right);
+            return *this;
+        }
+
+        /**
+         * Uguaglianza
+        */
+        bool operator==(const const_iterator &other) const {
+            if(_top != other._top)
+                return false;
+            return _top == 0 || _stack[_top - 1] == other._stack[_top - 1];
+        }
+
+        /**
+         * Diversità
+        */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    };
+
+    /**
+     * Ritorna l'iteratore all'inizio della sequenza dati
+     *
+     * @return iteratore all'inizio della sequenza
+    */
+    const_iterator begin() const {
+        const_iterator it(this);
+        it.push_left(_root);
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore alla fine della sequenza dati
+     *
+     * @return iteratore alla fine della sequenza
+    */
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    /**
+     * Cerca un elemento. L'iteratore ritornato prosegue in ordine
+     * dall'elemento trovato.
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore all'elemento, end() se non presente
+    */
+    const_iterator find(const T &value) const {
+        index path[max_height];
+        int depth;
+        int order;
+
+        index i = locate(value, path, depth, order);
+        if(i == nil)
+            return const_iterator();
+
+        // restano da visitare gli antenati da cui la discesa va a sinistra
+        const_iterator it(this);
+        for(int k = 0; k < depth; ++k) {
+            index next = k + 1 < depth ? path[k + 1] : i;
+            if(_nodes[path[k]].left == next)
+                it._stack[it._top++] = path[k];
+        }
+        it._stack[it._top++] = i;
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento non minore di value
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore al primo elemento x con !(x < value)
+    */
+    const_iterator lower_bound(const T &value) const {
+        const_iterator it(this);
+
+        for(index i = _root; i != nil;) {
+            bool left = !bst_less(_conf, _nodes[i].value, value);
+            if(left)
+                it._stack[it._top++] = i;
+            i = left ? _nodes[i].left : _nodes[i].right;
+        }
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento maggiore di value
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore al primo elemento x con value < x
+    */
+    const_iterator upper_bound(const T &value) const {
+        const_iterator it(this);
+
+        for(index i = _root; i != nil;) {
+            bool left = bst_less(_conf, value, _nodes[i].value);
+            if(left)
+                it._stack[it._top++] = i;
+            i = left ? _nodes[i].left : _nodes[i].right;
+        }
+        return it;
+    }
+
+};
+
+/**
+ * Overload dell'operatore di stream << per un compact_binary_search_tree
+ *
+ * @brief Operatore <<
+ *
+ * @return puntatore allo stream
+*/
+template <typename T, typename C, typename E>
+std::ostream &operator<<(std::ostream &os, const compact_binary_search_tree<T,C,E> &bstree) {
+
+    typename compact_binary_search_tree<T,C,E>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i)
+        os << *i << " ";
+
+    return os;
+}
+
+/**
+ * Stampa a schermo l'elenco dei valori dell'albero compatto che
+ * soddisfano un predicato.
+ *
+ * @brief Stampa i valori dell'albero che soddisfano un predicato.
+ *
+ * @param bstree albero compatto
+ * @param pred predicato
+*/
+template <typename T, typename C, typename E, typename P>
+void printIF(const compact_binary_search_tree<T,C,E> &bstree, P pred) {
+
+    typename compact_binary_search_tree<T,C,E>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i) {
+        if(pred(*i))
+            std::cout << *i << std::endl;
+    }
+
+}
+
+#endif
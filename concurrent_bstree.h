@@ -0,0 +1,1128 @@
+#ifndef CONCURRENT_BSTREE_H
+#define CONCURRENT_BSTREE_H
+
+#include <ostream>
+#include <iostream>
+#include <iterator> // std::forward_iterator_tag
+#include <cstddef>  // std::ptrdiff_t, std::size_t
+#include <atomic>   // std::atomic
+#include <memory>   // std::align
+#include <new>      // operator new, placement new
+#include <mutex>    // std::mutex, std::lock_guard
+#include <vector>
+#include "bstree.h" // eccezioni comuni, bst_less, bst_equal
+
+/**
+ * @brief Troppi thread lettori registrati contemporaneamente
+ *
+ * @return Eccezione
+ */
+class TooManyReadersException: public std::exception {
+  virtual const char* what() const throw() {
+    return "troppi thread lettori attivi";
+  }
+};
+
+/**
+ * Assegna a ogni thread un indice piccolo e stabile, usato dagli alberi
+ * concorrenti per trovare lo slot in cui il thread annuncia le letture.
+ * L'indice viene assegnato al primo uso e restituito quando il thread
+ * termina, quindi solo la prima lettura di ogni thread prende un lock.
+ *
+ * @brief Registro dei thread lettori
+*/
+class bst_reader_registry {
+
+public:
+
+    /**
+     * Numero massimo di thread lettori vivi contemporaneamente
+    */
+    enum { max_readers = 256 };
+
+    /**
+     * Ritorna l'indice del thread corrente
+     *
+     * @return indice in [0, max_readers)
+     *
+     * @throw TooManyReadersException se tutti gli indici sono occupati
+    */
+    static unsigned int id() {
+        static thread_local handle h;
+        return h.id;
+    }
+
+private:
+
+    /**
+     * Indici occupati, condivisi da tutti i thread
+    */
+    struct state {
+        std::mutex lock;
+        bool used[max_readers];
+
+        state() {
+            for(unsigned int i = 0; i < max_readers; ++i)
+                used[i] = false;
+        }
+    };
+
+    static state &shared() {
+        static state s;
+        return s;
+    }
+
+    /**
+     * Indice posseduto da un thread, liberato alla sua terminazione
+    */
+    struct handle {
+        unsigned int id;
+
+        handle() {
+            state &s = shared();
+            std::lock_guard<std::mutex> guard(s.lock);
+            for(id = 0; id < max_readers; ++id) {
+                if(!s.used[id]) {
+                    s.used[id] = true;
+                    return;
+                }
+            }
+            throw TooManyReadersException();
+        }
+
+        ~handle() {
+            state &s = shared();
+            std::lock_guard<std::mutex> guard(s.lock);
+            s.used[id] = false;
+        }
+    };
+
+};
+
+/**
+ * Dominio di riclamazione a epoche condiviso dai lettori e dagli scrittori
+ * di una struttura concorrente. Un thread apre una sezione di lettura
+ * annunciando nel proprio slot l'epoca globale e la chiude svuotandolo; un
+ * nodo staccato dalla struttura viene messo in attesa con l'epoca corrente
+ * e liberato solo quando tutti i lettori attivi hanno annunciato un'epoca
+ * successiva, quindi nessuno può ancora raggiungerlo.
+ *
+ * Ogni thread mette in attesa i nodi nella lista del proprio slot, così
+ * più scrittori possono rimuovere nodi senza sincronizzarsi tra loro.
+ *
+ * @brief Riclamazione della memoria a epoche
+*/
+class bst_epoch_domain {
+
+public:
+
+    /**
+     * Funzione che libera un nodo messo in attesa
+    */
+    typedef void (*deleter)(void *);
+
+private:
+
+    /**
+     * Nodo in attesa della fine delle letture
+    */
+    struct retired {
+        void *p; // nodo staccato
+        deleter free; // funzione che lo libera
+        unsigned long long epoch; // epoca globale al distacco
+    };
+
+    struct slot_data {
+        std::atomic<unsigned long long> epoch; // epoca annunciata, idle se inattivo
+        unsigned int depth; // sezioni di lettura annidate (solo il proprietario)
+        std::vector<retired> retired_list; // nodi messi in attesa dal proprietario
+        std::size_t threshold; // nodi in attesa oltre i quali riprovare a liberarli
+
+        slot_data(): epoch(idle), depth(0), threshold(reclaim_batch) {}
+    };
+
+    /**
+     * Slot di un thread, su linee di cache separate da quelle degli altri
+    */
+    struct alignas(64) slot: slot_data {};
+
+    /**
+     * Byte da allocare per gli slot, con lo spazio per allinearli: in C++11
+     * new non rispetta gli allineamenti oltre quello di max_align_t
+    */
+    static const std::size_t slots_bytes = sizeof(slot) * bst_reader_registry::max_readers + alignof(slot);
+
+    /**
+     * Nodi in attesa oltre i quali un thread prova a liberarli
+    */
+    enum { reclaim_batch = 1024 };
+
+    static const unsigned long long idle = ~0ULL;
+
+    std::atomic<unsigned long long> _epoch; // epoca globale
+    void *_raw; // memoria allocata per gli slot
+    slot *_slots; // uno slot per ogni indice di bst_reader_registry, allineati
+
+    bst_epoch_domain(const bst_epoch_domain &);
+    bst_epoch_domain &operator=(const bst_epoch_domain &);
+
+    slot &current() const {
+        return _slots[bst_reader_registry::id()];
+    }
+
+public:
+
+    /**
+     * Costruttore
+     *
+     * @throw std::bad_alloc
+    */
+    bst_epoch_domain(): _epoch(0), _raw(::operator new(slots_bytes)), _slots(nullptr) {
+        void *p = _raw;
+        std::size_t space = slots_bytes;
+        _slots = static_cast<slot *>(std::align(alignof(slot), slots_bytes - alignof(slot), p, space));
+        for(unsigned int i = 0; i < bst_reader_registry::max_readers; ++i)
+            ::new (static_cast<void *>(_slots + i)) slot();
+    }
+
+    /**
+     * Distruttore: libera tutti i nodi in attesa. Non ci devono essere
+     * letture in corso.
+    */
+    ~bst_epoch_domain() {
+        for(unsigned int i = 0; i < bst_reader_registry::max_readers; ++i) {
+            std::vector<retired> &list = _slots[i].retired_list;
+            for(std::size_t j = 0; j < list.size(); ++j)
+                list[j].free(list[j].p);
+            _slots[i].~slot();
+        }
+        ::operator delete(_raw);
+    }
+
+    /**
+     * Apre una sezione di lettura del thread corrente. Le sezioni
+     * possono essere annidate.
+     *
+     * @throw TooManyReadersException alla prima lettura del thread
+    */
+    void enter() const {
+        slot &s = current();
+        if(s.depth++ == 0)
+            s.epoch.store(_epoch.load());
+    }
+
+    /**
+     * Chiude una sezione di lettura del thread corrente
+    */
+    void leave() const {
+        slot &s = current();
+        if(--s.depth == 0)
+            s.epoch.store(idle, std::memory_order_release);
+    }
+
+    /**
+     * Riserva lo spazio per mettere in attesa n nodi senza allocare,
+     * da chiamare prima di modificare la struttura
+     *
+     * @throw std::bad_alloc
+    */
+    void reserve(std::size_t n) {
+        std::vector<retired> &list = current().retired_list;
+        if(list.capacity() - list.size() < n)
+            list.reserve(2 * list.capacity() + n);
+    }
+
+    /**
+     * Mette in attesa un nodo già staccato dalla struttura. Non alloca se
+     * lo spazio è stato riservato con reserve.
+     *
+     * @param p nodo staccato
+     * @param free funzione che lo libera
+    */
+    void retire(void *p, deleter free) {
+        std::vector<retired> &list = current().retired_list;
+        retired r = { p, free, _epoch.load() };
+        list.push_back(r);
+    }
+
+    /**
+     * Libera i nodi del thread corrente se ne ha accumulati abbastanza.
+     * Se una lettura lunga ne trattiene molti la soglia raddoppia, così il
+     * costo dei tentativi resta ammortizzato.
+    */
+    void collect() {
+        slot &s = current();
+        if(s.retired_list.size() >= s.threshold) {
+            reclaim();
+            s.threshold = 2 * s.retired_list.size();
+            if(s.threshold < reclaim_batch)
+                s.threshold = reclaim_batch;
+        }
+    }
+
+    /**
+     * Avanza l'epoca globale e libera i nodi del thread corrente staccati
+     * prima dell'epoca più vecchia annunciata dai lettori attivi
+    */
+    void reclaim() {
+        _epoch.fetch_add(1);
+
+        unsigned long long oldest = idle;
+        for(unsigned int i = 0; i < bst_reader_registry::max_readers; ++i) {
+            unsigned long long e = _slots[i].epoch.load();
+            if(e < oldest)
+                oldest = e;
+        }
+
+        std::vector<retired> &list = current().retired_list;
+        std::size_t kept = 0;
+        for(std::size_t i = 0; i < list.size(); ++i) {
+            if(list[i].epoch < oldest)
+                list[i].free(list[i].p);
+            else
+                list[kept++] = list[i];
+        }
+        list.resize(kept);
+    }
+
+    /**
+     * Sezione di lettura aperta per la durata di un blocco
+     *
+     * @brief Sezione di lettura
+    */
+    class guard {
+
+    private:
+        const bst_epoch_domain &_domain;
+
+        guard(const guard &);
+        guard &operator=(const guard &);
+
+    public:
+        explicit guard(const bst_epoch_domain &domain): _domain(domain) {
+            _domain.enter();
+        }
+
+        ~guard() {
+            _domain.leave();
+        }
+
+    };
+
+};
+
+/**
+ * Classe generica che implementa un albero binario di ricerca per carichi
+ * prevalentemente in lettura: un numero qualsiasi di thread lettori e un
+ * thread scrittore alla volta possono usare lo stesso oggetto senza lock
+ * esterni.
+ *
+ * I nodi pubblicati sono immutabili. Una modifica copia il percorso dalla
+ * radice (come nell'albero persistente) e pubblica la nuova radice con una
+ * sola scrittura atomica, quindi un lettore vede sempre una versione
+ * completa e un iteratore percorre lo snapshot da cui è partito.
+ *
+ * I nodi sostituiti vengono liberati tramite un bst_epoch_domain quando
+ * nessuna lettura iniziata prima della loro rimozione è ancora aperta. find, contains, lower_bound, upper_bound e l'iterazione non
+ * prendono lock e non attendono lo scrittore: ogni passo costa un numero
+ * limitato di istruzioni (wait-free), a parte la registrazione del thread
+ * alla sua prima lettura.
+ *
+ * Le modifiche sono serializzate da un mutex interno e costano O(log n)
+ * allocazioni. Un iteratore tiene aperta una sezione di lettura fino alla
+ * sua distruzione e deve essere usato e distrutto nel thread che lo ha
+ * creato; un iteratore tenuto a lungo ritarda la liberazione dei nodi.
+ *
+ * @brief Albero binario di ricerca con lettori concorrenti
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+*/
+template <typename T, typename C, typename E>
+class concurrent_binary_search_tree {
+
+private:
+
+    /**
+     * Nodo immutabile dopo la pubblicazione
+     *
+     * @brief Nodo dell'albero
+    */
+    struct node {
+
+        T value; // valore del dato inserito
+        node *left; // figlio sinistro del nodo
+        node *right; // figlio destro del nodo
+        int height; // altezza del sottoalbero radicato nel nodo
+        unsigned long stamp; // modifica che ha creato il nodo (solo scrittore)
+
+        node(const T &v, node *l, node *r, unsigned long s): value(v), left(l), right(r), stamp(s) {
+            update();
+        }
+
+        /**
+         * Ricalcola l'altezza dai figli
+        */
+        void update() {
+            int hl = height_of(left);
+            int hr = height_of(right);
+            height = 1 + (hl > hr ? hl : hr);
+        }
+
+    };
+
+    /**
+     * Altezza massima dell'albero: un AVL con 2^64 nodi è alto meno di 96
+    */
+    enum { max_height = 96 };
+
+    /**
+     * Nodi al più creati o sostituiti da una modifica: uno per livello del
+     * percorso più quelli coinvolti nelle rotazioni
+    */
+    enum { max_path = 4 * max_height };
+
+    std::atomic<node *> _root; // radice della versione pubblicata
+    std::atomic<std::size_t> _size; // numero di nodi della versione pubblicata
+    mutable bst_epoch_domain _domain; // sezioni di lettura e nodi in attesa
+
+    std::mutex _write; // serializza gli scrittori
+    unsigned long _stamp; // modifica in corso
+    std::vector<node *> _fresh; // nodi creati dalla modifica in corso
+    std::vector<node *> _pending; // nodi sostituiti dalla modifica in corso
+
+    C _conf; // oggetto funtore per il confronto
+    E _eql; // oggetto funtore per l'uguaglianza
+
+    concurrent_binary_search_tree(const concurrent_binary_search_tree &);
+    concurrent_binary_search_tree &operator=(const concurrent_binary_search_tree &);
+
+    static int height_of(const node *n){
+        return n == nullptr ? 0 : n->height;
+    }
+
+    /**
+     * Libera un sottoalbero non più raggiungibile
+    */
+    static void destroy(node *n){
+        while(n != nullptr){
+            node *r = n->right;
+            destroy(n->left);
+            delete n;
+            n = r;
+        }
+    }
+
+    static void free_node(void *p){
+        delete static_cast<node *>(p);
+    }
+
+    static void free_tree(void *p){
+        destroy(static_cast<node *>(p));
+    }
+
+    /**
+     * Crea un nodo non ancora pubblicato
+     *
+     * @throw std::bad_alloc
+    */
+    node *make_node(const T &value, node *l, node *r){
+        node *n = new node(value, l, r, _stamp);
+        _fresh.push_back(n);
+        return n;
+    }
+
+    /**
+     * Rende modificabile il nodo n: se è già pubblicato ne crea una copia
+     * e lo segna come sostituito
+     *
+     * @throw std::bad_alloc
+    */
+    node *own(node *n){
+        if(n->stamp == _stamp)
+            return n;
+
+        node *copy = make_node(n->value, n->left, n->right);
+        _pending.push_back(n);
+        return copy;
+    }
+
+    /**
+     * Rotazione a destra di un nodo non pubblicato
+    */
+    node *rotate_right(node *x){
+        node *y = own(x->left);
+        x->left = y->right;
+        x->update();
+        y->right = x;
+        y->update();
+        return y;
+    }
+
+    /**
+     * Rotazione a sinistra di un nodo non pubblicato
+    */
+    node *rotate_left(node *x){
+        node *y = own(x->right);
+        x->right = y->left;
+        x->update();
+        y->left = x;
+        y->update();
+        return y;
+    }
+
+    /**
+     * Ribilancia un nodo non pubblicato, copiando i nodi pubblicati
+     * coinvolti nelle rotazioni
+    */
+    node *balance(node *n){
+        n->update();
+        int bal = height_of(n->left) - height_of(n->right);
+
+        if(bal > 1){
+            if(height_of(n->left->left) < height_of(n->left->right)){
+                n->left = own(n->left);
+                n->left = rotate_left(n->left);
+            }
+            return rotate_right(n);
+        }
+        if(bal < -1){
+            if(height_of(n->right->right) < height_of(n->right->left)){
+                n->right = own(n->right);
+                n->right = rotate_right(n->right);
+            }
+            return rotate_left(n);
+        }
+        return n;
+    }
+
+    /**
+     * Indica se una discesa senza esito è passata per valori equivalenti a
+     * value. I valori equivalenti per C ma diversi per E vanno a destra di
+     * quelli presenti, ma le rotazioni AVL possono spostarli a sinistra del
+     * percorso; in ordine restano contigui e terminano in pred, l'ultimo
+     * nodo lasciato a sinistra. Con l'uguaglianza ricavata dal confronto
+     * non ci sono valori del genere.
+    */
+    bool equivalent_miss(const node *pred, const T &value) const {
+        return !bst_equal_from_order<C, E>::value && pred != nullptr && !bst_less(_conf, pred->value, value);
+    }
+
+    /**
+     * Cerca value visitando solo i nodi equivalenti e i percorsi che li
+     * raggiungono, da entrambe le parti di ogni nodo equivalente ma diverso.
+     * Costo O(log n + k) con k valori equivalenti.
+     *
+     * @param n radice della versione letta
+     * @param value valore cercato
+     * @param stack se non nullo, riceve gli antenati da visitare dopo il nodo
+     * @param top numero di nodi in stack, aggiornato
+     *
+     * @return nodo uguale a value, nullptr se non presente
+    */
+    const node *find_equivalent(const node *n, const T &value, const node **stack, int &top) const {
+        while(n != nullptr){
+            if(bst_less(_conf, value, n->value)){
+                if(stack != nullptr)
+                    stack[top++] = n;
+                n = n->left;
+            }
+            else if(bst_less(_conf, n->value, value)){
+                n = n->right;
+            }
+            else{
+                int depth = top;
+                if(stack != nullptr)
+                    stack[top++] = n;
+                if(bst_equal(_conf, _eql, n->value, value))
+                    return n;
+
+                const node *l = find_equivalent(n->left, value, stack, top);
+                if(l != nullptr)
+                    return l;
+                top = depth;
+                n = n->right;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Inserisce il valore nel sottoalbero n copiando il percorso.
+     * Prima di creare il nodo si controlla che nessun valore equivalente
+     * spostato dalle rotazioni sia uguale al valore.
+     *
+     * @param root radice della versione modificata
+     * @param pred ultimo nodo lasciato a sinistra del percorso
+     *
+     * @return nuova radice del sottoalbero, nullptr se il valore è già presente
+     *
+     * @throw std::bad_alloc
+    */
+    node *insert(node *n, const T &value, const node *root, const node *pred){
+        if(n == nullptr){
+            int top = 0;
+            if(equivalent_miss(pred, value) && find_equivalent(root, value, nullptr, top) != nullptr)
+                return nullptr;
+            return make_node(value, nullptr, nullptr);
+        }
+
+        if(bst_equal(_conf, _eql, n->value, value))
+            return nullptr;
+
+        if(bst_less(_conf, value, n->value)){
+            node *l = insert(n->left, value, root, pred);
+            if(l == nullptr)
+                return nullptr;
+            node *c = own(n);
+            c->left = l;
+            return balance(c);
+        }
+
+        node *r = insert(n->right, value, root, n);
+        if(r == nullptr)
+            return nullptr;
+        node *c = own(n);
+        c->right = r;
+        return balance(c);
+    }
+
+    /**
+     * Toglie il minimo dal sottoalbero n copiando il percorso
+     *
+     * @param n sottoalbero non vuoto
+     * @param min nodo minimo, segnato come sostituito
+     *
+     * @return nuova radice del sottoalbero
+    */
+    node *remove_min(node *n, node *&min){
+        if(n->left == nullptr){
+            min = n;
+            _pending.push_back(n);
+            return n->right;
+        }
+        node *l = remove_min(n->left, min);
+        node *c = own(n);
+        c->left = l;
+        return balance(c);
+    }
+
+    /**
+     * Rimuove il valore dal sottoalbero n copiando il percorso.
+     *
+     * @param n sottoalbero
+     * @param value valore da rimuovere
+     * @param found true se il valore è stato trovato
+     * @param scan true per cercare il valore anche a sinistra dei nodi
+     *             equivalenti ma diversi
+     * @param pred ultimo nodo lasciato a sinistra del percorso
+     *
+     * @return nuova radice del sottoalbero
+     *
+     * @throw std::bad_alloc
+    */
+    node *remove(node *n, const T &value, bool &found, bool scan, const node *&pred){
+        if(n == nullptr){
+            found = false;
+            return nullptr;
+        }
+
+        if(bst_equal(_conf, _eql, n->value, value)){
+            found = true;
+            _pending.push_back(n);
+            if(n->left == nullptr)
+                return n->right;
+            if(n->right == nullptr)
+                return n->left;
+
+            node *min;
+            node *r = remove_min(n->right, min);
+            return balance(make_node(min->value, n->left, r));
+        }
+
+        if(bst_less(_conf, value, n->value)){
+            node *l = remove(n->left, value, found, scan, pred);
+            if(!found)
+                return nullptr;
+            node *c = own(n);
+            c->left = l;
+            return balance(c);
+        }
+
+        if(scan && !bst_less(_conf, n->value, value)){
+            node *l = remove(n->left, value, found, scan, pred);
+            if(found){
+                node *c = own(n);
+                c->left = l;
+                return balance(c);
+            }
+        }
+
+        pred = n;
+        node *r = remove(n->right, value, found, scan, pred);
+        if(!found)
+            return nullptr;
+        node *c = own(n);
+        c->right = r;
+        return balance(c);
+    }
+
+    /**
+     * Prepara una modifica riservando lo spazio per i nodi che può toccare,
+     * così dopo la pubblicazione non servono altre allocazioni
+     *
+     * @throw std::bad_alloc
+    */
+    void begin_update(){
+        if(_fresh.capacity() < max_path)
+            _fresh.reserve(max_path);
+        if(_pending.capacity() < max_path)
+            _pending.reserve(max_path);
+        _domain.reserve(max_path);
+    }
+
+    /**
+     * Annulla una modifica non pubblicata liberando i nodi creati
+    */
+    void abort_update(){
+        for(std::size_t i = 0; i < _fresh.size(); ++i)
+            delete _fresh[i];
+        _fresh.clear();
+        _pending.clear();
+        ++_stamp;
+    }
+
+    /**
+     * Pubblica la nuova radice e mette in attesa i nodi sostituiti
+     *
+     * @param root nuova radice
+     * @param size nuovo numero di nodi
+    */
+    void publish(node *root, std::size_t size){
+        _root.store(root);
+        _size.store(size, std::memory_order_relaxed);
+
+        for(std::size_t i = 0; i < _pending.size(); ++i)
+            _domain.retire(_pending[i], &free_node);
+        _fresh.clear();
+        _pending.clear();
+        ++_stamp;
+        _domain.collect();
+    }
+
+public:
+
+    /**
+     * Costruttore di default
+     *
+     * @throw std::bad_alloc
+    */
+    concurrent_binary_search_tree()
+        : _root(nullptr), _size(0), _stamp(1) {}
+
+    /**
+     * Distruttore: non ci devono essere letture in corso
+    */
+    ~concurrent_binary_search_tree(){
+        destroy(_root.load());
+    }
+
+    /**
+     * Ritorna il numero di elementi della versione pubblicata
+     *
+     * @return numero di elementi presenti nell'albero
+    */
+    std::size_t size() const {
+        return _size.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Inserisce un elemento e pubblica la nuova versione.
+     * Può essere chiamato mentre altri thread leggono.
+     *
+     * @param value valore da inserire
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    void add(const T &value){
+        std::lock_guard<std::mutex> guard(_write);
+        node *r;
+        try{
+            begin_update();
+            node *root = _root.load(std::memory_order_relaxed);
+            r = insert(root, value, root, nullptr);
+        }
+        catch(...){
+            abort_update();
+            throw NoNodeCreatedException();
+        }
+        if(r == nullptr){
+            abort_update();
+            return;
+        }
+        publish(r, size() + 1);
+    }
+
+    /**
+     * Rimuove un elemento e pubblica la nuova versione.
+     * Può essere chiamato mentre altri thread leggono.
+     *
+     * @param value valore da rimuovere
+     *
+     * @return numero di elementi rimossi (0 o 1)
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    std::size_t erase(const T &value){
+        std::lock_guard<std::mutex> guard(_write);
+        bool found;
+        node *r;
+        try{
+            begin_update();
+            node *root = _root.load(std::memory_order_relaxed);
+            const node *pred = nullptr;
+            r = remove(root, value, found, false, pred);
+            if(!found && equivalent_miss(pred, value))
+                r = remove(root, value, found, true, pred);
+        }
+        catch(...){
+            abort_update();
+            throw NoNodeCreatedException();
+        }
+        if(!found){
+            abort_update();
+            return 0;
+        }
+        publish(r, size() - 1);
+        return 1;
+    }
+
+    /**
+     * Svuota l'albero. I nodi vengono liberati quando le letture in corso
+     * sulla versione precedente terminano.
+    */
+    void clear(){
+        std::lock_guard<std::mutex> guard(_write);
+        begin_update();
+        node *old = _root.load(std::memory_order_relaxed);
+        if(old == nullptr)
+            return;
+
+        publish(nullptr, 0);
+        _domain.retire(old, &free_tree);
+    }
+
+    /**
+     * Determina se esiste un determinato elemento nell'albero.
+     * Non prende lock e non attende lo scrittore.
+     *
+     * @param value valore da cercare
+     *
+     * @return true se esiste l'elemento, false altrimenti
+    */
+    bool contains(const T &value) const {
+        bst_epoch_domain::guard section(_domain);
+        const node *root = _root.load();
+        const node *curr = root;
+        const node *pred = nullptr;
+
+        while(curr != nullptr){
+            if(bst_equal(_conf, _eql, curr->value, value))
+                return true;
+
+            if(bst_less(_conf, value, curr->value)){
+                curr = curr->left;
+            }
+            else{
+                pred = curr;
+                curr = curr->right;
+            }
+        }
+
+        int top = 0;
+        return equivalent_miss(pred, value) && find_equivalent(root, value, nullptr, top) != nullptr;
+    }
+
+    /**
+     * Ritorna l'altezza della versione pubblicata
+     *
+     * @return altezza dell'albero (0 se vuoto)
+    */
+    unsigned int height() const {
+        bst_epoch_domain::guard section(_domain);
+        return height_of(_root.load());
+    }
+
+    /**
+     * Iteratore costante dell'albero. Percorre in ordine la versione
+     * pubblicata al momento della sua creazione, anche se nel frattempo lo
+     * scrittore la sostituisce, e tiene aperta una sezione di lettura del
+     * thread che lo ha creato fino alla sua distruzione.
+     *
+     * @brief Iteratore costante dell'albero
+    */
+    class const_iterator{
+
+    private:
+        const node *_stack[max_height]; // antenati ancora da visitare
+        int _top; // numero di nodi nello stack
+        const concurrent_binary_search_tree *_tree; // albero letto, nullptr se non serve proteggere i nodi
+
+        friend class concurrent_binary_search_tree;
+
+        /**
+         * Impila n e tutti i suoi discendenti a sinistra
+        */
+        void push_left(const node *n){
+            while(n != nullptr){
+                _stack[_top++] = n;
+                n = n->left;
+            }
+        }
+
+        explicit const_iterator(const concurrent_binary_search_tree *tree) : _top(0), _tree(tree) {
+            _tree->_domain.enter();
+        }
+
+        void copy_stack(const const_iterator &other) {
+            _top = other._top;
+            for(int i = 0; i < _top; ++i)
+                _stack[i] = other._stack[i];
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T                         value_type;
+        typedef ptrdiff_t                 difference_type;
+        typedef const T*                  pointer;
+        typedef const T&                  reference;
+
+        const_iterator() : _top(0), _tree(nullptr) {}
+
+        const_iterator(const const_iterator &other) : _tree(other._tree) {
+            if(_tree != nullptr)
+                _tree->_domain.enter();
+            copy_stack(other);
+        }
+
+        const_iterator& operator=(const const_iterator &other) {
+            if(this != &other) {
+                if(other._tree != nullptr)
+                    other._tree->_domain.enter();
+                if(_tree != nullptr)
+                    _tree->_domain.leave();
+                _tree = other._tree;
+                copy_stack(other);
+            }
+            return *this;
+        }
+
+        ~const_iterator() {
+            if(_tree != nullptr)
+                _tree->_domain.leave();
+        }
+
+        /**
+         * Ritorna il dato riferito dall'iteratore (dereferenziamento)
+        */
+        reference operator*() const {
+            return _stack[_top - 1]->value;
+        }
+
+        /**
+         * Ritorna il puntatore al dato riferito dall'iteratore
+        */
+        pointer operator->() const {
+            return &(_stack[_top - 1]->value);
+        }
+
+        /**
+         * Operatore di iterazione post-incremento
+        */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * Operatore di iterazione pre-incremento
+        */
+        const_iterator& operator++() {
+            const node *n = _stack[--_top];
+            push_left(n->right);
+            return *this;
+        }
+
+        /**
+         * Uguaglianza
+        */
+        bool operator==(const const_iterator &other) const {
+            if(_top != other._top)
+                return false;
+            return _top == 0 || _stack[_top - 1] == other._stack[_top - 1];
+        }
+
+        /**
+         * Diversità
+        */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    };
+
+    /**
+     * Ritorna l'iteratore all'inizio della versione pubblicata
+     *
+     * @return iteratore all'inizio della sequenza
+    */
+    const_iterator begin() const {
+        const_iterator it(this);
+        it.push_left(_root.load());
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore alla fine della sequenza dati
+     *
+     * @return iteratore alla fine della sequenza
+    */
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    /**
+     * Cerca un elemento nella versione pubblicata in O(log n).
+     * L'iteratore ritornato prosegue in ordine dall'elemento trovato.
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore all'elemento, end() se non presente
+    */
+    const_iterator find(const T &value) const {
+        const_iterator it(this);
+        const node *root = _root.load();
+        const node *curr = root;
+        const node *pred = nullptr;
+
+        while(curr != nullptr){
+            if(bst_equal(_conf, _eql, curr->value, value)){
+                it._stack[it._top++] = curr;
+                return it;
+            }
+
+            if(bst_less(_conf, value, curr->value)){
+                it._stack[it._top++] = curr;
+                curr = curr->left;
+            }
+            else{
+                pred = curr;
+                curr = curr->right;
+            }
+        }
+
+        it._top = 0;
+        if(!equivalent_miss(pred, value) || find_equivalent(root, value, it._stack, it._top) == nullptr)
+            return const_iterator();
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento non minore di value
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore al primo elemento x con !(x < value)
+    */
+    const_iterator lower_bound(const T &value) const {
+        const_iterator it(this);
+        const node *curr = _root.load();
+
+        // lo stack contiene esattamente gli antenati in cui si è scesi a sinistra
+        while(curr != nullptr){
+            if(bst_less(_conf, curr->value, value)){
+                curr = curr->right;
+            }
+            else{
+                it._stack[it._top++] = curr;
+                curr = curr->left;
+            }
+        }
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento maggiore di value
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore al primo elemento x con value < x
+    */
+    const_iterator upper_bound(const T &value) const {
+        const_iterator it(this);
+        const node *curr = _root.load();
+
+        while(curr != nullptr){
+            if(bst_less(_conf, value, curr->value)){
+                it._stack[it._top++] = curr;
+                curr = curr->left;
+            }
+            else{
+                curr = curr->right;
+            }
+        }
+        return it;
+    }
+
+};
+
+/**
+ * Overload dell'operatore di stream << per un concurrent_binary_search_tree
+ *
+ * @brief Operatore <<
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ *
+ * @return puntatore allo stream
+*/
+template <typename T, typename C, typename E>
+std::ostream &operator<<(std::ostream &os, const concurrent_binary_search_tree<T,C,E> &bstree) {
+
+    typename concurrent_binary_search_tree<T,C,E>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i)
+        os << *i << " ";
+
+    return os;
+}
+
+/**
+ * Stampa a schermo l'elenco dei valori dell'albero concorrente che
+ * soddisfano un predicato.
+ *
+ * @brief Stampa i valori dell'albero che soddisfano un predicato.
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ * @param P funtore del predicato
+ * @param bstree albero di tipo T
+ * @param pred predicato
+*/
+template <typename T, typename C, typename E, typename P>
+void printIF(const concurrent_binary_search_tree<T,C,E> &bstree, P pred) {
+
+    typename concurrent_binary_search_tree<T,C,E>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i) {
+        if(pred(*i))
+            std::cout << *i << std::endl;
+    }
+
+}
+
+#endif
@@ -0,0 +1,772 @@
+#ifndef CONCURRENT_EXTERNAL_TREE_H
+#define CONCURRENT_EXTERNAL_TREE_H
+
+#include <ostream>
+#include <iostream>
+#include <iterator> // std::forward_iterator_tag
+#include <cstddef>  // std::ptrdiff_t, std::size_t
+#include <cstdint>  // std::uint32_t, std::uintptr_t
+#include <atomic>   // std::atomic
+#include <thread>   // std::this_thread::yield
+#include <utility>  // std::pair
+#include <vector>
+#include "concurrent_bstree.h" // bst_epoch_domain
+
+/**
+ * Classe generica che implementa un albero binario di ricerca esterno
+ * (i valori stanno solo nelle foglie, i nodi interni contengono chiavi di
+ * instradamento) in cui più thread possono inserire, rimuovere e cercare
+ * contemporaneamente.
+ *
+ * La ricerca scende senza lock fino a una foglia. Un inserimento blocca
+ * solo il padre della foglia raggiunta, una rimozione il nonno e il padre;
+ * dopo aver preso i lock l'operazione verifica che i nodi siano ancora
+ * collegati come durante la discesa e in caso contrario la ripete
+ * (validazione ottimistica). I lock sono presi sempre dall'alto verso il
+ * basso e i nodi non cambiano mai posizione relativa, quindi non ci sono
+ * stalli. Operazioni su chiavi lontane toccano nodi diversi e procedono in
+ * parallelo.
+ *
+ * add, erase, contains e find sono linearizzabili: ogni modifica ha effetto
+ * nell'istante in cui scrive il puntatore al figlio. L'iterazione è
+ * debolmente consistente: visita in ordine i valori presenti per tutta la
+ * sua durata e può vedere o no quelli inseriti o rimossi nel frattempo.
+ * I nodi staccati sono liberati tramite un bst_epoch_domain, e un iteratore
+ * deve essere usato e distrutto nel thread che lo ha creato.
+ *
+ * I nodi interni formano un treap: ognuno ha una priorità casuale e dopo
+ * un inserimento il nuovo nodo interno risale con rotazioni finché ha
+ * priorità maggiore del padre, quindi l'altezza attesa è logaritmica in
+ * qualunque ordine arrivino le chiavi. Una rotazione blocca nonno, padre e
+ * nodo e li sostituisce con copie nuove, in modo che le ricerche senza
+ * lock ferme sui nodi vecchi vedano ancora un sottoalbero valido. La
+ * rimozione sposta in alto il fratello della foglia e non viola l'ordine
+ * delle priorità. Due valori equivalenti per C sono considerati lo stesso
+ * elemento: il secondo non viene inserito.
+ *
+ * @brief Albero binario di ricerca esterno con scrittori concorrenti
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+*/
+template <typename T, typename C, typename E>
+class concurrent_external_tree {
+
+private:
+
+    struct node;
+
+    /**
+     * Parte comune ai nodi e alla testa dell'albero
+    */
+    struct link {
+        std::atomic<node *> left; // figlio sinistro
+        std::atomic<node *> right; // figlio destro
+        std::atomic<bool> locked; // lock del nodo
+        bool removed; // staccato dall'albero (letto e scritto sotto lock)
+
+        link(): left(nullptr), right(nullptr), locked(false), removed(false) {}
+    };
+
+    /**
+     * Nodo interno (chiave di instradamento) o foglia (valore)
+     *
+     * @brief Nodo dell'albero
+    */
+    struct node: link {
+        T value; // chiave o valore
+        bool is_leaf; // true per le foglie
+        std::uint32_t priority; // priorità nel treap dei nodi interni
+
+        node(const T &v, bool l): value(v), is_leaf(l), priority(0) {}
+    };
+
+    /**
+     * Attese a vuoto oltre le quali un thread in attesa di un lock cede il
+     * processore
+    */
+    enum { max_spins = 64 };
+
+    /**
+     * Livelli del percorso ricordati per le rotazioni dopo un inserimento
+    */
+    enum { max_trail = 128 };
+
+    /**
+     * Risultato di una discesa: foglia raggiunta, padre e nonno con i
+     * puntatori che li collegano
+    */
+    struct position {
+        link *gparent; // nonno, nullptr se il padre è la testa
+        std::atomic<node *> *gslot; // figlio del nonno che punta al padre
+        link *parent; // padre della foglia
+        std::atomic<node *> *pslot; // figlio del padre che punta alla foglia
+        node *leaf; // foglia raggiunta, nullptr se l'albero è vuoto
+    };
+
+    /**
+     * Percorso di una discesa: i nodi attraversati, a partire dalla testa,
+     * e il figlio seguito in ciascuno
+    */
+    struct trail {
+        link *nodes[max_trail]; // nodi attraversati
+        std::atomic<node *> *slots[max_trail]; // figlio seguito in nodes[i]
+        int depth; // livelli registrati, -1 se il percorso era più lungo
+    };
+
+    mutable link _head; // testa: l'albero è il suo figlio sinistro
+    std::atomic<std::size_t> _size; // numero di elementi
+    mutable bst_epoch_domain _domain; // sezioni di lettura e nodi staccati
+
+    C _conf; // oggetto funtore per il confronto
+    E _eql; // oggetto funtore per l'uguaglianza
+
+    concurrent_external_tree(const concurrent_external_tree &);
+    concurrent_external_tree &operator=(const concurrent_external_tree &);
+
+    /**
+     * Prende il lock di n. I lock sono tenuti per poche istruzioni, quindi
+     * chi aspetta prova prima con attese a vuoto di durata crescente e solo
+     * dopo cede il processore
+    */
+    static void lock(link *n){
+        unsigned int spins = 1;
+        while(n->locked.exchange(true, std::memory_order_acquire)){
+            while(n->locked.load(std::memory_order_relaxed)){
+                if(spins <= max_spins){
+                    for(unsigned int i = 0; i < spins; ++i)
+                        cpu_relax();
+                    spins *= 2;
+                }
+                else{
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    /**
+     * Segnala al processore un'attesa attiva
+    */
+    static void cpu_relax(){
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_ia32_pause();
+#endif
+    }
+
+    /**
+     * Priorità casuale di un nuovo nodo interno (xorshift per thread)
+    */
+    static std::uint32_t random_priority(){
+        static thread_local std::uint32_t state = 0;
+        if(state == 0)
+            state = (std::uint32_t)(reinterpret_cast<std::uintptr_t>(&state) >> 4) * 2654435761u | 1;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    static void unlock(link *n){
+        n->locked.store(false, std::memory_order_release);
+    }
+
+    static void free_node(void *p){
+        delete static_cast<node *>(p);
+    }
+
+    /**
+     * Libera un sottoalbero non più raggiungibile con uno stack esplicito,
+     * perché l'altezza è logaritmica solo in media
+    */
+    static void destroy(node *root){
+        std::vector<node *> stack;
+        if(root != nullptr)
+            stack.push_back(root);
+        while(!stack.empty()){
+            node *n = stack.back();
+            stack.pop_back();
+            if(!n->is_leaf){
+                stack.push_back(n->left.load(std::memory_order_relaxed));
+                stack.push_back(n->right.load(std::memory_order_relaxed));
+            }
+            delete n;
+        }
+    }
+
+    /**
+     * Crea un nodo
+     *
+     * @throw NoNodeCreatedException
+    */
+    static node *make_node(const T &value, bool leaf){
+        try{
+            return new node(value, leaf);
+        }
+        catch(...){
+            throw NoNodeCreatedException();
+        }
+    }
+
+    /**
+     * Scende senza lock fino alla foglia in cui si trova o andrebbe value,
+     * registrando il percorso in path se richiesto.
+     * Va chiamata dentro una sezione di lettura.
+    */
+    position search(const T &value, trail *path = nullptr) const {
+        position pos = { nullptr, nullptr, &_head, &_head.left, _head.left.load(std::memory_order_acquire) };
+        if(path != nullptr){
+            path->nodes[0] = pos.parent;
+            path->slots[0] = pos.pslot;
+            path->depth = 1;
+        }
+
+        while(pos.leaf != nullptr && !pos.leaf->is_leaf){
+            pos.gparent = pos.parent;
+            pos.gslot = pos.pslot;
+            pos.parent = pos.leaf;
+            if(bst_less(_conf, value, pos.leaf->value))
+                pos.pslot = &pos.leaf->left;
+            else
+                pos.pslot = &pos.leaf->right;
+            pos.leaf = pos.pslot->load(std::memory_order_acquire);
+            if(path != nullptr && path->depth >= 0){
+                if(path->depth == max_trail){
+                    path->depth = -1;
+                }
+                else{
+                    path->nodes[path->depth] = pos.parent;
+                    path->slots[path->depth] = pos.pslot;
+                    path->depth++;
+                }
+            }
+        }
+        return pos;
+    }
+
+    /**
+     * Fa risalire il nodo interno x appena inserito finché ha priorità
+     * maggiore del padre, risalendo il percorso path della discesa che lo ha
+     * collegato. Ogni rotazione sostituisce x e il padre con copie nuove e
+     * stacca gli originali. Si ferma se un altro thread ha cambiato il
+     * percorso o se manca memoria per le copie: il bilanciamento non serve
+     * alla correttezza. Va chiamata dentro una sezione di lettura.
+    */
+    void rise(node *x, trail &path){
+        for(int d = path.depth - 1; d >= 1; --d){
+            position pos = { path.nodes[d - 1], path.slots[d - 1], path.nodes[d], path.slots[d], x };
+            node *p = static_cast<node *>(pos.parent);
+            if(x->priority <= p->priority)
+                return;
+
+            node *top = nullptr;
+            node *below = nullptr;
+            try{
+                top = make_node(x->value, false);
+                below = make_node(p->value, false);
+                _domain.reserve(2);
+            }
+            catch(...){
+                delete top;
+                delete below;
+                return;
+            }
+            top->priority = x->priority;
+            below->priority = p->priority;
+
+            lock(pos.gparent);
+            lock(p);
+            lock(x);
+            bool valid = !pos.gparent->removed && pos.gslot->load(std::memory_order_relaxed) == p
+                && !p->removed && pos.pslot->load(std::memory_order_relaxed) == x && !x->removed;
+            if(valid){
+                if(pos.pslot == &p->left){
+                    // rotazione a destra: p diventa figlio destro di x
+                    below->left.store(x->right.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    below->right.store(p->right.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    top->left.store(x->left.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    top->right.store(below, std::memory_order_relaxed);
+                }
+                else{
+                    // rotazione a sinistra: p diventa figlio sinistro di x
+                    below->left.store(p->left.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    below->right.store(x->left.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    top->left.store(below, std::memory_order_relaxed);
+                    top->right.store(x->right.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+                p->removed = true;
+                x->removed = true;
+                pos.gslot->store(top, std::memory_order_release);
+            }
+            unlock(x);
+            unlock(p);
+            unlock(pos.gparent);
+
+            if(!valid){
+                delete top;
+                delete below;
+                return;
+            }
+            _domain.retire(p, &free_node);
+            _domain.retire(x, &free_node);
+            x = top;
+        }
+    }
+
+public:
+
+    /**
+     * Costruttore di default
+     *
+     * @throw std::bad_alloc
+    */
+    concurrent_external_tree(): _size(0) {}
+
+    /**
+     * Distruttore: non ci devono essere operazioni in corso
+    */
+    ~concurrent_external_tree(){
+        destroy(_head.left.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Ritorna il numero di elementi nell'albero
+     *
+     * @return numero di elementi presenti nell'albero
+    */
+    std::size_t size() const {
+        return _size.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Inserisce un elemento. Può essere chiamato da più thread insieme.
+     *
+     * @param value valore da inserire
+     *
+     * @return true se l'elemento è stato inserito, false se era già presente
+     *
+     * @throw NoNodeCreatedException
+    */
+    bool add(const T &value){
+        node *leaf = make_node(value, true);
+        node *inner = nullptr;
+        {
+            bst_epoch_domain::guard section(_domain);
+            trail path;
+            if(!link_leaf(leaf, inner, path))
+                return false;
+            if(inner != nullptr)
+                rise(inner, path);
+        }
+        _domain.collect();
+        return true;
+    }
+
+private:
+
+    /**
+     * Collega la nuova foglia leaf nel posto di value, con il nuovo nodo
+     * interno inner se l'albero non è vuoto, e ricorda in path il percorso
+     * seguito. Va chiamata dentro una sezione di lettura.
+     *
+     * @return false se il valore era già presente (leaf viene liberata)
+     *
+     * @throw NoNodeCreatedException
+    */
+    bool link_leaf(node *leaf, node *&inner, trail &path){
+        const T &value = leaf->value;
+
+        while(true){
+            position pos = search(value, &path);
+            if(pos.leaf != nullptr && bst_order(_conf, pos.leaf->value, value) == 0){
+                delete leaf;
+                delete inner;
+                inner = nullptr;
+                return false;
+            }
+
+            // la chiave del nuovo nodo interno è la maggiore tra le due foglie
+            bool before = pos.leaf != nullptr && bst_less(_conf, value, pos.leaf->value);
+            delete inner;
+            inner = nullptr;
+            if(pos.leaf != nullptr){
+                try{
+                    inner = make_node(before ? pos.leaf->value : value, false);
+                }
+                catch(...){
+                    delete leaf;
+                    throw;
+                }
+                inner->priority = random_priority();
+            }
+
+            lock(pos.parent);
+            if(pos.parent->removed || pos.pslot->load(std::memory_order_relaxed) != pos.leaf){
+                unlock(pos.parent);
+                continue;
+            }
+
+            node *child = leaf;
+            if(inner != nullptr){
+                inner->left.store(before ? leaf : pos.leaf, std::memory_order_relaxed);
+                inner->right.store(before ? pos.leaf : leaf, std::memory_order_relaxed);
+                child = inner;
+            }
+            pos.pslot->store(child, std::memory_order_release);
+            unlock(pos.parent);
+
+            _size.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+public:
+
+    /**
+     * Ritorna l'altezza dell'albero, foglie comprese. Da chiamare senza
+     * scrittori attivi.
+     *
+     * @return numero di nodi nel percorso più lungo dalla radice a una foglia
+    */
+    std::size_t height() const {
+        std::size_t h = 0;
+        std::vector<std::pair<const node *, std::size_t> > stack;
+        const node *root = _head.left.load(std::memory_order_acquire);
+        if(root != nullptr)
+            stack.push_back(std::make_pair(root, (std::size_t) 1));
+        while(!stack.empty()){
+            const node *n = stack.back().first;
+            std::size_t d = stack.back().second;
+            stack.pop_back();
+            if(d > h)
+                h = d;
+            if(!n->is_leaf){
+                stack.push_back(std::make_pair(n->left.load(std::memory_order_acquire), d + 1));
+                stack.push_back(std::make_pair(n->right.load(std::memory_order_acquire), d + 1));
+            }
+        }
+        return h;
+    }
+
+    /**
+     * Rimuove un elemento. Può essere chiamato da più thread insieme.
+     *
+     * @param value valore da rimuovere
+     *
+     * @return numero di elementi rimossi (0 o 1)
+     *
+     * @throw std::bad_alloc
+    */
+    std::size_t erase(const T &value){
+        _domain.reserve(2);
+        {
+            bst_epoch_domain::guard section(_domain);
+
+            while(true){
+                position pos = search(value);
+                if(pos.leaf == nullptr || !bst_equal(_conf, _eql, pos.leaf->value, value))
+                    return 0;
+
+                if(pos.gparent == nullptr){
+                    lock(pos.parent);
+                    bool valid = pos.pslot->load(std::memory_order_relaxed) == pos.leaf;
+                    if(valid)
+                        pos.pslot->store(nullptr, std::memory_order_release);
+                    unlock(pos.parent);
+                    if(!valid)
+                        continue;
+                }
+                else{
+                    // al posto del padre va il fratello della foglia
+                    lock(pos.gparent);
+                    lock(pos.parent);
+                    bool valid = !pos.gparent->removed && pos.gslot->load(std::memory_order_relaxed) == pos.parent
+                        && !pos.parent->removed && pos.pslot->load(std::memory_order_relaxed) == pos.leaf;
+                    if(valid){
+                        std::atomic<node *> &sibling = pos.pslot == &pos.parent->left ? pos.parent->right : pos.parent->left;
+                        pos.parent->removed = true;
+                        pos.gslot->store(sibling.load(std::memory_order_relaxed), std::memory_order_release);
+                    }
+                    unlock(pos.parent);
+                    unlock(pos.gparent);
+                    if(!valid)
+                        continue;
+                    _domain.retire(static_cast<node *>(pos.parent), &free_node);
+                }
+                _domain.retire(pos.leaf, &free_node);
+                _size.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+        _domain.collect();
+        return 1;
+    }
+
+    /**
+     * Determina se esiste un determinato elemento nell'albero.
+     * Non prende lock.
+     *
+     * @param value valore da cercare
+     *
+     * @return true se esiste l'elemento, false altrimenti
+    */
+    bool contains(const T &value) const {
+        bst_epoch_domain::guard section(_domain);
+        node *leaf = search(value).leaf;
+        return leaf != nullptr && bst_equal(_conf, _eql, leaf->value, value);
+    }
+
+    /**
+     * Iteratore costante dell'albero, debolmente consistente. Tiene aperta
+     * una sezione di lettura del thread che lo ha creato fino alla sua
+     * distruzione.
+     *
+     * @brief Iteratore costante dell'albero
+    */
+    class const_iterator{
+
+    private:
+        std::vector<const node *> _stack; // nodi interni con il sottoalbero destro da visitare
+        const node *_leaf; // foglia corrente, nullptr alla fine
+        const concurrent_external_tree *_tree; // albero letto, nullptr se non serve proteggere i nodi
+
+        friend class concurrent_external_tree;
+
+        explicit const_iterator(const concurrent_external_tree *tree) : _leaf(nullptr), _tree(tree) {
+            _tree->_domain.enter();
+        }
+
+        /**
+         * Scende a sinistra da n fino a una foglia
+        */
+        void descend(const node *n){
+            while(n != nullptr && !n->is_leaf){
+                _stack.push_back(n);
+                n = n->left.load(std::memory_order_acquire);
+            }
+            _leaf = n;
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T                         value_type;
+        typedef ptrdiff_t                 difference_type;
+        typedef const T*                  pointer;
+        typedef const T&                  reference;
+
+        const_iterator() : _leaf(nullptr), _tree(nullptr) {}
+
+        const_iterator(const const_iterator &other) : _stack(other._stack), _leaf(other._leaf), _tree(other._tree) {
+            if(_tree != nullptr)
+                _tree->_domain.enter();
+        }
+
+        const_iterator& operator=(const const_iterator &other) {
+            if(this != &other) {
+                if(other._tree != nullptr)
+                    other._tree->_domain.enter();
+                if(_tree != nullptr)
+                    _tree->_domain.leave();
+                _stack = other._stack;
+                _leaf = other._leaf;
+                _tree = other._tree;
+            }
+            return *this;
+        }
+
+        ~const_iterator() {
+            if(_tree != nullptr)
+                _tree->_domain.leave();
+        }
+
+        /**
+         * Ritorna il dato riferito dall'iteratore (dereferenziamento)
+        */
+        reference operator*() const {
+            return _leaf->value;
+        }
+
+        /**
+         * Ritorna il puntatore al dato riferito dall'iteratore
+        */
+        pointer operator->() const {
+            return &(_leaf->value);
+        }
+
+        /**
+         * Operatore di iterazione post-incremento
+        */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * Operatore di iterazione pre-incremento
+        */
+        const_iterator& operator++() {
+            if(_stack.empty()) {
+                _leaf = nullptr;
+            }
+            else {
+                const node *n = _stack.back();
+                _stack.pop_back();
+                descend(n->right.load(std::memory_order_acquire));
+            }
+            return *this;
+        }
+
+        /**
+         * Uguaglianza
+        */
+        bool operator==(const const_iterator &other) const {
+            return _leaf == other._leaf;
+        }
+
+        /**
+         * Diversità
+        */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    };
+
+    /**
+     * Ritorna l'iteratore all'inizio della sequenza dati
+     *
+     * @return iteratore all'inizio della sequenza
+    */
+    const_iterator begin() const {
+        const_iterator it(this);
+        it.descend(_head.left.load(std::memory_order_acquire));
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore alla fine della sequenza dati
+     *
+     * @return iteratore alla fine della sequenza
+    */
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento non minore di value
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore al primo elemento x con !(x < value)
+    */
+    const_iterator lower_bound(const T &value) const {
+        const_iterator it = seek(value);
+        if(it._leaf != nullptr && bst_less(_conf, it._leaf->value, value))
+            ++it;
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento maggiore di value
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore al primo elemento x con value < x
+    */
+    const_iterator upper_bound(const T &value) const {
+        const_iterator it = seek(value);
+        if(it._leaf != nullptr && !bst_less(_conf, value, it._leaf->value))
+            ++it;
+        return it;
+    }
+
+    /**
+     * Cerca un elemento. L'iteratore ritornato prosegue in ordine
+     * dall'elemento trovato.
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore all'elemento, end() se non presente
+    */
+    const_iterator find(const T &value) const {
+        const_iterator it = seek(value);
+        if(it._leaf != nullptr && bst_equal(_conf, _eql, it._leaf->value, value))
+            return it;
+        return const_iterator();
+    }
+
+private:
+
+    /**
+     * Scende fino alla foglia di value ricordando i nodi in cui si è scesi
+     * a sinistra, da cui l'iterazione prosegue
+    */
+    const_iterator seek(const T &value) const {
+        const_iterator it(this);
+        const node *n = _head.left.load(std::memory_order_acquire);
+
+        while(n != nullptr && !n->is_leaf){
+            if(bst_less(_conf, value, n->value)){
+                it._stack.push_back(n);
+                n = n->left.load(std::memory_order_acquire);
+            }
+            else{
+                n = n->right.load(std::memory_order_acquire);
+            }
+        }
+        it._leaf = n;
+        return it;
+    }
+
+};
+
+/**
+ * Overload dell'operatore di stream << per un concurrent_external_tree
+ *
+ * @brief Operatore <<
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ *
+ * @return puntatore allo stream
+*/
+template <typename T, typename C, typename E>
+std::ostream &operator<<(std::ostream &os, const concurrent_external_tree<T,C,E> &bstree) {
+
+    typename concurrent_external_tree<T,C,E>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i)
+        os << *i << " ";
+
+    return os;
+}
+
+/**
+ * Stampa a schermo l'elenco dei valori dell'albero esterno concorrente che
+ * soddisfano un predicato.
+ *
+ * @brief Stampa i valori dell'albero che soddisfano un predicato.
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ * @param P funtore del predicato
+ * @param bstree albero di tipo T
+ * @param pred predicato
+*/
+template <typename T, typename C, typename E, typename P>
+void printIF(const concurrent_external_tree<T,C,E> &bstree, P pred) {
+
+    typename concurrent_external_tree<T,C,E>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i) {
+        if(pred(*i))
+            std::cout << *i << std::endl;
+    }
+
+}
+
+#endif
@@ -0,0 +1,647 @@
+#ifndef FROZEN_BSTREE_H
+#define FROZEN_BSTREE_H
+
+#include <ostream>
+#include <iostream>
+#include <iterator> // std::bidirectional_iterator_tag, std::reverse_iterator
+#include <cstddef>  // std::ptrdiff_t, std::size_t
+#include <functional> // std::less
+#include <memory>   // std::allocator
+#include <type_traits> // std::integral_constant, std::is_same
+#include <vector>   // std::vector
+#include "bstree.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Indica se il funtore di confronto C coincide con l'operatore < sui tipi
+ * aritmetici. In quel caso le ricerche a gruppi dell'albero congelato
+ * possono confrontare più chiavi con una sola istruzione vettoriale.
+ * Va specializzata a true per i funtori equivalenti a std::less.
+ *
+ * @brief Confronto naturale
+ *
+ * @param C funtore di comparazione
+*/
+template <typename C>
+struct bst_natural_order : std::false_type {};
+
+template <typename T>
+struct bst_natural_order<std::less<T> > : std::true_type {};
+
+/**
+ * Copia immutabile di un binary_search_tree memorizzata in un unico array
+ * contiguo in ordine di Eytzinger (visita in ampiezza): il nodo k ha i figli
+ * in 2k e 2k + 1, quindi la ricerca non segue puntatori e i discendenti di
+ * un nodo qualche livello più in basso stanno nella stessa linea di cache,
+ * che viene richiesta in anticipo (prefetch) durante la discesa.
+ *
+ * Si ottiene con binary_search_tree::freeze() e si torna a un albero
+ * modificabile con thaw().
+ *
+ * @brief Albero congelato in ordine di Eytzinger
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ * @param B politica di bilanciamento dell'albero restituito da thaw()
+ * @param A allocatore compatibile con std::allocator
+ * @param F funzionalità opzionali dell'albero restituito da thaw()
+*/
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F>
+class frozen_binary_search_tree {
+
+public:
+
+    typedef binary_search_tree<T,C,E,B,A,F> tree_type;
+
+private:
+
+    std::vector<T, A> _data; // nodo k in posizione k - 1
+    C _conf; // oggetto funtore per il confronto
+    E _eql; // oggetto funtore per l'uguaglianza
+
+    /**
+     * Nodi che stanno in una linea di cache: i discendenti di k log2(stride)
+     * livelli più in basso sono contigui a partire dal nodo k * stride
+    */
+    static const std::size_t stride = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+
+    /**
+     * Numero di gruppi di chiavi cercati insieme da find_many
+    */
+    enum { lanes = 8 };
+
+    /**
+     * Richiede in anticipo la linea di cache del nodo k, se esiste
+    */
+    void prefetch(std::size_t k) const {
+#if defined(__GNUC__)
+        if(k <= _data.size())
+            __builtin_prefetch(&_data[k - 1]);
+#else
+        (void) k;
+#endif
+    }
+
+    /**
+     * Risale dalla posizione oltre la foglia raggiunta al nodo in cui la
+     * discesa è andata a sinistra l'ultima volta (0 se non esiste)
+    */
+    static std::size_t restore(std::size_t k){
+        while(k & 1)
+            k >>= 1;
+        return k >> 1;
+    }
+
+    /**
+     * Nodo successivo in ordine in un albero di n nodi (0 alla fine)
+    */
+    static std::size_t next(std::size_t k, std::size_t n){
+        if(2 * k + 1 <= n){
+            k = 2 * k + 1;
+            while(2 * k <= n)
+                k = 2 * k;
+            return k;
+        }
+        return restore(k);
+    }
+
+    /**
+     * Nodo precedente in ordine in un albero di n nodi (0 prima del
+     * primo); da 0 porta all'ultimo
+    */
+    static std::size_t prev(std::size_t k, std::size_t n){
+        if(k == 0){
+            if(n == 0)
+                return 0;
+            k = 1;
+            while(2 * k + 1 <= n)
+                k = 2 * k + 1;
+            return k;
+        }
+        if(2 * k <= n){
+            k = 2 * k;
+            while(2 * k + 1 <= n)
+                k = 2 * k + 1;
+            return k;
+        }
+        while(k != 0 && (k & 1) == 0)
+            k >>= 1;
+        return k >> 1;
+    }
+
+    /**
+     * Primo nodo in ordine in un albero di n nodi (0 se vuoto)
+    */
+    static std::size_t first(std::size_t n){
+        if(n == 0)
+            return 0;
+        std::size_t k = 1;
+        while(2 * k <= n)
+            k = 2 * k;
+        return k;
+    }
+
+    /**
+     * Discesa senza salti condizionati: a ogni livello il confronto
+     * sceglie il figlio
+    */
+    std::size_t lower_index(const T &value) const {
+        std::size_t n = _data.size();
+        std::size_t k = 1;
+        while(k <= n){
+            prefetch(k * stride);
+            k = 2 * k + (bst_less(_conf, _data[k - 1], value) ? 1 : 0);
+        }
+        return restore(k);
+    }
+
+    std::size_t upper_index(const T &value) const {
+        std::size_t n = _data.size();
+        std::size_t k = 1;
+        while(k <= n){
+            prefetch(k * stride);
+            k = 2 * k + (bst_less(_conf, value, _data[k - 1]) ? 0 : 1);
+        }
+        return restore(k);
+    }
+
+    /**
+     * Cerca tra i valori equivalenti a partire dal primo non minore
+    */
+    std::size_t find_from(std::size_t k, const T &value) const {
+        for(; k != 0 && !bst_less(_conf, value, _data[k - 1]); k = next(k, _data.size())){
+            if(bst_equal(_conf, _eql, _data[k - 1], value))
+                return k;
+        }
+        return 0;
+    }
+
+    /**
+     * Posizione in ordine di ogni nodo k di un albero di n nodi.
+     * La forma dell'albero dipende solo da n.
+    */
+    static std::vector<std::size_t> inorder_ranks(std::size_t n){
+        std::vector<std::size_t> rank(n + 1);
+        std::size_t r = 0;
+        for(std::size_t k = first(n); k != 0; k = next(k, n))
+            rank[k] = r++;
+        return rank;
+    }
+
+public:
+
+    /**
+     * Iteratore costante bidirezionale in ordine crescente
+     *
+     * @brief Iteratore costante dell'albero congelato
+    */
+    class const_iterator{
+
+    private:
+        const frozen_binary_search_tree *_f; // albero visitato
+        std::size_t _k; // nodo corrente, 0 alla fine
+
+        friend class frozen_binary_search_tree;
+
+        const_iterator(const frozen_binary_search_tree *f, std::size_t k) : _f(f), _k(k) {}
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T                         value_type;
+        typedef ptrdiff_t                 difference_type;
+        typedef const T*                  pointer;
+        typedef const T&                  reference;
+
+        const_iterator() : _f(nullptr), _k(0) {}
+
+        const_iterator(const const_iterator &other) : _f(other._f), _k(other._k) {}
+
+        const_iterator& operator=(const const_iterator &other) {
+            _f = other._f;
+            _k = other._k;
+            return *this;
+        }
+
+        ~const_iterator() {}
+
+        /**
+         * Ritorna il dato riferito dall'iteratore (dereferenziamento)
+        */
+        reference operator*() const {
+            return _f->_data[_k - 1];
+        }
+
+        /**
+         * Ritorna il puntatore al dato riferito dall'iteratore
+        */
+        pointer operator->() const {
+            return &(_f->_data[_k - 1]);
+        }
+
+        /**
+         * Operatore di iterazione post-incremento
+        */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * Operatore di iterazione pre-incremento
+        */
+        const_iterator& operator++() {
+            _k = next(_k, _f->_data.size());
+            return *this;
+        }
+
+        /**
+         * Operatore di iterazione post-decremento
+        */
+        const_iterator operator--(int) {
+            const_iterator tmp(*this);
+            --(*this);
+            return tmp;
+        }
+
+        /**
+         * Operatore di iterazione pre-decremento.
+         * Decrementare end() porta all'ultimo elemento.
+        */
+        const_iterator& operator--() {
+            _k = prev(_k, _f->_data.size());
+            return *this;
+        }
+
+        /**
+         * Uguaglianza
+        */
+        bool operator==(const const_iterator &other) const {
+            return _k == other._k;
+        }
+
+        /**
+         * Diversità
+        */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    };
+
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /**
+     * Costruisce la copia congelata di un albero in tempo lineare
+     *
+     * @param tree albero da congelare
+     *
+     * @throw eccezione di copiatura dell'albero
+    */
+    explicit frozen_binary_search_tree(const tree_type &tree) : _data(tree.get_allocator()) {
+        try{
+            std::vector<const T *> sorted;
+            sorted.reserve(tree.size());
+            for(typename tree_type::const_iterator i = tree.begin(); i != tree.end(); ++i)
+                sorted.push_back(&*i);
+
+            // prima le posizioni in ordine dei nodi, poi i valori per livelli
+            std::vector<std::size_t> rank = inorder_ranks(sorted.size());
+            _data.reserve(sorted.size());
+            for(std::size_t k = 1; k <= sorted.size(); ++k)
+                _data.push_back(*sorted[rank[k]]);
+        }
+        catch(...){
+            throw NoTreeCopiedException();
+        }
+    }
+
+    /**
+     * Ritorna un albero modificabile con gli stessi valori, costruito
+     * in tempo lineare senza confronti
+     *
+     * @return albero binario di ricerca
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    tree_type thaw() const {
+        tree_type tmp(_data.get_allocator());
+        tmp.assign(sorted_unique_range, begin(), end());
+        return tmp;
+    }
+
+    /**
+     * Ritorna il numero di elementi
+    */
+    std::size_t size() const {
+        return _data.size();
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento
+    */
+    const_iterator begin() const {
+        return const_iterator(this, first(_data.size()));
+    }
+
+    /**
+     * Ritorna l'iteratore alla fine della sequenza
+    */
+    const_iterator end() const {
+        return const_iterator(this, 0);
+    }
+
+    /**
+     * Ritorna l'iteratore all'ultimo elemento in ordine inverso
+    */
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    /**
+     * Ritorna l'iteratore alla fine della sequenza in ordine inverso
+    */
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento non minore di value
+     *
+     * @param value valore da cercare
+    */
+    const_iterator lower_bound(const T &value) const {
+        return const_iterator(this, lower_index(value));
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento maggiore di value
+     *
+     * @param value valore da cercare
+    */
+    const_iterator upper_bound(const T &value) const {
+        return const_iterator(this, upper_index(value));
+    }
+
+    /**
+     * Cerca un elemento
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore all'elemento, end() se non presente
+    */
+    const_iterator find(const T &value) const {
+        return const_iterator(this, find_from(lower_index(value), value));
+    }
+
+    /**
+     * Determina se esiste un determinato elemento
+     *
+     * @param value valore da cercare
+     *
+     * @return true se esiste l'elemento, false altrimenti
+    */
+    bool contains(const T &value) const {
+        return find_from(lower_index(value), value) != 0;
+    }
+
+    /**
+     * Cerca n valori insieme. Le discese di più chiavi sono intrecciate
+     * in modo che gli accessi alla memoria si sovrappongano. Per int con
+     * confronto naturale (bst_natural_order) scendono insieme quattro
+     * vettori di chiavi, con un confronto vettoriale per vettore a ogni
+     * livello: 32 chiavi con AVX2 (compilando con -mavx2), 16 con SSE2.
+     * Gli altri tipi usano le discese intrecciate scalari.
+     *
+     * @param keys valori da cercare
+     * @param n numero di valori
+     * @param out iteratori risultato, end() per i valori assenti
+    */
+    void find_many(const T *keys, std::size_t n, const_iterator *out) const {
+        find_many(keys, n, out, simd_keys());
+    }
+
+    /**
+     * Nome delle istruzioni usate da find_many per questo albero
+     *
+     * @return "avx2", "sse2" oppure "scalare"
+    */
+    static const char *find_many_path() {
+        if(!simd_keys::value)
+            return "scalare";
+#if defined(__AVX2__)
+        return "avx2";
+#elif defined(__SSE2__)
+        return "sse2";
+#else
+        return "scalare";
+#endif
+    }
+
+private:
+
+    /**
+     * Vero se find_many può confrontare le chiavi come int vettoriali
+    */
+    typedef std::integral_constant<bool,
+        std::is_same<T, int>::value && bst_natural_order<C>::value> simd_keys;
+
+    /**
+     * Converte le posizioni raggiunte dalle discese vettoriali nei risultati
+    */
+    void found_many(const int *res, const T *keys, std::size_t m, const_iterator *out) const {
+        for(std::size_t j = 0; j < m; ++j){
+            std::size_t r = restore((std::size_t)(unsigned int) res[j]);
+            if(r != 0 && !bst_equal(_conf, _eql, _data[r - 1], keys[j]))
+                r = 0;
+            out[j] = const_iterator(this, r);
+        }
+    }
+
+    /**
+     * Ricerca a gruppi generica: lanes discese intrecciate
+    */
+    void find_many(const T *keys, std::size_t n, const_iterator *out, std::false_type) const {
+        std::size_t size = _data.size();
+        std::size_t k[lanes];
+
+        for(std::size_t base = 0; base < n; base += lanes){
+            std::size_t m = (n - base < (std::size_t) lanes) ? n - base : (std::size_t) lanes;
+            for(std::size_t j = 0; j < m; ++j)
+                k[j] = 1;
+
+            bool active = size > 0;
+            while(active){
+                active = false;
+                for(std::size_t j = 0; j < m; ++j){
+                    if(k[j] <= size){
+                        prefetch(k[j] * stride);
+                        k[j] = 2 * k[j] + (bst_less(_conf, _data[k[j] - 1], keys[base + j]) ? 1 : 0);
+                        active = true;
+                    }
+                }
+            }
+
+            for(std::size_t j = 0; j < m; ++j)
+                out[base + j] = const_iterator(this, find_from(restore(k[j]), keys[base + j]));
+        }
+    }
+
+    /**
+     * Ricerca a gruppi per int con confronto naturale
+    */
+    void find_many(const T *keys, std::size_t n, const_iterator *out, std::true_type) const {
+        std::size_t size = _data.size();
+        std::size_t base = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+        if(size < (std::size_t) 1 << 30){
+            unsigned int levels = 0;
+            while(((std::size_t) 1 << levels) <= size)
+                levels++;
+            base = find_many_simd(keys, n, out, levels);
+        }
+#endif
+        if(base < n)
+            find_many(keys + base, n - base, out + base, std::false_type());
+    }
+
+#if defined(__AVX2__)
+    /**
+     * Discese con AVX2: quattro vettori da otto chiavi per volta, le cui
+     * letture a ogni livello sono indipendenti e si sovrappongono
+     *
+     * @return numero di chiavi cercate, multiplo di 32
+    */
+    std::size_t find_many_simd(const T *keys, std::size_t n, const_iterator *out, unsigned int levels) const {
+        const int *data = reinterpret_cast<const int *>(_data.data());
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i limit = _mm256_set1_epi32((int) _data.size() + 1);
+        const std::size_t width = 8;
+        const std::size_t block = 4 * width;
+        std::size_t base = 0;
+
+        for(; base + block <= n; base += block){
+            __m256i x[4], k[4];
+            for(int g = 0; g < 4; ++g){
+                x[g] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + base + g * width));
+                k[g] = one;
+            }
+
+            for(unsigned int l = 0; l < levels; ++l){
+                for(int g = 0; g < 4; ++g){
+                    // solo le discese non ancora uscite dall'albero avanzano
+                    __m256i active = _mm256_cmpgt_epi32(limit, k[g]);
+                    __m256i v = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), data,
+                        _mm256_sub_epi32(k[g], one), active, 4);
+                    __m256i less = _mm256_cmpgt_epi32(x[g], v);
+                    __m256i down = _mm256_sub_epi32(_mm256_slli_epi32(k[g], 1), less);
+                    k[g] = _mm256_blendv_epi8(k[g], down, active);
+                }
+            }
+
+            int res[block];
+            for(int g = 0; g < 4; ++g)
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(res + g * width), k[g]);
+            found_many(res, keys + base, block, out + base);
+        }
+        return base;
+    }
+#elif defined(__SSE2__)
+    /**
+     * Discese con SSE2: quattro vettori da quattro chiavi per volta. SSE2
+     * non ha la lettura indicizzata, quindi i nodi si leggono uno a uno e
+     * solo confronti e passi di discesa sono vettoriali
+     *
+     * @return numero di chiavi cercate, multiplo di 16
+    */
+    std::size_t find_many_simd(const T *keys, std::size_t n, const_iterator *out, unsigned int levels) const {
+        const int *data = reinterpret_cast<const int *>(_data.data());
+        const std::size_t size = _data.size();
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i limit = _mm_set1_epi32((int) size + 1);
+        const std::size_t width = 4;
+        const std::size_t block = 4 * width;
+        std::size_t base = 0;
+
+        for(; base + block <= n; base += block){
+            __m128i x[4], k[4];
+            for(int g = 0; g < 4; ++g){
+                x[g] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + base + g * width));
+                k[g] = one;
+            }
+
+            int res[block];
+            int v[block];
+            for(unsigned int l = 0; l < levels; ++l){
+                for(int g = 0; g < 4; ++g)
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(res + g * width), k[g]);
+                for(std::size_t j = 0; j < block; ++j){
+                    std::size_t i = (std::size_t)(unsigned int) res[j];
+                    v[j] = i <= size ? data[i - 1] : 0;
+                }
+                for(int g = 0; g < 4; ++g){
+                    // solo le discese non ancora uscite dall'albero avanzano
+                    __m128i active = _mm_cmpgt_epi32(limit, k[g]);
+                    __m128i less = _mm_cmpgt_epi32(x[g],
+                        _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + g * width)));
+                    __m128i down = _mm_sub_epi32(_mm_slli_epi32(k[g], 1), less);
+                    k[g] = _mm_or_si128(_mm_and_si128(active, down), _mm_andnot_si128(active, k[g]));
+                }
+            }
+
+            for(int g = 0; g < 4; ++g)
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(res + g * width), k[g]);
+            found_many(res, keys + base, block, out + base);
+        }
+        return base;
+    }
+#endif
+
+};
+
+/**
+ * Overload dell'operatore di stream << per un frozen_binary_search_tree
+ *
+ * @brief Operatore <<
+ *
+ * @return puntatore allo stream
+*/
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F>
+std::ostream &operator<<(std::ostream &os, const frozen_binary_search_tree<T,C,E,B,A,F> &bstree) {
+
+    typename frozen_binary_search_tree<T,C,E,B,A,F>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i)
+        os << *i << " ";
+
+    return os;
+}
+
+/**
+ * Stampa a schermo l'elenco dei valori dell'albero congelato che
+ * soddisfano un predicato.
+ *
+ * @brief Stampa i valori dell'albero che soddisfano un predicato.
+ *
+ * @param bstree albero congelato
+ * @param pred predicato
+*/
+template <typename T, typename C, typename E, typename P, typename B, typename A, unsigned int F>
+void printIF(const frozen_binary_search_tree<T,C,E,B,A,F> &bstree, P pred) {
+
+    typename frozen_binary_search_tree<T,C,E,B,A,F>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i) {
+        if(pred(*i))
+            std::cout << *i << std::endl;
+    }
+
+}
+
+#endif
@@ -1,87 +1,164 @@
 #include <iostream>
 #include "bstree.h"
+#include "persistent_bstree.h"
+#include "bplus_tree.h"
+#include "frozen_bstree.h"
+#include "concurrent_bstree.h"
+#include "concurrent_external_tree.h"
+#include "mapped_bstree.h"
+#include "compact_bstree.h"
+#include "test_types.h"
 #include <cassert> // assert
+#include <cmath> // std::log2
+#include <vector> // std::vector
+#include <list> // std::list
+#include <thread> // std::thread
+#include <algorithm> // std::equal
+#include <functional> // std::less, std::equal_to
+#include <chrono> // std::chrono::steady_clock
+#include <mutex> // std::mutex
+#include <stdexcept> // std::runtime_error
+#include <new> // std::bad_alloc
+#include <sstream> // std::ostringstream, std::stringstream
+#include <fstream> // std::ofstream
+#include <cstdio> // std::remove
 
 /**
- * Struct point che implementa un punto 2D.
+ * Struct che conta le copie e gli spostamenti del dato.
  * 
- * @brief Struct point che implementa un punto 2D.
+ * @brief Dato che conta copie e spostamenti.
 */
-struct point {
-    int x; ///< coordinata x del punto
-    int y; ///< coordinata y del punto
+struct counted {
+	int key; ///< chiave del dato
+
+	static int copies; ///< numero di copie eseguite
+	static int moves; ///< numero di spostamenti eseguiti
+	static int live; ///< numero di istanze esistenti
+	static int created; ///< numero di istanze costruite da una chiave
+
+	counted(int k) : key(k) { live++; created++; }
+	counted(const counted &other) : key(other.key) { copies++; live++; }
+	counted(counted &&other) : key(other.key) { moves++; live++; }
+	~counted() { live--; }
+	counted &operator=(const counted &other) { key = other.key; copies++; return *this; }
+	counted &operator=(counted &&other) { key = other.key; moves++; return *this; }
+};
+
+int counted::copies = 0;
+int counted::moves = 0;
+int counted::live = 0;
+int counted::created = 0;
 
-    point(int xx, int yy) : x(xx), y(yy) {}
+/**
+ * Funtore per l'uguaglianza tra dati counted.
+ * 
+ * @brief Funtore per l'uguaglianza tra dati counted.
+*/
+struct equal_counted {
+	bool operator()(const counted &a, const counted &b) const {
+		return a.key == b.key;
+	}
 };
 
 /**
- * Funtore per l'uguaglianza tra interi.
+ * Funtore per il confronto tra dati counted.
  * 
- * @brief Funtore per l'uguaglianza tra interi.
+ * @brief Funtore per il confronto tra dati counted.
 */
-struct equal_int {
-	bool operator()(const int a, const int b) const {
-		return (a==b);
-	} 
+struct compare_counted {
+	bool operator()(const counted &a, const counted &b) const {
+		return a.key < b.key;
+	}
 };
 
 /**
- * Funtore per il confronto tra interi.
+ * Funtore trasparente per il confronto tra dati counted e chiavi intere.
  * 
- * @brief Funtore per il confronto tra interi.
+ * @brief Funtore trasparente per il confronto tra dati counted.
 */
-struct compare_int {
-	bool operator()(const int a, const int b) const {
-		return (a < b);
-	} 
+struct compare_counted_key {
+	typedef void is_transparent;
+
+	bool operator()(const counted &a, const counted &b) const {
+		return a.key < b.key;
+	}
+	bool operator()(const counted &a, int k) const {
+		return a.key < k;
+	}
+	bool operator()(int k, const counted &b) const {
+		return k < b.key;
+	}
 };
 
 /**
- * Funtore per l'uguaglianza tra stringhe.
+ * Funtore trasparente per l'uguaglianza tra dati counted e chiavi intere.
  * 
- * @brief Funtore per l'uguaglianza tra stringhe.
+ * @brief Funtore trasparente per l'uguaglianza tra dati counted.
 */
-struct equal_string {
-	bool operator()(const std::string &a, const std::string &b) const {
-		return (a==b);
-	} 
+struct equal_counted_key {
+	typedef void is_transparent;
+
+	bool operator()(const counted &a, const counted &b) const {
+		return a.key == b.key;
+	}
+	bool operator()(const counted &a, int k) const {
+		return a.key == k;
+	}
 };
 
 /**
- * Funtore per il confronto tra stringhe.
- * La valutazione è fatta sulla lunghezza.
- * Ritorna true se la prima stringa è più corta della seconda.
+ * Dato counted la cui copia fallisce dopo un numero prefissato di copie,
+ * per verificare che un errore a metà di una modifica non lasci nodi persi.
  * 
- * @brief Funtore per il confronto tra stringhe.
+ * @brief Dato con copia che può fallire.
 */
-struct compare_string {
-	bool operator()(const std::string &a, const std::string &b) const {
-		return (a.size()<b.size());
-	} 
+struct fragile : public counted {
+	static int budget; ///< copie ancora permesse, negativo se illimitate
+
+	fragile(int k) : counted(k) {}
+	fragile(const fragile &other) : counted(other) {
+		if(budget >= 0 && budget-- == 0)
+			throw std::bad_alloc();
+	}
 };
 
+int fragile::budget = -1;
+
 /**
- * Funtore per il confronto di uguaglianza tra due punti.
- * Ritorna true se p1.x != p2.x.
+ * Funtore trasparente per il confronto tra punti e coordinate x.
  * 
- * @brief Funtore per il confronto di due punti.
+ * @brief Funtore trasparente per il confronto tra punti.
 */
-struct equal_point {
-    bool operator()(const point &p1, const point &p2) const {
-        return (p1.x==p2.x) && (p1.y==p2.y);
-    } 
+struct compare_point_x {
+	typedef void is_transparent;
+
+	bool operator()(const point &p1, const point &p2) const {
+		return p1.x < p2.x;
+	}
+	bool operator()(const point &p, int x) const {
+		return p.x < x;
+	}
+	bool operator()(int x, const point &p) const {
+		return x < p.x;
+	}
 };
 
 /**
- * Funtore per il confronto di due punti. 
- * Ritorna true se p1.x < p2.x.
+ * Funtore trasparente per l'uguaglianza tra punti e coordinate x.
+ * Tra due punti confronta entrambe le coordinate, con una coordinata
+ * solo la x.
  * 
- * @brief Funtore per il confronto di due punti.
+ * @brief Funtore trasparente per l'uguaglianza tra punti.
 */
-struct compare_point {
-    bool operator()(const point &p1, const point &p2) const {
-        return (p1.x<p2.x);
-    } 
+struct equal_point_x {
+	typedef void is_transparent;
+
+	bool operator()(const point &p1, const point &p2) const {
+		return (p1.x==p2.x) && (p1.y==p2.y);
+	}
+	bool operator()(const point &p, int x) const {
+		return p.x == x;
+	}
 };
 
 /**
@@ -224,14 +301,14 @@ void test_uso() {
 	std::cout << std::endl;
 	
 	// Funzione di ricerca
-	assert(int_bstree.find(78) == true);
-	assert(int_bstree.find(79) == false);
+	assert(int_bstree.contains(78) == true);
+	assert(int_bstree.contains(79) == false);
 
-	assert(string_bstree.find("aaa") == true);
-	assert(string_bstree.find("eee") == false);
+	assert(string_bstree.contains("aaa") == true);
+	assert(string_bstree.contains("eee") == false);
 
-	assert(point_bstree.find(point(1,2)) == true);
-	assert(point_bstree.find(point(3,4)) == false);
+	assert(point_bstree.contains(point(1,2)) == true);
+	assert(point_bstree.contains(point(3,4)) == false);
 
 	// Funzione di sottoalbero
 	binary_search_tree<int, compare_int, equal_int> int_subbstree = int_bstree.subtree(78);
@@ -342,8 +419,8 @@ void test_funtore_stringhe(void) {
 
 	std::cout << "Dimensione dell'albero: " << str_tree.size() << std::endl;
 
-	std::cout << "Ricerca di 'cip': " << str_tree.find("cip") << std::endl;
-	std::cout << "Ricerca di 'cipp': " << str_tree.find("cipp") << std::endl;
+	std::cout << "Ricerca di 'cip': " << str_tree.contains("cip") << std::endl;
+	std::cout << "Ricerca di 'cipp': " << str_tree.contains("cipp") << std::endl;
 
 	str_tree.clear();
 }
@@ -376,15 +453,2433 @@ void test_tree_point(void) {
 	for(i=point_tree.begin(),ie=point_tree.end(); i!=ie; ++i)
 		std::cout<<*i<<std::endl;
 
-	std::cout << "Ricerca di '(1,1)': " << point_tree.find(point(1,1)) << std::endl;
-	std::cout << "Ricerca di '(2,2)': " << point_tree.find(point(2,2)) << std::endl;
+	std::cout << "Ricerca di '(1,1)': " << point_tree.contains(point(1,1)) << std::endl;
+	std::cout << "Ricerca di '(2,2)': " << point_tree.contains(point(2,2)) << std::endl;
 
 	point_tree.clear();
 }
 
+/**
+ * Inserisce in tree punti con poche x distinte, quindi molti valori
+ * equivalenti per compare_point ma diversi per equal_point, e verifica che
+ * ricerche e rimozioni li trovino anche dopo le ristrutturazioni dell'albero.
+*/
+template <typename Tree>
+void check_equivalent_points(Tree &tree){
+	tree.add(point(1,1));
+	tree.add(point(1,2));
+	tree.add(point(1,3));
+	assert(tree.contains(point(1,1)) && tree.contains(point(1,2)) && tree.contains(point(1,3)));
+	assert(!tree.contains(point(1,4)) && !tree.contains(point(0,1)));
+	tree.clear();
+
+	// y percorre 0..299 in ordine sparso
+	for(int i = 0; i < 300; ++i){
+		int y = (i * 37) % 300;
+		tree.add(point(y % 5, y));
+	}
+	tree.add(point(2, 2));
+	assert(tree.size() == 300);
+	for(int y = 0; y < 300; ++y)
+		assert(tree.contains(point(y % 5, y)) && !tree.contains(point(y % 5, y + 300)));
+	for(int y = 0; y < 300; y += 2)
+		assert(tree.erase(point(y % 5, y)) == 1);
+	for(int y = 0; y < 300; ++y)
+		assert(tree.contains(point(y % 5, y)) == (y % 2 == 1));
+	assert(tree.size() == 150);
+}
+
+/**
+ * Test sulle politiche di bilanciamento.
+ * Inserisce 10M interi ordinati (il caso peggiore per l'albero non bilanciato)
+ * e verifica il limite sull'altezza di ciascuna politica.
+*/
+void test_bilanciamento(void) {
+	std::cout << "******** Test sul bilanciamento ********" << std::endl;
+
+	const int n = 10000000;
+
+	binary_search_tree<int, compare_int, equal_int, red_black_balance> rb_tree;
+	for(int i = 0; i < n; ++i)
+		rb_tree.add(i);
+
+	std::cout << "Altezza red-black con " << n << " interi ordinati: " << rb_tree.height() << std::endl;
+	assert(rb_tree.size() == (unsigned int) n);
+	assert(rb_tree.height() <= 2 * std::log2(n + 1.0));
+	assert(rb_tree.contains(0) && rb_tree.contains(n / 2) && rb_tree.contains(n - 1));
+	assert(!rb_tree.contains(n));
+	rb_tree.clear();
+
+	binary_search_tree<int, compare_int, equal_int, avl_balance> avl_tree;
+	for(int i = 0; i < n; ++i)
+		avl_tree.add(i);
+
+	std::cout << "Altezza AVL con " << n << " interi ordinati: " << avl_tree.height() << std::endl;
+	assert(avl_tree.size() == (unsigned int) n);
+	assert(avl_tree.height() <= 1.4405 * std::log2(n + 2.0));
+	assert(avl_tree.contains(0) && avl_tree.contains(n / 2) && avl_tree.contains(n - 1));
+	avl_tree.clear();
+
+	// l'ordine di visita resta quello del confronto
+	binary_search_tree<int, compare_int, equal_int, avl_balance> small_tree;
+	for(int i = 9; i >= 0; --i)
+		small_tree.add(i);
+	small_tree.add(5);
+
+	int expected = 0;
+	binary_search_tree<int, compare_int, equal_int, avl_balance>::const_iterator i,ie;
+	for(i = small_tree.begin(), ie = small_tree.end(); i != ie; ++i)
+		assert(*i == expected++);
+	assert(expected == 10);
+	assert(small_tree.height() == 4);
+
+	binary_search_tree<int, compare_int, equal_int, avl_balance> sub = small_tree.subtree(3);
+	std::cout << "stampa di small_tree.subtree(3)" << std::endl << sub << std::endl;
+
+	// l'albero di default mantiene la forma data dagli inserimenti
+	binary_search_tree<int, compare_int, equal_int> chain;
+	for(int i = 0; i < 100; ++i)
+		chain.add(i);
+	assert(chain.height() == 100);
+
+	// valori equivalenti ma diversi: le rotazioni li spostano a sinistra
+	binary_search_tree<point, compare_point, equal_point> plain_points;
+	binary_search_tree<point, compare_point, equal_point, avl_balance> avl_points;
+	binary_search_tree<point, compare_point, equal_point, red_black_balance, std::allocator<point>, bst_threaded> rb_points;
+	check_equivalent_points(plain_points);
+	check_equivalent_points(avl_points);
+	check_equivalent_points(rb_points);
+	assert(avl_points.find(point(3, 13)) != avl_points.end() && avl_points.find(point(3, 13))->y == 13);
+	assert(avl_points.subtree_view(point(1, 11)).contains(point(1, 11)));
+}
+
+/**
+ * Test sull'allocatore a pool dei nodi
+*/
+void test_pool_allocator(void) {
+	std::cout << "******** Test sull'allocatore a pool ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int, red_black_balance, pool_allocator<int, 64> > pool_tree;
+
+	pool_tree int_tree;
+	for(int i = 0; i < 1000; ++i)
+		int_tree.add(i);
+	int_tree.add(10); // duplicato: il nodo torna nella free list
+
+	assert(int_tree.size() == 1000);
+	assert(int_tree.contains(999));
+	std::cout << "Blocchi usati per 1000 nodi: " << int_tree.get_allocator().blocks() << std::endl;
+	assert(int_tree.get_allocator().blocks() == 16);
+
+	// la copia usa un'arena propria
+	pool_tree copy(int_tree);
+	assert(copy.size() == 1000);
+	int_tree.clear();
+	assert(int_tree.size() == 0);
+	assert(!int_tree.contains(10));
+	assert(copy.contains(10));
+
+	// dopo il rilascio in blocco l'albero è di nuovo utilizzabile
+	int_tree.add(3);
+	int_tree.add(1);
+	assert(int_tree.size() == 2);
+	std::cout << "stampa di int_tree dopo clear e nuovi inserimenti" << std::endl << int_tree << std::endl;
+
+	pool_tree assigned;
+	assigned = copy;
+	assert(assigned.size() == 1000);
+
+	pool_tree sub = copy.subtree(500);
+	assert(sub.contains(500));
+
+	// T con distruttore: i nodi sono distrutti uno a uno
+	binary_search_tree<std::string, compare_string, equal_string, unbalanced, pool_allocator<std::string> > str_tree;
+	str_tree.add("pippo");
+	str_tree.add("cip");
+	str_tree.add("paperino");
+	assert(str_tree.size() == 3);
+	std::cout << "stampa di str_tree" << std::endl << str_tree << std::endl;
+	str_tree.clear();
+	assert(str_tree.size() == 0);
+
+	binary_search_tree<point, compare_point, equal_point, avl_balance, pool_allocator<point> > point_tree;
+	point_tree.add(point(1,1));
+	point_tree.add(point(0,0));
+	point_tree.add(point(2,7));
+	assert(point_tree.contains(point(0,0)));
+	std::cout << "stampa di point_tree" << std::endl << point_tree << std::endl;
+
+	// allocatore standard esplicito
+	binary_search_tree<int, compare_int, equal_int, unbalanced, std::allocator<int> > std_tree;
+	std_tree.add(1);
+	assert(std_tree.contains(1));
+}
+
+/**
+ * Funzione di supporto che ritorna un albero per valore
+*/
+binary_search_tree<int, compare_int, equal_int> make_int_tree(int n) {
+	binary_search_tree<int, compare_int, equal_int> tmp;
+	for(int i = 0; i < n; ++i)
+		tmp.add(i);
+	return tmp;
+}
+
+/**
+ * Test su spostamento, emplace e trasferimento dei nodi
+*/
+void test_spostamento(void) {
+	std::cout << "******** Test su spostamento e trasferimento dei nodi ********" << std::endl;
+
+	// costruttore e assegnamento per spostamento
+	binary_search_tree<int, compare_int, equal_int> a = make_int_tree(10);
+	assert(a.size() == 10);
+
+	binary_search_tree<int, compare_int, equal_int> b(std::move(a));
+	assert(b.size() == 10);
+	assert(a.size() == 0);
+	assert(!a.contains(3));
+
+	a = std::move(b);
+	assert(a.size() == 10);
+	assert(b.size() == 0);
+
+	b.add(42);
+	swap(a, b);
+	assert(a.size() == 1 && a.contains(42));
+	assert(b.size() == 10 && b.contains(9));
+
+	a.swap(b);
+	assert(a.size() == 10);
+	std::cout << "stampa di a dopo gli scambi" << std::endl << a << std::endl;
+
+	// add per spostamento, emplace e duplicati senza copie
+	binary_search_tree<counted, compare_counted, equal_counted, red_black_balance> c_tree;
+
+	counted::copies = 0;
+	counted::moves = 0;
+
+	c_tree.add(counted(1));
+	assert(counted::copies == 0);
+	assert(counted::moves == 1);
+
+	assert(c_tree.emplace(2));
+	assert(!c_tree.emplace(1));
+	assert(counted::copies == 0);
+	assert(c_tree.size() == 2);
+
+	counted three(3);
+	c_tree.add(three);
+	assert(counted::copies == 1);
+	c_tree.add(three); // duplicato: nessuna copia
+	assert(counted::copies == 1);
+
+	// estrazione e reinserimento senza riallocazione
+	binary_search_tree<counted, compare_counted, equal_counted, red_black_balance> other_tree;
+	counted::moves = 0;
+
+	binary_search_tree<counted, compare_counted, equal_counted, red_black_balance>::node_type nh = c_tree.extract(2);
+	assert(!nh.empty());
+	assert(nh.value().key == 2);
+	assert(c_tree.size() == 2);
+	assert(!c_tree.contains(counted(2)));
+
+	assert(other_tree.insert(std::move(nh)));
+	assert(nh.empty());
+	assert(other_tree.contains(counted(2)));
+	assert(counted::copies == 1 && counted::moves == 0);
+
+	assert(c_tree.extract(7).empty());
+
+	// reinserimento di un duplicato: il nodo resta nel node_type
+	nh = other_tree.extract(2);
+	other_tree.emplace(2);
+	assert(!other_tree.insert(std::move(nh)));
+	assert(!nh.empty());
+
+	// estrazione con ribilanciamento
+	binary_search_tree<int, compare_int, equal_int, avl_balance> avl_tree;
+	for(int i = 0; i < 100; ++i)
+		avl_tree.add(i);
+	for(int i = 0; i < 100; i += 2)
+		assert(!avl_tree.extract(i).empty());
+	assert(avl_tree.size() == 50);
+	assert(avl_tree.height() <= 7);
+	assert(avl_tree.contains(51) && !avl_tree.contains(50));
+
+	// allocatori non compatibili
+	typedef binary_search_tree<int, compare_int, equal_int, unbalanced, pool_allocator<int> > pool_tree;
+	pool_tree p1, p2;
+	p1.add(1);
+	pool_tree::node_type pnh = p1.extract(1);
+	try {
+		p2.insert(std::move(pnh));
+		assert(false);
+	}
+	catch(IncompatibleAllocatorException &) {
+		assert(!pnh.empty());
+	}
+	assert(p1.insert(std::move(pnh)));
+	assert(p1.contains(1));
+}
+
+/**
+ * Test su rimozione, copia e conta iterative e sulla copia parallela
+*/
+void test_copia_iterativa(void) {
+	std::cout << "******** Test su copia e distruzione iterative ********" << std::endl;
+
+	// albero degenere: una catena di nodi tutti a destra
+	binary_search_tree<int, compare_int, equal_int> chain;
+	const int n = 20000;
+	for(int i = 0; i < n; ++i)
+		chain.add(i);
+	assert(chain.height() == (unsigned int) n);
+
+	binary_search_tree<int, compare_int, equal_int> chain_copy(chain);
+	assert(chain_copy.size() == (unsigned int) n);
+	assert(chain_copy.height() == (unsigned int) n);
+	assert(chain_copy.contains(n - 1));
+
+	binary_search_tree<int, compare_int, equal_int> chain_sub = chain.subtree(n / 2);
+	assert(chain_sub.size() == (unsigned int) (n / 2));
+	assert(!chain_sub.contains(n / 2 - 1) && chain_sub.contains(n / 2));
+
+	chain.clear();
+	assert(chain.size() == 0);
+
+	// copia parallela di un albero bilanciato
+	binary_search_tree<int, compare_int, equal_int, red_black_balance> rb_tree;
+	for(int i = 0; i < 100000; ++i)
+		rb_tree.add((i * 7919) % 100000);
+
+	binary_search_tree<int, compare_int, equal_int, red_black_balance> rb_copy = rb_tree.parallel_copy(4);
+	assert(rb_copy.size() == rb_tree.size());
+	assert(rb_copy.height() == rb_tree.height());
+
+	binary_search_tree<int, compare_int, equal_int, red_black_balance>::const_iterator i, ie, j;
+	for(i = rb_tree.begin(), ie = rb_tree.end(), j = rb_copy.begin(); i != ie; ++i, ++j)
+		assert(*i == *j);
+
+	// la copia è indipendente e continua a bilanciarsi
+	rb_copy.add(100000);
+	assert(!rb_tree.contains(100000));
+	assert(rb_copy.extract(0).value() == 0);
+	assert(rb_tree.contains(0));
+
+	// casi limite: albero vuoto, un thread, allocatore non standard
+	binary_search_tree<int, compare_int, equal_int> empty;
+	assert(empty.parallel_copy(4).size() == 0);
+	assert(rb_tree.parallel_copy(1).size() == rb_tree.size());
+
+	binary_search_tree<std::string, compare_string, equal_string, unbalanced, pool_allocator<std::string> > str_tree;
+	str_tree.add("pippo");
+	str_tree.add("cip");
+	assert(str_tree.parallel_copy(4).size() == 2);
+}
+
+/**
+ * Funtore per il confronto tra interi che conta le chiamate.
+ * 
+ * @brief Funtore per il confronto tra interi che conta le chiamate.
+*/
+struct counting_compare_int {
+	static long calls; ///< numero di confronti eseguiti
+
+	bool operator()(const int a, const int b) const {
+		calls++;
+		return (a < b);
+	}
+};
+
+long counting_compare_int::calls = 0;
+
+/**
+ * Test sulla costruzione da sequenze
+*/
+void test_costruzione_da_sequenza(void) {
+	std::cout << "******** Test sulla costruzione da sequenza ********" << std::endl;
+
+	// sequenza ordinata e senza duplicati: nessun confronto
+	const int n = 1000000;
+	std::vector<int> sorted;
+	for(int i = 0; i < n; ++i)
+		sorted.push_back(i);
+
+	counting_compare_int::calls = 0;
+	binary_search_tree<int, counting_compare_int, equal_int> big(sorted_unique_range, sorted.begin(), sorted.end());
+	assert(counting_compare_int::calls == 0);
+	assert(big.size() == (unsigned int) n);
+	assert(big.height() == 20);
+	assert(big.contains(0) && big.contains(n - 1) && !big.contains(n));
+
+	// sequenza ordinata con duplicati, anche con iteratori non ad accesso casuale
+	std::list<int> dup;
+	dup.push_back(1);
+	dup.push_back(1);
+	dup.push_back(2);
+	dup.push_back(5);
+	dup.push_back(5);
+	dup.push_back(5);
+	dup.push_back(8);
+
+	binary_search_tree<int, compare_int, equal_int, red_black_balance> rb_tree(sorted_range, dup.begin(), dup.end());
+	assert(rb_tree.size() == 4);
+	std::cout << "stampa di rb_tree costruito da 1 1 2 5 5 5 8" << std::endl << rb_tree << std::endl;
+
+	// l'albero costruito resta bilanciato con gli inserimenti successivi
+	for(int i = 9; i < 1000; ++i)
+		rb_tree.add(i);
+	assert(rb_tree.height() <= 2 * std::log2(rb_tree.size() + 1.0));
+
+	// sequenza non ordinata
+	int values[] = { 6, 2, 7, 1, 4, 9, 3, 5, 8, 4, 6 };
+	binary_search_tree<int, compare_int, equal_int, avl_balance> avl_tree(values, values + 11);
+	assert(avl_tree.size() == 9);
+	assert(avl_tree.height() == 4);
+
+	int expected = 1;
+	binary_search_tree<int, compare_int, equal_int, avl_balance>::const_iterator i,ie;
+	for(i = avl_tree.begin(), ie = avl_tree.end(); i != ie; ++i)
+		assert(*i == expected++);
+
+	// assign sostituisce il contenuto
+	avl_tree.assign(values, values + 3);
+	assert(avl_tree.size() == 3);
+	assert(avl_tree.contains(7) && !avl_tree.contains(1));
+
+	avl_tree.assign(values, values);
+	assert(avl_tree.size() == 0);
+
+	// tipi custom
+	std::vector<point> points;
+	points.push_back(point(5,4));
+	points.push_back(point(1,1));
+	points.push_back(point(2,7));
+	points.push_back(point(0,0));
+
+	binary_search_tree<point, compare_point, equal_point> point_tree(points.begin(), points.end());
+	assert(point_tree.size() == 4);
+	std::cout << "stampa di point_tree costruito da sequenza" << std::endl << point_tree << std::endl;
+
+	std::vector<std::string> strings;
+	strings.push_back("c");
+	strings.push_back("dd");
+	strings.push_back("aaa");
+
+	binary_search_tree<std::string, compare_string, equal_string> string_tree;
+	string_tree.assign(sorted_unique_range, strings.begin(), strings.end());
+	assert(string_tree.size() == 3 && string_tree.contains("dd"));
+
+	// valori equivalenti ma diversi, ripetuti in punti non adiacenti: la
+	// costruzione bilanciata li deduplica e le ricerche li trovano tutti
+	typedef binary_search_tree<point, compare_point, equal_point, avl_balance> avl_points;
+	std::vector<point> same_x;
+	for(int k = 0; k < 2; ++k)
+		for(int y = 29; y >= 0; --y)
+			same_x.push_back(point(y % 3, y));
+	avl_points built(same_x.begin(), same_x.end());
+	assert(built.size() == 30);
+	for(int y = 0; y < 30; ++y)
+		assert(built.contains(point(y % 3, y)) && !built.contains(point(y % 3, y + 30)));
+
+	std::stringstream data(std::ios::in | std::ios::out | std::ios::binary);
+	built.save(data);
+	avl_points loaded;
+	loaded.load(data);
+	avl_points thawed = built.freeze().thaw();
+	built.erase_if([](const point &p) { return p.y % 2 == 1; });
+	assert(built.size() == 15 && loaded.size() == 30 && thawed.size() == 30);
+	for(int y = 0; y < 30; ++y)
+		assert(built.contains(point(y % 3, y)) == (y % 2 == 0) && loaded.contains(point(y % 3, y)) && thawed.contains(point(y % 3, y)));
+}
+
+/**
+ * Test sulla rimozione degli elementi
+*/
+void test_rimozione(void) {
+	std::cout << "******** Test sulla rimozione ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int, red_black_balance> rb_tree_type;
+
+	rb_tree_type rb_tree;
+	for(int i = 0; i < 1000; ++i)
+		rb_tree.add(i);
+
+	// rimozione per valore
+	assert(rb_tree.erase(500) == 1);
+	assert(rb_tree.erase(500) == 0);
+	assert(!rb_tree.contains(500));
+	assert(rb_tree.size() == 999);
+
+	// rimozione tramite iteratore: gli altri iteratori restano validi
+	rb_tree_type::const_iterator first = rb_tree.begin();
+	rb_tree_type::const_iterator second = first;
+	++second;
+	rb_tree_type::const_iterator next = rb_tree.erase(first);
+	assert(next == second);
+	assert(*next == 1);
+	assert(!rb_tree.contains(0));
+
+	// rimozione di un intervallo piccolo (un elemento alla volta)
+	rb_tree_type::const_iterator from = rb_tree.begin(), to;
+	while(*from != 100)
+		++from;
+	to = from;
+	for(int k = 0; k < 10; ++k)
+		++to;
+	assert(rb_tree.erase(from, to) == to);
+	assert(!rb_tree.contains(100) && !rb_tree.contains(109) && rb_tree.contains(110));
+	assert(rb_tree.size() == 988);
+
+	// rimozione di un intervallo grande (ricostruzione bilanciata)
+	from = rb_tree.begin();
+	while(*from != 200)
+		++from;
+	to = from;
+	while(*to != 900)
+		++to;
+	rb_tree.erase(from, to);
+	assert(rb_tree.size() == 289);
+	assert(rb_tree.contains(199) && !rb_tree.contains(200) && !rb_tree.contains(899) && rb_tree.contains(900));
+	assert(rb_tree.height() <= 2 * std::log2(rb_tree.size() + 1.0));
+
+	// l'albero resta utilizzabile dopo la ricostruzione
+	rb_tree.add(500);
+	assert(rb_tree.erase(500) == 1);
+	rb_tree.erase(rb_tree.begin(), rb_tree.end());
+	assert(rb_tree.size() == 0);
+	assert(rb_tree.begin() == rb_tree.end());
+
+	// rimozione con predicato
+	binary_search_tree<int, compare_int, equal_int> int_tree;
+	int values[] = { 6, 2, 7, 1, 4, 9, 3, 5, 8 };
+	for(int i = 0; i < 9; ++i)
+		int_tree.add(values[i]);
+
+	is_even even;
+	assert(int_tree.erase_if(even) == 4);
+	assert(int_tree.size() == 5);
+	std::cout << "stampa di int_tree dopo erase_if(is_even)" << std::endl << int_tree << std::endl;
+
+	// un predicato che lancia a metà visita lascia tutti i valori
+	binary_search_tree<int, compare_int, equal_int, avl_balance> avl_tree;
+	binary_search_tree<int, compare_int, equal_int, red_black_balance, std::allocator<int>, bst_order_statistics | bst_threaded> os_tree;
+	for(int i = 0; i < 100; ++i){
+		avl_tree.add(i);
+		os_tree.add(i);
+	}
+	int thrown = 0;
+	try{
+		avl_tree.erase_if([](int v) -> bool { if(v == 50) throw std::runtime_error("predicato"); return v % 2 == 0; });
+	}
+	catch(const std::runtime_error &){
+		thrown++;
+	}
+	try{
+		os_tree.erase_if([](int v) -> bool { if(v == 99) throw std::runtime_error("predicato"); return true; });
+	}
+	catch(const std::runtime_error &){
+		thrown++;
+	}
+	assert(thrown == 2 && avl_tree.size() == 100 && os_tree.size() == 100);
+	assert(std::distance(avl_tree.begin(), avl_tree.end()) == 100 && std::distance(os_tree.rbegin(), os_tree.rend()) == 100);
+	for(int i = 0; i < 100; ++i)
+		assert(avl_tree.contains(i) && *os_tree.select(i) == i);
+	assert(avl_tree.height() <= 7 && os_tree.height() <= 7);
+	assert(avl_tree.erase_if(even) == 50 && avl_tree.size() == 50);
+
+	// rimozione della radice e di nodi con due figli senza bilanciamento
+	assert(int_tree.erase(5) == 1);
+	assert(int_tree.erase(3) == 1);
+	std::cout << "stampa di int_tree dopo erase(5) e erase(3)" << std::endl << int_tree << std::endl;
+
+	binary_search_tree<point, compare_point, equal_point, avl_balance> point_tree;
+	point_tree.add(point(1,1));
+	point_tree.add(point(0,0));
+	point_tree.add(point(2,7));
+	assert(point_tree.erase(point(1,1)) == 1);
+	assert(point_tree.size() == 2 && !point_tree.contains(point(1,1)));
+
+	binary_search_tree<std::string, compare_string, equal_string> string_tree;
+	string_tree.add("pippo");
+	string_tree.add("cip");
+	string_tree.add("paperino");
+	assert(string_tree.erase("cip") == 1);
+	assert(string_tree.erase("cipp") == 0);
+	assert(string_tree.size() == 2);
+}
+
+/**
+ * Test sulle statistiche d'ordine
+*/
+void test_statistiche_ordine(void) {
+	std::cout << "******** Test sulle statistiche d'ordine ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int, red_black_balance, std::allocator<int>, bst_order_statistics> os_tree_type;
+
+	os_tree_type os_tree;
+	for(int i = 0; i < 1000; ++i)
+		os_tree.add(i * 2); // valori pari da 0 a 1998
+
+	// rank e select
+	assert(os_tree.rank(0) == 0);
+	assert(os_tree.rank(10) == 5);
+	assert(os_tree.rank(11) == 6);
+	assert(os_tree.rank(5000) == 1000);
+	assert(*os_tree.select(0) == 0);
+	assert(*os_tree.select(500) == 1000);
+	assert(os_tree.select(1000) == os_tree.end());
+
+	// percentile: il valore in posizione 90%
+	std::cout << "Novantesimo percentile: " << *os_tree.select(os_tree.size() * 9 / 10) << std::endl;
+
+	// conta in un intervallo
+	assert(os_tree.count_range(10, 20) == 6);
+	assert(os_tree.count_range(11, 19) == 4);
+	assert(os_tree.count_range(20, 10) == 0);
+	assert(os_tree.count_range(-5, 5000) == 1000);
+
+	// avanzamento dell'iteratore di k posizioni (paginazione)
+	os_tree_type::const_iterator page = os_tree.begin();
+	page += 100;
+	assert(*page == 200);
+	assert(*(page + 50) == 300);
+	assert(page + 900 == os_tree.end());
+	assert(page + 5000 == os_tree.end());
+
+	// le dimensioni restano corrette dopo rimozioni e sottoalberi
+	os_tree.erase(10);
+	os_tree.erase_if(is_plus_than_3());
+	assert(os_tree.size() == 2);
+	assert(os_tree.rank(2) == 1);
+	assert(*os_tree.select(1) == 2);
+
+	for(int i = 0; i < 100; ++i)
+		os_tree.add(i);
+	os_tree_type sub = os_tree.subtree(*os_tree.select(50));
+	assert(sub.size() > 0);
+	assert(*sub.select(sub.size() - 1) == *sub.select(0) + (int) sub.size() - 1);
+
+	// l'avanzamento funziona anche senza statistiche d'ordine, in O(k)
+	binary_search_tree<int, compare_int, equal_int> int_tree;
+	int_tree.add(2);
+	int_tree.add(1);
+	int_tree.add(3);
+	assert(*(int_tree.begin() + 2) == 3);
+
+	binary_search_tree<point, compare_point, equal_point, avl_balance, std::allocator<point>, bst_order_statistics> point_tree;
+	point_tree.add(point(1,1));
+	point_tree.add(point(0,0));
+	point_tree.add(point(2,7));
+	assert(point_tree.rank(point(2,7)) == 2);
+	assert(point_tree.select(1)->y == 1);
+}
+
+/**
+ * Test sulle viste dei sottoalberi
+*/
+void test_viste(void) {
+	std::cout << "******** Test sulle viste dei sottoalberi ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int> int_tree_type;
+
+	int_tree_type int_tree;
+	int values[] = { 6, 2, 7, 1, 4, 9, 3, 5, 8 };
+	for(int i = 0; i < 9; ++i)
+		int_tree.add(values[i]);
+
+	// la vista su 2 contiene 1 2 3 4 5 e non risale al padre 6
+	int_tree_type::view_type view = int_tree.subtree_view(2);
+	assert(!view.empty());
+	assert(view.size() == 5);
+	assert(view.contains(5) && !view.contains(6) && !view.contains(8));
+
+	int expected = 1;
+	for(int_tree_type::const_iterator i = view.begin(), ie = view.end(); i != ie; ++i)
+		assert(*i == expected++);
+	assert(expected == 6);
+
+	std::cout << "stampa della vista su 2" << std::endl << view << std::endl;
+
+	std::cout << "stampa dei valori della vista su 2 che rispettano is_plus_than_3" << std::endl;
+	printIF(view, is_plus_than_3());
+
+	// vista su un nodo che è figlio sinistro: la visita termina al confine
+	int_tree_type::view_type left_view = int_tree.subtree_view(4);
+	assert(left_view.size() == 3);
+	assert(*(left_view.begin() + 2) == 5);
+	assert(left_view.begin() + 3 == left_view.end());
+
+	// vista su una foglia e su un valore assente
+	assert(int_tree.subtree_view(8).size() == 1);
+	int_tree_type::view_type none = int_tree.subtree_view(42);
+	assert(none.empty() && none.size() == 0);
+	assert(none.begin() == none.end());
+
+	// vista sull'intero albero
+	assert(int_tree.subtree_view(6).size() == int_tree.size());
+
+	// con le statistiche d'ordine la dimensione è immediata
+	binary_search_tree<int, compare_int, equal_int, avl_balance, std::allocator<int>, bst_order_statistics> os_tree;
+	for(int i = 0; i < 1000; ++i)
+		os_tree.add(i);
+	assert(os_tree.subtree_view(*os_tree.select(0)).size() == 1);
+	binary_search_tree<int, compare_int, equal_int, avl_balance, std::allocator<int>, bst_order_statistics>::view_type os_view = os_tree.subtree_view(511);
+	std::size_t visited = 0;
+	for(binary_search_tree<int, compare_int, equal_int, avl_balance, std::allocator<int>, bst_order_statistics>::const_iterator i = os_view.begin(); i != os_view.end(); ++i)
+		visited++;
+	assert(os_view.size() == visited);
+
+	binary_search_tree<point, compare_point, equal_point> point_tree;
+	point_tree.add(point(1,1));
+	point_tree.add(point(0,0));
+	point_tree.add(point(2,7));
+	binary_search_tree<point, compare_point, equal_point>::view_type point_view = point_tree.subtree_view(point(0,0));
+	assert(point_view.size() == 1 && point_view.contains(point(0,0)));
+	std::cout << "stampa della vista su (0,0)" << std::endl << point_view << std::endl;
+}
+
+/**
+ * Test sugli snapshot dell'albero persistente
+*/
+void test_persistente(void) {
+	std::cout << "******** Test sull'albero persistente ********" << std::endl;
+
+	typedef persistent_binary_search_tree<int, compare_int, equal_int> ptree_type;
+
+	ptree_type v1;
+	for(int i = 0; i < 1000; ++i)
+		v1.add(i);
+	assert(v1.size() == 1000);
+	assert(v1.height() <= 1.4405 * std::log2(1002.0));
+
+	// snapshot in O(1): le versioni sono indipendenti
+	ptree_type v2 = v1.snapshot();
+	v2.add(1000);
+	assert(v2.erase(0) == 1);
+	assert(v2.erase(0) == 0);
+	assert(v1.size() == 1000 && v1.contains(0) && !v1.contains(1000));
+	assert(v2.size() == 1000 && !v2.contains(0) && v2.contains(1000));
+
+	ptree_type v3;
+	v3 = v2;
+	v3.clear();
+	assert(v3.size() == 0 && v2.size() == 1000);
+
+	int expected = 0;
+	for(ptree_type::const_iterator i = v1.begin(), ie = v1.end(); i != ie; ++i)
+		assert(*i == expected++);
+	assert(expected == 1000);
+
+	// il sottoalbero condivide i nodi
+	ptree_type sub = v1.subtree(511);
+	assert(sub.size() > 0 && sub.contains(511));
+
+	// rimozioni e inserimenti su molte versioni
+	ptree_type small;
+	int values[] = { 6, 2, 7, 1, 4, 9, 3, 5, 8 };
+	for(int i = 0; i < 9; ++i)
+		small.add(values[i]);
+	ptree_type before = small;
+	small.erase(6);
+	small.erase(2);
+	std::cout << "stampa della versione precedente" << std::endl << before << std::endl;
+	std::cout << "stampa della versione dopo erase(6) e erase(2)" << std::endl << small << std::endl;
+	std::cout << "stampa dei valori della versione precedente che rispettano is_even" << std::endl;
+	printIF(before, is_even());
+
+	// lettura di uno snapshot mentre la versione corrente viene modificata
+	ptree_type reader_view = v1;
+	long sum = 0;
+	std::thread reader([&reader_view, &sum]() {
+		for(ptree_type::const_iterator i = reader_view.begin(); i != reader_view.end(); ++i)
+			sum += *i;
+	});
+	for(int i = 1000; i < 2000; ++i)
+		v1.add(i);
+	reader.join();
+	assert(sum == 999L * 1000 / 2);
+	assert(v1.size() == 2000 && reader_view.size() == 1000);
+
+	// la memoria delle versioni viene liberata con l'ultimo riferimento
+	counted::live = 0;
+	{
+		persistent_binary_search_tree<counted, compare_counted, equal_counted> a;
+		for(int i = 0; i < 100; ++i)
+			a.add(counted(i));
+		persistent_binary_search_tree<counted, compare_counted, equal_counted> b = a;
+		for(int i = 0; i < 50; ++i)
+			b.erase(counted(i));
+		a.clear();
+		assert(b.size() == 50);
+		assert(counted::live == 50);
+	}
+	assert(counted::live == 0);
+
+	// una copia che fallisce a metà del percorso o di una rotazione lascia
+	// la versione invariata e non perde nodi
+	{
+		typedef persistent_binary_search_tree<fragile, compare_counted, equal_counted> fragile_tree;
+		fragile_tree a;
+		for(int i = 0; i < 64; ++i)
+			a.add(fragile(i));
+		int failures = 0;
+		for(int k = 0; k < 64; ++k){
+			fragile_tree b = a;
+			for(int budget = 0; ; ++budget){
+				fragile::budget = budget;
+				try{
+					if(k % 2 == 0)
+						b.add(fragile(64 + k));
+					else
+						b.erase(fragile(k));
+					fragile::budget = -1;
+					break;
+				}
+				catch(const NoNodeCreatedException &){
+					fragile::budget = -1;
+					failures++;
+					assert(b.size() == 64 && b.height() == a.height());
+				}
+			}
+			assert(b.size() == (k % 2 == 0 ? 65u : 63u) && a.size() == 64);
+		}
+		assert(failures > 64 && counted::live == 64);
+	}
+	assert(counted::live == 0);
+
+	persistent_binary_search_tree<point, compare_point, equal_point> point_tree;
+	point_tree.add(point(1,1));
+	point_tree.add(point(0,0));
+	persistent_binary_search_tree<point, compare_point, equal_point> point_snapshot = point_tree;
+	point_tree.add(point(2,7));
+	assert(point_tree.size() == 3 && point_snapshot.size() == 2);
+	std::cout << "stampa di point_snapshot" << std::endl << point_snapshot << std::endl;
+
+	// valori equivalenti ma diversi spostati dalle rotazioni del percorso copiato
+	persistent_binary_search_tree<point, compare_point, equal_point> equivalent_points;
+	check_equivalent_points(equivalent_points);
+	persistent_binary_search_tree<point, compare_point, equal_point> equivalent_snapshot = equivalent_points;
+	std::vector<int> order; // y in ordine di visita
+	for(persistent_binary_search_tree<point, compare_point, equal_point>::const_iterator it = equivalent_points.begin(); it != equivalent_points.end(); ++it)
+		order.push_back(it->y);
+	for(std::size_t k = 0; k < order.size(); ++k){
+		persistent_binary_search_tree<point, compare_point, equal_point>::const_iterator it = equivalent_points.find(point(order[k] % 5, order[k]));
+		for(std::size_t j = k; j < order.size(); ++j, ++it)
+			assert(it != equivalent_points.end() && it->y == order[j]);
+		assert(it == equivalent_points.end());
+	}
+	equivalent_points.add(point(3, 3));
+	assert(equivalent_points.size() == 150 && equivalent_snapshot.size() == 150);
+}
+
+/**
+ * Test degli iteratori bidirezionali e delle ricerche per intervallo.
+*/
+void test_iteratori_bidirezionali(){
+	std::cout << "******** Test iteratori bidirezionali ********" << std::endl;
+
+	binary_search_tree<int, compare_int, equal_int, red_black_balance> rb_tree;
+	for(int i = 0; i < 100; ++i)
+		rb_tree.add(i * 2);
+
+	// decremento da end() e visita inversa
+	binary_search_tree<int, compare_int, equal_int, red_black_balance>::const_iterator it = rb_tree.end();
+	--it;
+	assert(*it == 198);
+	it--;
+	assert(*it == 196);
+
+	int expected = 198;
+	binary_search_tree<int, compare_int, equal_int, red_black_balance>::const_reverse_iterator r, re;
+	for(r = rb_tree.rbegin(), re = rb_tree.rend(); r != re; ++r, expected -= 2)
+		assert(*r == expected);
+	assert(expected == -2);
+
+	// find ritorna un iteratore
+	it = rb_tree.find(50);
+	assert(it != rb_tree.end() && *it == 50);
+	assert(*(++it) == 52 && *(--it) == 50 && *(--it) == 48);
+	assert(rb_tree.find(51) == rb_tree.end());
+	assert(rb_tree.contains(50) && !rb_tree.contains(51));
+
+	// lower_bound, upper_bound, equal_range
+	assert(*rb_tree.lower_bound(50) == 50 && *rb_tree.upper_bound(50) == 52);
+	assert(*rb_tree.lower_bound(51) == 52 && *rb_tree.upper_bound(51) == 52);
+	assert(*rb_tree.lower_bound(-5) == 0);
+	assert(rb_tree.lower_bound(199) == rb_tree.end() && rb_tree.upper_bound(198) == rb_tree.end());
+	std::pair<binary_search_tree<int, compare_int, equal_int, red_black_balance>::const_iterator,
+		binary_search_tree<int, compare_int, equal_int, red_black_balance>::const_iterator> range = rb_tree.equal_range(80);
+	assert(*range.first == 80 && *range.second == 82);
+	range = rb_tree.equal_range(81);
+	assert(range.first == range.second);
+
+	// spostamento all'indietro con e senza statistiche d'ordine
+	it = rb_tree.end();
+	it -= 10;
+	assert(*it == 180);
+	it += -5;
+	assert(*it == 170);
+
+	binary_search_tree<int, compare_int, equal_int, avl_balance, std::allocator<int>, bst_order_statistics> os_tree;
+	for(int i = 0; i < 100; ++i)
+		os_tree.add(i);
+	binary_search_tree<int, compare_int, equal_int, avl_balance, std::allocator<int>, bst_order_statistics>::const_iterator os_it = os_tree.end();
+	for(int k = 1; k <= 100; ++k)
+		assert(*(os_tree.end() - k) == 100 - k);
+	os_it = os_tree.find(73);
+	assert(*(os_it - 73) == 0 && *(os_it - 1) == 72 && *(os_it + 26) == 99);
+
+	// viste: la visita inversa resta nel sottoalbero
+	binary_search_tree<int, compare_int, equal_int> int_tree;
+	int values[] = { 50, 30, 70, 20, 40, 60, 80, 35, 45 };
+	for(int i = 0; i < 9; ++i)
+		int_tree.add(values[i]);
+	binary_search_tree<int, compare_int, equal_int>::view_type view = int_tree.subtree_view(30);
+	int view_expected[] = { 45, 40, 35, 30, 20 };
+	int j = 0;
+	for(binary_search_tree<int, compare_int, equal_int>::const_reverse_iterator v = view.rbegin(); v != view.rend(); ++v)
+		assert(*v == view_expected[j++]);
+	assert(j == 5);
+	assert(*view.find(40) == 40 && view.find(60) == view.end() && view.contains(35));
+	assert(*view.lower_bound(36) == 40 && view.upper_bound(45) == view.end());
+	binary_search_tree<int, compare_int, equal_int>::const_iterator first = view.find(20);
+	assert(--first == view.end());
+
+	// stringhe e punti
+	binary_search_tree<std::string, compare_string, equal_string> string_tree;
+	string_tree.add("bb");
+	string_tree.add("a");
+	string_tree.add("ccc");
+	assert(*string_tree.rbegin() == "ccc");
+	assert(*string_tree.lower_bound("xx") == "bb"); // confronto per lunghezza
+	assert(string_tree.find("zz") == string_tree.end());
+
+	binary_search_tree<point, compare_point, equal_point> point_tree;
+	point_tree.add(point(1,1));
+	point_tree.add(point(0,0));
+	point_tree.add(point(2,7));
+	assert(point_tree.find(point(1,1))->x == 1);
+	assert(point_tree.rbegin()->x == 2);
+
+	// albero persistente
+	persistent_binary_search_tree<int, compare_int, equal_int> p_tree;
+	for(int i = 0; i < 10; ++i)
+		p_tree.add(i * 10);
+	persistent_binary_search_tree<int, compare_int, equal_int>::const_iterator p = p_tree.find(40);
+	assert(*p == 40 && *(++p) == 50);
+	assert(p_tree.find(45) == p_tree.end());
+	assert(*p_tree.lower_bound(45) == 50 && *p_tree.upper_bound(50) == 60);
+	int count = 0;
+	for(p = p_tree.lower_bound(35); p != p_tree.end(); ++p)
+		count++;
+	assert(count == 6);
+
+	std::cout << "ultimi tre elementi in ordine inverso: ";
+	for(r = rb_tree.rbegin(); r != rb_tree.rbegin() + 3; ++r)
+		std::cout << *r << " ";
+	std::cout << std::endl;
+}
+
+/**
+ * Test della modalità con collegamenti in ordine (bst_threaded).
+*/
+void test_collegamenti_in_ordine(){
+	std::cout << "******** Test collegamenti in ordine ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int, red_black_balance, std::allocator<int>, bst_threaded> threaded_tree;
+	threaded_tree rb_tree;
+	for(int i = 0; i < 1000; ++i)
+		rb_tree.add((i * 37) % 1000);
+
+	// la visita in ordine e quella inversa seguono i collegamenti
+	int expected = 0;
+	for(threaded_tree::const_iterator i = rb_tree.begin(); i != rb_tree.end(); ++i, ++expected)
+		assert(*i == expected);
+	assert(expected == 1000);
+	for(threaded_tree::const_reverse_iterator r = rb_tree.rbegin(); r != rb_tree.rend(); ++r)
+		assert(*r == --expected);
+
+	// i collegamenti restano corretti dopo le rimozioni e le copie
+	for(int i = 0; i < 1000; i += 3)
+		rb_tree.erase(i);
+	rb_tree.erase_if(is_even());
+	threaded_tree copy = rb_tree;
+	threaded_tree parallel = rb_tree.parallel_copy(4);
+	threaded_tree::const_iterator c = copy.begin(), p = parallel.begin();
+	for(threaded_tree::const_iterator i = rb_tree.begin(); i != rb_tree.end(); ++i, ++c, ++p){
+		assert(*i % 2 == 1 && *i % 3 != 0);
+		assert(*c == *i && *p == *i);
+	}
+	assert(c == copy.end() && p == parallel.end());
+
+	threaded_tree::const_iterator it = rb_tree.find(499);
+	assert(*(--it) == 497 && *(++it) == 499 && *(++it) == 503);
+
+	// vista su un sottoalbero: la visita non esce dal sottoalbero
+	threaded_tree::view_type view = rb_tree.subtree_view(*rb_tree.begin());
+	assert(view.size() == (std::size_t) std::distance(view.begin(), view.end()));
+
+	// sottoalbero copiato e costruzione da sequenza
+	threaded_tree sub = rb_tree.subtree(499);
+	assert(std::distance(sub.begin(), sub.end()) == std::distance(sub.rbegin(), sub.rend()));
+	std::vector<int> values;
+	for(int i = 20; i > 0; --i)
+		values.push_back(i % 7);
+	threaded_tree built(values.begin(), values.end());
+	assert(built.size() == 7 && *built.begin() == 0 && *built.rbegin() == 6);
+
+	binary_search_tree<std::string, compare_string, equal_string, avl_balance, std::allocator<std::string>, bst_threaded> string_tree;
+	string_tree.add("ccc");
+	string_tree.add("a");
+	string_tree.add("bb");
+	string_tree.erase("bb");
+	std::cout << "stampa di string_tree con collegamenti in ordine" << std::endl << string_tree << std::endl;
+}
+
+/**
+ * Test dell'albero B+ con nodi allineati alle linee di cache.
+*/
+void test_bplus(){
+	std::cout << "******** Test albero B+ ********" << std::endl;
+
+	typedef bplus_tree<int, compare_int, equal_int> int_bplus;
+	assert(int_bplus::leaf_fanout >= 32 && int_bplus::inner_fanout >= 16);
+
+	// stessi valori e stesso ordine di binary_search_tree
+	int_bplus b_tree;
+	binary_search_tree<int, compare_int, equal_int, red_black_balance> rb_tree;
+	for(int i = 0; i < 100000; ++i){
+		int v = (i * 7919) % 100003;
+		b_tree.add(v);
+		rb_tree.add(v);
+	}
+	b_tree.add(5);
+	assert(b_tree.size() == rb_tree.size());
+	binary_search_tree<int, compare_int, equal_int, red_black_balance>::const_iterator r = rb_tree.begin();
+	for(int_bplus::const_iterator i = b_tree.begin(); i != b_tree.end(); ++i, ++r)
+		assert(*i == *r);
+	assert(r == rb_tree.end());
+	assert(*b_tree.rbegin() == *rb_tree.rbegin());
+
+	// molti valori per nodo: pochi livelli
+	std::cout << "altezza B+: " << b_tree.height() << ", altezza rosso-nero: " << rb_tree.height() << std::endl;
+	assert(b_tree.height() * 3 <= rb_tree.height());
+
+	assert(b_tree.contains(7919) && !b_tree.contains(100003));
+	assert(*b_tree.find(7919) == 7919 && b_tree.find(-1) == b_tree.end());
+	assert(*b_tree.lower_bound(50000) == *rb_tree.lower_bound(50000));
+	assert(b_tree.lower_bound(100003) == b_tree.end());
+	assert(*b_tree.upper_bound(0) == *rb_tree.upper_bound(0));
+
+	// inserimenti in ordine: le foglie restano piene
+	int_bplus sorted_tree;
+	for(int i = 0; i < 100000; ++i)
+		sorted_tree.add(i);
+	assert(sorted_tree.height() <= 4);
+	int expected = 99999;
+	for(int_bplus::const_reverse_iterator i = sorted_tree.rbegin(); i != sorted_tree.rend(); ++i)
+		assert(*i == expected--);
+
+	// sottoalbero, copia e spostamento
+	int_bplus sub = sorted_tree.subtree(50000);
+	assert(sub.contains(50000) && sub.size() > 0 && sub.size() < sorted_tree.size());
+	int_bplus copy = sorted_tree;
+	int_bplus moved = std::move(copy);
+	assert(moved.size() == 100000 && copy.size() == 0);
+	assert(sorted_tree.subtree(100000).size() == 0);
+
+	// stringhe confrontate per lunghezza: come in binary_search_tree
+	bplus_tree<std::string, compare_string, equal_string> string_tree;
+	binary_search_tree<std::string, compare_string, equal_string> string_bst;
+	const char *words[] = { "cc", "a", "bb", "ddd", "cc", "e" };
+	for(int i = 0; i < 6; ++i){
+		string_tree.add(words[i]);
+		string_bst.add(words[i]);
+	}
+	assert(string_tree.size() == 5 && string_tree.contains("bb") && !string_tree.contains("ff"));
+	binary_search_tree<std::string, compare_string, equal_string>::const_iterator s = string_bst.begin();
+	for(bplus_tree<std::string, compare_string, equal_string>::const_iterator i = string_tree.begin(); i != string_tree.end(); ++i, ++s)
+		assert(*i == *s);
+	std::cout << "stampa di string_tree" << std::endl << string_tree << std::endl;
+
+	bplus_tree<point, compare_point, equal_point, pool_allocator<point> > point_tree;
+	for(int i = 0; i < 1000; ++i)
+		point_tree.add(point(i % 100, i));
+	// stessa x ma y diversa: equivalenti per il confronto, diversi per l'uguaglianza
+	assert(point_tree.size() == 1000 && point_tree.contains(point(42, 942)) && !point_tree.contains(point(42, 43)));
+	std::cout << "stampa dei valori pari di small" << std::endl;
+	int_bplus small;
+	for(int i = 0; i < 20; ++i)
+		small.add(i);
+	printIF(small, is_even());
+
+	// i nodi chiedono linee di cache allineate, anche agli allocatori a pool
+	struct alignas(64) line { char bytes[64]; };
+	aligned_allocator<line> aligned;
+	pool_allocator<line> pooled;
+	line *lines[] = { aligned.allocate(1), aligned.allocate(5), pooled.allocate(1), pooled.allocate(1), pooled.allocate(4) };
+	for(std::size_t k = 0; k < 5; ++k)
+		assert(reinterpret_cast<std::size_t>(lines[k]) % 64 == 0);
+	assert(lines[3] == lines[2] + 1);
+	aligned.deallocate(lines[0], 1);
+	aligned.deallocate(lines[1], 5);
+	pooled.deallocate(lines[2], 1);
+	pooled.deallocate(lines[3], 1);
+	pooled.deallocate(lines[4], 4);
+}
+
+/**
+ * Test dell'albero congelato in ordine di Eytzinger.
+*/
+void test_congelato(){
+	std::cout << "******** Test albero congelato ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int, red_black_balance> rb_type;
+	std::vector<int> values;
+	for(int i = 0; i < 100000; ++i)
+		values.push_back(i * 3);
+	rb_type rb_tree(sorted_unique_range, values.begin(), values.end());
+
+	rb_type::frozen_type frozen = rb_tree.freeze();
+	assert(frozen.size() == rb_tree.size());
+	assert(std::equal(frozen.begin(), frozen.end(), rb_tree.begin()));
+	assert(*frozen.rbegin() == 299997);
+
+	assert(frozen.contains(300) && !frozen.contains(301));
+	assert(*frozen.find(300) == 300 && frozen.find(-3) == frozen.end());
+	assert(*frozen.lower_bound(301) == 303 && *frozen.upper_bound(303) == 306);
+	assert(frozen.lower_bound(299998) == frozen.end());
+	rb_type::frozen_type::const_iterator it = frozen.find(3000);
+	assert(*(--it) == 2997 && *(++it) == 3000 && *(++it) == 3003);
+
+	// ricerca a gruppi: per compare_int il confronto è quello naturale
+	std::vector<int> keys;
+	for(int i = -10; i < 1000; ++i)
+		keys.push_back(i * 7);
+	std::vector<rb_type::frozen_type::const_iterator> out(keys.size());
+	frozen.find_many(keys.data(), keys.size(), out.data());
+	for(std::size_t i = 0; i < keys.size(); ++i){
+		bool present = keys[i] >= 0 && keys[i] % 3 == 0;
+		assert((out[i] != frozen.end()) == present);
+		if(present)
+			assert(*out[i] == keys[i]);
+	}
+	std::cout << "find_many su int: " << rb_type::frozen_type::find_many_path() << std::endl;
+
+	// ritorno a un albero modificabile
+	rb_type thawed = frozen.thaw();
+	thawed.add(1);
+	assert(thawed.size() == rb_tree.size() + 1 && thawed.contains(1) && !frozen.contains(1));
+
+	// tipi non aritmetici: percorso scalare con il funtore di confronto
+	binary_search_tree<std::string, compare_string, equal_string> string_tree;
+	string_tree.add("cc");
+	string_tree.add("a");
+	string_tree.add("bb");
+	string_tree.add("ddd");
+	binary_search_tree<std::string, compare_string, equal_string>::frozen_type frozen_strings = string_tree.freeze();
+	std::string words[] = { "bb", "zz", "ddd" };
+	binary_search_tree<std::string, compare_string, equal_string>::frozen_type::const_iterator found[3];
+	assert(std::string(binary_search_tree<std::string, compare_string, equal_string>::frozen_type::find_many_path()) == "scalare");
+	frozen_strings.find_many(words, 3, found);
+	assert(*found[0] == "bb" && found[1] == frozen_strings.end() && *found[2] == "ddd");
+	std::cout << "stampa di frozen_strings" << std::endl << frozen_strings << std::endl;
+
+	binary_search_tree<point, compare_point, equal_point> point_tree;
+	point_tree.add(point(1,1));
+	point_tree.add(point(0,0));
+	point_tree.add(point(2,7));
+	binary_search_tree<point, compare_point, equal_point>::frozen_type frozen_points = point_tree.freeze();
+	assert(frozen_points.contains(point(2,7)) && !frozen_points.contains(point(2,8)));
+	assert(frozen_points.thaw().size() == 3);
+}
+
+/**
+ * Test delle ricerche eterogenee con funtori trasparenti.
+*/
+void test_ricerca_trasparente(){
+	std::cout << "******** Test ricerca trasparente ********" << std::endl;
+
+	// chiavi intere: nessun counted costruito durante le ricerche
+	binary_search_tree<counted, compare_counted_key, equal_counted_key, avl_balance, std::allocator<counted>, bst_order_statistics> c_tree;
+	for(int i = 0; i < 100; ++i)
+		c_tree.emplace(i * 2);
+	int created = counted::created;
+	assert(c_tree.find(42)->key == 42 && c_tree.find(43) == c_tree.end());
+	assert(c_tree.contains(10) && !c_tree.contains(11));
+	assert(c_tree.lower_bound(43)->key == 44 && c_tree.upper_bound(44)->key == 46);
+	assert(c_tree.equal_range(50).first->key == 50);
+	assert(c_tree.rank(100) == 50 && c_tree.count_range(10, 19) == 5);
+	assert(c_tree.subtree_view(64).contains(64));
+	assert(c_tree.subtree(64).contains(64));
+	assert(counted::created == created);
+
+	// un argomento di tipo T usa ancora la ricerca normale
+	assert(c_tree.contains(counted(42)));
+
+	// stringhe cercate con stringhe C
+	binary_search_tree<std::string, compare_string_key, equal_string_key, red_black_balance> string_tree;
+	string_tree.add("pera");
+	string_tree.add("mela");
+	string_tree.add("kiwi");
+	string_tree.add("uva");
+	assert(*string_tree.find("mela") == "mela" && !string_tree.contains("fico"));
+	assert(*string_tree.lower_bound("n") == "pera");
+	const char buffer[] = "kiwi e uva";
+	assert(string_tree.contains(buffer + 7));
+	std::cout << "stampa di string_tree" << std::endl << string_tree << std::endl;
+
+	// punti cercati per la sola coordinata x
+	binary_search_tree<point, compare_point_x, equal_point_x> point_tree;
+	point_tree.add(point(1,1));
+	point_tree.add(point(0,0));
+	point_tree.add(point(2,7));
+	assert(point_tree.find(2)->y == 7 && point_tree.find(3) == point_tree.end());
+	assert(point_tree.subtree(1).size() == 3);
+	binary_search_tree<point, compare_point_x, equal_point_x>::view_type view = point_tree.subtree_view(0);
+	assert(view.size() == 1 && view.find(0)->y == 0 && !view.contains(1));
+}
+
+/**
+ * Numero di confronti tra stringhe eseguiti dai funtori seguenti.
+*/
+long string_comparisons = 0;
+
+/**
+ * Funtore "minore di" tra stringhe che conta le chiamate.
+ * 
+ * @brief Confronto tra stringhe che conta le chiamate.
+*/
+struct counting_less_string {
+	bool operator()(const std::string &a, const std::string &b) const {
+		string_comparisons++;
+		return a < b;
+	}
+};
+
+/**
+ * Funtore di uguaglianza tra stringhe che conta le chiamate.
+ * 
+ * @brief Uguaglianza tra stringhe che conta le chiamate.
+*/
+struct counting_equal_string {
+	bool operator()(const std::string &a, const std::string &b) const {
+		string_comparisons++;
+		return a == b;
+	}
+};
+
+/**
+ * Funtore di confronto a tre vie tra stringhe che conta le chiamate.
+ * 
+ * @brief Confronto a tre vie tra stringhe che conta le chiamate.
+*/
+struct counting_three_way_string {
+	typedef void is_three_way;
+
+	int operator()(const std::string &a, const std::string &b) const {
+		string_comparisons++;
+		return a.compare(b);
+	}
+};
+
+/**
+ * Funtore di confronto a tre vie tra interi.
+ * 
+ * @brief Confronto a tre vie tra interi.
+*/
+struct three_way_int {
+	typedef void is_three_way;
+
+	int operator()(const int a, const int b) const {
+		return (a < b) ? -1 : (b < a ? 1 : 0);
+	}
+};
+
+/**
+ * Funtore "minore di" tra interi che ritorna un int (0 o 1) invece di bool.
+ * 
+ * @brief Confronto "minore di" con risultato intero.
+*/
+struct int_less_int {
+	int operator()(const int a, const int b) const {
+		return a < b;
+	}
+};
+
+/**
+ * Il confronto a tre vie tra stringhe e l'uguaglianza tra stringhe sono
+ * equivalenti: l'albero può cercare con il solo confronto.
+*/
+template <>
+struct bst_equal_from_order<counting_three_way_string, counting_equal_string> : std::true_type {};
+
+/**
+ * Test del confronto a tre vie con uguaglianza ricavata dal confronto.
+*/
+void test_confronto_tre_vie(){
+	std::cout << "******** Test confronto a tre vie ********" << std::endl;
+
+	std::vector<std::string> words;
+	for(int i = 0; i < 20000; ++i)
+		words.push_back("chiave-" + std::to_string((i * 7919) % 20000));
+
+	binary_search_tree<std::string, counting_less_string, counting_equal_string, red_black_balance> two_functors;
+	binary_search_tree<std::string, counting_three_way_string, bst_derived_equal, red_black_balance> three_way;
+	binary_search_tree<std::string, counting_less_string, bst_derived_equal, red_black_balance> derived_less;
+
+	long counts[3][2];
+
+	string_comparisons = 0;
+	for(std::size_t i = 0; i < words.size(); ++i)
+		two_functors.add(words[i]);
+	counts[0][0] = string_comparisons;
+	string_comparisons = 0;
+	for(std::size_t i = 0; i < words.size(); ++i)
+		assert(two_functors.contains(words[i]));
+	counts[0][1] = string_comparisons;
+
+	string_comparisons = 0;
+	for(std::size_t i = 0; i < words.size(); ++i)
+		three_way.add(words[i]);
+	counts[1][0] = string_comparisons;
+	string_comparisons = 0;
+	for(std::size_t i = 0; i < words.size(); ++i)
+		assert(three_way.contains(words[i]));
+	counts[1][1] = string_comparisons;
+
+	string_comparisons = 0;
+	for(std::size_t i = 0; i < words.size(); ++i)
+		derived_less.add(words[i]);
+	counts[2][0] = string_comparisons;
+	string_comparisons = 0;
+	for(std::size_t i = 0; i < words.size(); ++i)
+		assert(derived_less.contains(words[i]));
+	counts[2][1] = string_comparisons;
+
+	std::cout << "confronti (add, find): due funtori " << counts[0][0] << ", " << counts[0][1]
+		<< "; tre vie " << counts[1][0] << ", " << counts[1][1]
+		<< "; minore di " << counts[2][0] << ", " << counts[2][1] << std::endl;
+
+	// un solo confronto per nodo: circa la metà
+	assert(counts[1][0] * 10 <= counts[0][0] * 6 && counts[1][1] * 10 <= counts[0][1] * 6);
+	assert(counts[2][1] < counts[0][1]);
+
+	assert(std::equal(two_functors.begin(), two_functors.end(), three_way.begin()));
+	assert(std::equal(two_functors.begin(), two_functors.end(), derived_less.begin()));
+	assert(!three_way.contains("chiave") && !derived_less.contains("chiave-20000"));
+
+	// uguaglianza dichiarata equivalente al confronto: basta il solo confronto
+	binary_search_tree<std::string, counting_three_way_string, counting_equal_string, red_black_balance> declared;
+	for(std::size_t i = 0; i < words.size(); ++i)
+		declared.add(words[i]);
+	string_comparisons = 0;
+	for(std::size_t i = 0; i < words.size(); ++i)
+		assert(declared.contains(words[i]));
+	assert(string_comparisons == counts[1][1]);
+
+	// senza is_three_way un risultato intero resta un "minore di"
+	binary_search_tree<int, int_less_int, equal_int, avl_balance> int_less;
+	for(int i = 0; i < 100; ++i)
+		int_less.add((i * 37) % 100);
+	assert(int_less.size() == 100 && *int_less.begin() == 0 && *int_less.rbegin() == 99);
+	assert(int_less.contains(42) && !int_less.contains(100) && *int_less.lower_bound(50) == 50);
+
+	// tutte le operazioni usano il confronto a tre vie
+	binary_search_tree<int, three_way_int, bst_derived_equal, avl_balance, std::allocator<int>, bst_order_statistics> int_tree;
+	for(int i = 0; i < 100; ++i)
+		int_tree.add((i * 37) % 100);
+	assert(int_tree.size() == 100 && *int_tree.begin() == 0 && *int_tree.rbegin() == 99);
+	assert(*int_tree.lower_bound(50) == 50 && *int_tree.upper_bound(50) == 51);
+	assert(int_tree.rank(40) == 40 && int_tree.count_range(10, 19) == 10);
+	assert(int_tree.erase(40) == 1 && !int_tree.contains(40) && int_tree.size() == 99);
+	assert(int_tree.subtree_view(*int_tree.begin()).contains(0));
+	int values[] = { 5, 3, 5, 1 };
+	binary_search_tree<int, three_way_int, bst_derived_equal> built(values, values + 4);
+	assert(built.size() == 3);
+	assert(built.freeze().contains(3) && !built.freeze().contains(4));
+}
+
 /**
  * Funzione MAIN con i vari test.
 */
+void test_lettori_concorrenti(){
+	std::cout << "******** Test lettori concorrenti con uno scrittore ********" << std::endl;
+
+	typedef concurrent_binary_search_tree<int, compare_int, equal_int> ctree_type;
+	const int keys = 20000;
+
+	// i pari restano sempre, i dispari vengono inseriti e tolti dallo scrittore
+	ctree_type tree;
+	for(int i = 0; i < keys; i += 2)
+		tree.add(i);
+	assert(tree.size() == keys / 2);
+
+	std::atomic<bool> stop(false);
+	std::atomic<long> errors(0);
+	std::vector<std::thread> readers;
+	for(int t = 0; t < 8; ++t){
+		readers.push_back(std::thread([&tree, &stop, &errors, t]() {
+			unsigned int seed = t + 1;
+			while(!stop.load()){
+				seed = seed * 1103515245 + 12345;
+				int k = (seed >> 8) % keys;
+				bool hit = tree.contains(k);
+				if(k % 2 == 0 && !hit)
+					errors++;
+
+				ctree_type::const_iterator f = tree.find(k & ~1);
+				if(f == tree.end() || *f != (k & ~1))
+					errors++;
+
+				ctree_type::const_iterator lb = tree.lower_bound(k);
+				if(lb == tree.end() ? k < keys - 1 : (*lb < k || *lb > k + 1))
+					errors++;
+
+				// ogni iterazione vede una versione completa e ordinata
+				if(t == 0){
+					int prev = -1, evens = 0;
+					for(ctree_type::const_iterator i = tree.begin(); i != tree.end(); ++i){
+						if(*i <= prev)
+							errors++;
+						prev = *i;
+						evens += (*i % 2 == 0);
+					}
+					if(evens != keys / 2)
+						errors++;
+				}
+			}
+		}));
+	}
+
+	for(int round = 0; round < 3; ++round){
+		for(int i = 1; i < keys; i += 2)
+			tree.add(i);
+		for(int i = 1; i < keys; i += 2)
+			assert(tree.erase(i) == 1);
+	}
+	stop = true;
+	for(std::size_t t = 0; t < readers.size(); ++t)
+		readers[t].join();
+	assert(errors == 0);
+
+	tree.clear();
+	assert(tree.size() == 0 && tree.begin() == tree.end());
+	for(int i = 0; i < keys; i += 2)
+		tree.add(i);
+	assert(tree.size() == keys / 2 && tree.height() <= 1.4405 * std::log2(keys / 2 + 2.0));
+	int expected = 0;
+	for(ctree_type::const_iterator i = tree.begin(); i != tree.end(); ++i, expected += 2)
+		assert(*i == expected);
+	assert(expected == keys);
+	assert(tree.erase(1) == 0 && !tree.contains(1) && tree.find(1) == tree.end());
+	assert(tree.upper_bound(keys) == tree.end());
+
+	// i nodi sostituiti vengono liberati
+	counted::live = 0;
+	{
+		concurrent_binary_search_tree<counted, compare_counted, equal_counted> c;
+		for(int i = 0; i < 2000; ++i)
+			c.add(counted(i));
+		for(int i = 0; i < 1000; ++i)
+			c.erase(counted(i));
+		assert(c.size() == 1000);
+	}
+	assert(counted::live == 0);
+
+	// valori equivalenti ma diversi spostati dalle rotazioni
+	{
+		typedef concurrent_binary_search_tree<point, compare_point, equal_point> cpoint_type;
+		cpoint_type points;
+		check_equivalent_points(points);
+		std::vector<int> order; // y in ordine di visita
+		for(cpoint_type::const_iterator it = points.begin(); it != points.end(); ++it)
+			order.push_back(it->y);
+		for(std::size_t k = 0; k < order.size(); ++k){
+			cpoint_type::const_iterator it = points.find(point(order[k] % 5, order[k]));
+			for(std::size_t j = k; j < order.size(); ++j, ++it)
+				assert(it != points.end() && it->y == order[j]);
+			assert(it == points.end());
+		}
+	}
+
+	// letture al secondo con uno scrittore attivo
+	std::cout << "letture al secondo (thread lettori: letture)";
+	for(int n = 1; n <= 8; n *= 2){
+		std::atomic<bool> done(false);
+		std::atomic<long> total(0);
+		std::vector<std::thread> pool;
+		for(int t = 0; t < n; ++t){
+			pool.push_back(std::thread([&tree, &done, &total, t]() {
+				long local = 0;
+				unsigned int seed = t + 1;
+				while(!done.load(std::memory_order_relaxed)){
+					seed = seed * 1103515245 + 12345;
+					if(tree.contains((seed >> 8) % keys) || true)
+						local++;
+				}
+				total += local;
+			}));
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		int i = 1;
+		while(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100)){
+			tree.add(i);
+			tree.erase(i);
+			i = (i + 2) % keys;
+		}
+		done = true;
+		for(int t = 0; t < n; ++t)
+			pool[t].join();
+		std::cout << " " << n << ": " << total * 10;
+	}
+	std::cout << std::endl;
+
+	ctree_type small;
+	int values[] = { 6, 2, 7, 1, 4 };
+	for(int i = 0; i < 5; ++i)
+		small.add(values[i]);
+	std::cout << "stampa dell'albero concorrente" << std::endl << small << std::endl;
+	std::cout << "stampa dei valori che rispettano is_even" << std::endl;
+	printIF(small, is_even());
+}
+
+/**
+ * Chiave i-esima di una permutazione di [0, 2^18): le chiavi di ogni
+ * thread sono disgiunte ma arrivano in ordine sparso
+*/
+int scattered_key(int i) {
+	return (int)(((unsigned int)i * 2654435761u) & ((1u << 18) - 1));
+}
+
+/**
+ * Chiave i-esima in ordine crescente
+*/
+int identity_key(int i) {
+	return i;
+}
+
+/**
+ * Esegue f(t) su n thread e ritorna i secondi trascorsi
+*/
+template <typename F>
+double run_threads(int n, F f) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> pool;
+	for(int t = 0; t < n; ++t)
+		pool.push_back(std::thread(f, t));
+	for(int t = 0; t < n; ++t)
+		pool[t].join();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void test_scrittori_concorrenti(){
+	std::cout << "******** Test scrittori concorrenti ********" << std::endl;
+
+	typedef concurrent_external_tree<int, compare_int, equal_int> etree_type;
+	const int keys = 1 << 18;
+
+	// ogni thread inserisce e rimuove chiavi proprie: per quelle chiavi
+	// il risultato deve essere quello di un albero sequenziale
+	etree_type tree;
+	std::atomic<long> errors(0);
+	run_threads(8, [&tree, &errors, keys](int t) {
+		for(int i = t; i < keys; i += 8){
+			int k = scattered_key(i);
+			if(!tree.add(k) || !tree.contains(k) || tree.add(k))
+				errors++;
+			if(i % 3 == 0 && (tree.erase(k) != 1 || tree.contains(k) || tree.erase(k) != 0))
+				errors++;
+		}
+	});
+	assert(errors == 0);
+
+	std::size_t expected = 0;
+	for(int i = 0; i < keys; ++i){
+		bool present = i % 3 != 0;
+		assert(tree.contains(scattered_key(i)) == present);
+		expected += present;
+	}
+	assert(tree.size() == expected);
+
+	int prev = -1;
+	std::size_t visited = 0;
+	for(etree_type::const_iterator i = tree.begin(); i != tree.end(); ++i, ++visited){
+		assert(*i > prev);
+		prev = *i;
+	}
+	assert(visited == expected);
+	assert(*tree.find(scattered_key(1)) == scattered_key(1) && tree.find(scattered_key(3)) == tree.end());
+	assert(*tree.lower_bound(scattered_key(3)) > scattered_key(3) && tree.upper_bound(keys) == tree.end());
+	etree_type::const_iterator lb = tree.lower_bound(scattered_key(1));
+	assert(*lb == scattered_key(1) && *(++lb) > scattered_key(1));
+	assert(*tree.upper_bound(scattered_key(1)) == *lb);
+
+	// una scansione concorrente vede in ordine almeno i valori mai rimossi
+	run_threads(4, [&tree, &errors, keys](int t) {
+		if(t == 0){
+			for(int round = 0; round < 3; ++round){
+				int prev = -1;
+				std::size_t stable = 0;
+				for(etree_type::const_iterator i = tree.begin(); i != tree.end(); ++i){
+					if(*i <= prev)
+						errors++;
+					prev = *i;
+					stable += (*i % 2 == 1);
+				}
+				if(stable < (std::size_t)keys / 4)
+					errors++;
+			}
+			return;
+		}
+		// gli altri thread toccano solo chiavi pari
+		for(int k = 2 * t; k < keys; k += 6){
+			tree.add(k);
+			tree.erase(k);
+		}
+	});
+	assert(errors == 0);
+
+	// chiavi in ordine: le rotazioni del treap tengono l'altezza logaritmica
+	etree_type sorted;
+	const int sorted_keys = 1 << 16;
+	run_threads(4, [&sorted, sorted_keys](int t) {
+		for(int i = t; i < sorted_keys; i += 4)
+			sorted.add(i);
+	});
+	assert(sorted.size() == (std::size_t)sorted_keys);
+	assert(sorted.height() <= 4 * std::log2(sorted_keys));
+	prev = -1;
+	visited = 0;
+	for(etree_type::const_iterator i = sorted.begin(); i != sorted.end(); ++i, ++visited){
+		assert(*i == prev + 1);
+		prev = *i;
+	}
+	assert(visited == (std::size_t)sorted_keys);
+	for(int i = 0; i < sorted_keys; i += 2)
+		assert(sorted.erase(i) == 1);
+	assert(sorted.size() == (std::size_t)sorted_keys / 2 && sorted.contains(1) && !sorted.contains(2));
+	std::cout << "altezza con " << sorted_keys << " chiavi in ordine: " << sorted.height() << std::endl;
+
+	// i nodi staccati vengono liberati
+	counted::live = 0;
+	{
+		concurrent_external_tree<counted, compare_counted, equal_counted> c;
+		for(int i = 0; i < 2000; ++i)
+			c.add(counted(scattered_key(i)));
+		for(int i = 0; i < 1000; ++i)
+			c.erase(counted(scattered_key(i)));
+		assert(c.size() == 1000);
+	}
+	assert(counted::live == 0);
+	{
+		concurrent_external_tree<counted, compare_counted, equal_counted> c;
+		for(int i = 0; i < 2000; ++i)
+			c.add(counted(i));
+		for(int i = 0; i < 2000; i += 2)
+			c.erase(counted(i));
+		assert(c.size() == 1000);
+	}
+	assert(counted::live == 0);
+
+	etree_type small;
+	int values[] = { 6, 2, 7, 1, 4 };
+	for(int i = 0; i < 5; ++i)
+		small.add(values[i]);
+	std::cout << "stampa dell'albero esterno" << std::endl << small << std::endl;
+	std::cout << "stampa dei valori che rispettano is_even" << std::endl;
+	printIF(small, is_even());
+
+	// operazioni al secondo (add, find, erase di 2^18 chiavi disgiunte)
+	// confrontate con un albero AVL protetto da un mutex, con le chiavi
+	// sparse e con ogni thread che inserisce le sue chiavi in ordine
+	std::cout << "operazioni al secondo (thread: esterno / avl con mutex; sparse, in ordine)" << std::endl;
+	for(int n = 1; n <= 16; n *= 2){
+		std::cout << n << ":";
+		for(int order = 0; order < 2; ++order){
+			etree_type ext;
+			binary_search_tree<int, compare_int, equal_int, avl_balance> avl;
+			std::mutex avl_lock;
+			int (*key)(int) = order == 0 ? scattered_key : identity_key;
+
+			double ext_time = run_threads(n, [&ext, key, n, keys](int t) {
+				for(int i = t; i < keys; i += n)
+					ext.add(key(i));
+				for(int i = t; i < keys; i += n)
+					ext.contains(key(i));
+				for(int i = t; i < keys; i += n)
+					ext.erase(key(i));
+			});
+			double avl_time = run_threads(n, [&avl, &avl_lock, key, n, keys](int t) {
+				for(int i = t; i < keys; i += n){
+					std::lock_guard<std::mutex> guard(avl_lock);
+					avl.add(key(i));
+				}
+				for(int i = t; i < keys; i += n){
+					std::lock_guard<std::mutex> guard(avl_lock);
+					avl.contains(key(i));
+				}
+				for(int i = t; i < keys; i += n){
+					std::lock_guard<std::mutex> guard(avl_lock);
+					avl.erase(key(i));
+				}
+			});
+			assert(ext.size() == 0 && avl.size() == 0);
+			std::cout << (order == 0 ? " " : "; ") << (long)(3.0 * keys / ext_time) << " / " << (long)(3.0 * keys / avl_time);
+		}
+		std::cout << std::endl;
+	}
+}
+
+void test_visite_parallele(){
+	std::cout << "******** Test visite parallele ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int, avl_balance> avl_type;
+	avl_type tree;
+	for(int i = 0; i < 200000; ++i)
+		tree.add(scattered_key(i));
+
+	std::vector<int> sequential;
+	for(avl_type::const_iterator i = tree.begin(); i != tree.end(); ++i)
+		if(*i % 3 == 0)
+			sequential.push_back(*i);
+
+	for(unsigned int threads = 1; threads <= 8; threads *= 2){
+		std::atomic<long> sum(0);
+		parallel_for_each(tree, [&sum](int v) { sum += v; }, threads);
+		long expected = 0;
+		for(avl_type::const_iterator i = tree.begin(); i != tree.end(); ++i)
+			expected += *i;
+		assert(sum == expected);
+		assert(parallel_reduce(tree, 0L, [](long a, long b) { return a + b; }, threads) == expected);
+
+		assert(parallel_count_if(tree, [](int v) { return v % 3 == 0; }, threads) == sequential.size());
+
+		std::vector<int> copied;
+		parallel_copy_if(tree, std::back_inserter(copied), [](int v) { return v % 3 == 0; }, threads);
+		assert(copied == sequential);
+	}
+
+	// la riduzione rispetta l'ordine delle chiavi anche se op non è commutativa
+	binary_search_tree<std::string, compare_string_key, equal_string_key> words;
+	std::string expected_text;
+	for(int i = 0; i < 26 * 26; ++i){
+		std::string w;
+		w += (char)('a' + i / 26);
+		w += (char)('a' + i % 26);
+		expected_text += w;
+	}
+	for(int i = 26 * 26 - 1; i >= 0; --i)
+		words.add(expected_text.substr(2 * ((i * 7) % (26 * 26)), 2));
+	std::string text = parallel_reduce(words, std::string(), [](const std::string &a, const std::string &b) { return a + b; }, 4);
+	assert(text == expected_text);
+
+	// un albero degenere resta corretto, anche se non si divide bene
+	binary_search_tree<int, compare_int, equal_int> chain;
+	for(int i = 0; i < 1000; ++i)
+		chain.add(i);
+	assert(parallel_count_if(chain, is_even(), 4) == 500);
+	assert(parallel_reduce(chain, 0, [](int a, int b) { return a > b ? a : b; }, 4) == 999);
+
+	binary_search_tree<int, compare_int, equal_int> empty;
+	assert(parallel_count_if(empty, is_even(), 4) == 0 && parallel_reduce(empty, 7, [](int a, int b) { return a + b; }) == 7);
+
+	// la prima eccezione del predicato arriva al chiamante
+	bool caught = false;
+	try{
+		parallel_count_if(tree, [](int v) -> bool { if(v == scattered_key(100)) throw std::runtime_error("predicato"); return true; }, 4);
+	}
+	catch(const std::runtime_error &){
+		caught = true;
+	}
+	assert(caught);
+
+	binary_search_tree<int, compare_int, equal_int, avl_balance> small;
+	int values[] = { 6, 2, 7, 1, 4, 9, 3, 5, 8 };
+	for(int i = 0; i < 9; ++i)
+		small.add(values[i]);
+	std::cout << "stampa parallela dei valori che rispettano is_even" << std::endl;
+	parallel_printIF(small, is_even(), 4);
+}
+
+/**
+ * Predicato che conta le proprie chiamate
+*/
+struct counting_is_even {
+	long *calls;
+
+	explicit counting_is_even(long *c): calls(c) {}
+
+	bool operator()(int value) const {
+		++*calls;
+		return value % 2 == 0;
+	}
+};
+
+/**
+ * Predicato value > 3 con limiti monotoni, che conta le proprie chiamate.
+ * I limiti seguono l'ordine crescente degli interi: vanno usati solo con
+ * alberi ordinati da compare_int.
+*/
+struct counting_plus_than_3 {
+	long *calls;
+
+	explicit counting_plus_than_3(long *c): calls(c) {}
+
+	bool operator()(int value) const {
+		++*calls;
+		return value > 3;
+	}
+
+	bool below(int value) const {
+		return value <= 3;
+	}
+
+	bool above(int) const {
+		return false;
+	}
+};
+
+void test_interrogazioni_con_limiti(){
+	std::cout << "******** Test interrogazioni con limiti ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int, avl_balance> avl_type;
+	typedef avl_type::interval_type interval;
+	avl_type tree;
+	for(int i = 0; i < (1 << 18); ++i)
+		if(scattered_key(i) < 100000)
+			tree.add(scattered_key(i));
+
+	// solo i valori dell'intervallo vengono passati al predicato
+	long calls = 0;
+	std::vector<int> found;
+	tree.query_if(bst_query(interval::between(1000, 1019), counting_is_even(&calls)), std::back_inserter(found));
+	assert(calls == 20 && found.size() == 10 && found.front() == 1000 && found.back() == 1018);
+
+	calls = 0;
+	found.clear();
+	tree.query_if(counting_is_even(&calls), std::back_inserter(found));
+	assert(calls == 100000 && found.size() == 50000);
+
+	// estremi aperti e chiusi, confrontati con una scansione completa
+	interval intervals[] = {
+		interval::at_least(50000), interval::greater_than(50000),
+		interval::at_most(17), interval::less_than(17),
+		interval::between(-5, 3), interval::between(99990, 300000),
+		interval::between(9, 8)
+	};
+	for(std::size_t k = 0; k < sizeof(intervals) / sizeof(intervals[0]); ++k){
+		std::vector<int> pruned, scanned;
+		tree.query_if(intervals[k], std::back_inserter(pruned));
+		for(avl_type::const_iterator i = tree.begin(); i != tree.end(); ++i)
+			if(intervals[k](*i))
+				scanned.push_back(*i);
+		assert(pruned == scanned);
+	}
+
+	// scrittura su uno stream qualsiasi, anche con un albero non bilanciato
+	binary_search_tree<int, compare_int, equal_int> chain;
+	for(int i = 0; i < 10; ++i)
+		chain.add(i);
+	std::ostringstream out;
+	printIF(chain, is_plus_than_3(), out);
+	assert(out.str() == "4\n5\n6\n7\n8\n9\n");
+	out.str("");
+	calls = 0;
+	printIF(chain, counting_plus_than_3(&calls), out);
+	assert(out.str() == "4\n5\n6\n7\n8\n9\n" && calls == 6);
+	out.str("");
+	printIF(chain, bst_query(interval::less_than(6), is_even()), out);
+	assert(out.str() == "0\n2\n4\n");
+	out.str("");
+	printIF(chain, is_even(), out);
+	assert(out.str() == "0\n2\n4\n6\n8\n");
+}
+
+/**
+ * Ordine decrescente tra interi
+*/
+struct compare_int_desc {
+	bool operator()(const int a, const int b) const {
+		return b < a;
+	}
+};
+
+/**
+ * Buffer che non accetta dati: overflow ereditato fallisce sempre
+*/
+struct refusing_buffer: std::streambuf {};
+
+void test_serializzazione(){
+	std::cout << "******** Test serializzazione binaria ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int, avl_balance> avl_type;
+	typedef binary_search_tree<int, compare_int, equal_int, red_black_balance, std::allocator<int>, bst_threaded> rb_type;
+
+	avl_type tree;
+	for(int i = 0; i < 100000; ++i)
+		tree.add(scattered_key(i));
+
+	// due alberi nello stesso stream: il caricamento non legge oltre il primo
+	std::stringstream data(std::ios::in | std::ios::out | std::ios::binary);
+	tree.save(data);
+	std::size_t first_size = data.str().size();
+	assert(first_size == 28 + 100000 * sizeof(int));
+	avl_type small;
+	small.add(3);
+	small.add(1);
+	small.save(data);
+
+	rb_type loaded;
+	loaded.add(-1);
+	data >> loaded;
+	assert(loaded.size() == tree.size() && std::equal(tree.begin(), tree.end(), loaded.begin()));
+	assert(loaded.height() <= std::log2(100001.0) + 1);
+	assert(*loaded.rbegin() == *tree.rbegin() && !loaded.contains(-1));
+	avl_type second;
+	second.load(data);
+	assert(second.size() == 2 && *second.begin() == 1);
+
+	// stringhe e tipi senza costruttore di default
+	binary_search_tree<std::string, compare_string_key, equal_string_key> words, words_loaded;
+	words.add("pera");
+	words.add("");
+	words.add(std::string(10000, 'x'));
+	std::stringstream text(std::ios::in | std::ios::out | std::ios::binary);
+	words.save(text);
+	text >> words_loaded;
+	assert(words_loaded.size() == 3 && std::equal(words.begin(), words.end(), words_loaded.begin()));
+
+	binary_search_tree<point, compare_point, equal_point> points, points_loaded;
+	points.add(point(1, 2));
+	points.add(point(0, 5));
+	std::stringstream raw(std::ios::in | std::ios::out | std::ios::binary);
+	points.save(raw);
+	points_loaded.load(raw);
+	assert(points_loaded.size() == 2 && points_loaded.begin()->x == 0 && points_loaded.begin()->y == 5);
+
+	// dati non ordinati per il funtore di destinazione: si riordinano
+	std::stringstream again(std::ios::in | std::ios::out | std::ios::binary);
+	tree.save(again);
+	binary_search_tree<int, compare_int_desc, equal_int> reversed;
+	again >> reversed;
+	assert(reversed.size() == tree.size() && *reversed.begin() == *tree.rbegin());
+
+	// stream troncati, di un altro tipo o con un altro ordine dei byte
+	// lasciano l'albero invariato; >> lancia solo se richiesto dallo stream
+	std::string bytes = data.str();
+	std::string swapped = bytes;
+	std::reverse(swapped.begin() + 16, swapped.begin() + 20);
+	std::string cases[] = { bytes.substr(0, 10), bytes.substr(0, first_size - 1), "XSTB" + bytes.substr(4), text.str(), swapped };
+	for(std::size_t k = 0; k < 5; ++k){
+		std::stringstream quiet(cases[k], std::ios::in | std::ios::binary);
+		quiet >> second;
+		assert(quiet.fail() && second.size() == 2);
+
+		std::stringstream bad(cases[k], std::ios::in | std::ios::binary);
+		bad.exceptions(std::ios::failbit);
+		bool caught = false;
+		try{
+			bad >> second;
+		}
+		catch(const NoTreeLoadedException &){
+			caught = true;
+		}
+		assert(caught && bad.fail() && second.size() == 2);
+	}
+
+	// uno stream che rifiuta i dati: save lancia la propria eccezione anche
+	// se lo stream chiede eccezioni su badbit
+	refusing_buffer refusing;
+	std::ostream full(&refusing);
+	full.exceptions(std::ios::badbit);
+	bool refused = false;
+	try{
+		tree.save(full);
+	}
+	catch(const NoTreeSavedException &){
+		refused = true;
+	}
+	assert(refused && full.bad());
+
+	// stessa dimensione ma tipo diverso
+	binary_search_tree<float, std::less<float>, std::equal_to<float> > floats;
+	binary_search_tree<unsigned int, std::less<unsigned int>, std::equal_to<unsigned int> > naturals;
+	std::stringstream as_float(bytes, std::ios::in | std::ios::binary);
+	std::stringstream as_unsigned(bytes, std::ios::in | std::ios::binary);
+	as_float >> floats;
+	as_unsigned >> naturals;
+	assert(as_float.fail() && floats.size() == 0 && as_unsigned.fail() && naturals.size() == 0);
+	assert(bst_serializer<int>::type_tag != bst_serializer<float>::type_tag);
+	assert(bst_serializer<std::string>::type_tag != bst_serializer<point>::type_tag);
+}
+
+/**
+ * Vero se la scrittura di bytes nel file path viene rifiutata da open_image
+*/
+bool image_rejected(const char *path, const std::string &bytes) {
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write(bytes.data(), bytes.size());
+	}
+	try{
+		binary_search_tree<int, compare_int, equal_int>::open_image(path);
+	}
+	catch(const NoTreeLoadedException &){
+		return true;
+	}
+	return false;
+}
+
+void test_immagine_mappata(){
+	std::cout << "******** Test immagine mappata ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int, avl_balance> avl_type;
+	typedef std::chrono::steady_clock clock;
+	const char *path = "test_immagine.bsti";
+	const int keys = 1 << 18;
+
+	avl_type tree;
+	for(int i = 0; i < keys; i += 2)
+		tree.add(scattered_key(i));
+	tree.save_image(path);
+
+	avl_type::image_type image = avl_type::open_image(path);
+	assert(image.size() == tree.size());
+	assert(std::equal(tree.begin(), tree.end(), image.begin()));
+	for(int i = 0; i < 1000; ++i){
+		int k = scattered_key(i);
+		assert(image.contains(k) == tree.contains(k));
+		avl_type::image_type::const_iterator lb = image.lower_bound(k);
+		avl_type::const_iterator tlb = tree.lower_bound(k);
+		assert(lb == image.end() ? tlb == tree.end() : *lb == *tlb);
+		avl_type::image_type::const_iterator ub = image.upper_bound(k);
+		avl_type::const_iterator tub = tree.upper_bound(k);
+		assert(ub == image.end() ? tub == tree.end() : *ub == *tub);
+		avl_type::image_type::const_iterator f = image.find(k);
+		if(f != image.end()){
+			++f;
+			assert(f == image.end() || *f == *tree.upper_bound(k));
+		}
+	}
+	avl_type thawed = image.thaw();
+	assert(thawed.size() == tree.size() && thawed.height() <= std::log2(keys) + 1);
+
+	// immagini vuote e spostamento
+	avl_type empty;
+	empty.save_image(path);
+	avl_type::image_type other = avl_type::open_image(path);
+	assert(other.size() == 0 && other.begin() == other.end() && !other.contains(1));
+	other = std::move(image);
+	assert(other.size() == tree.size() && image.size() == 0 && image.begin() == image.end());
+
+	// intestazione corrotta, file troncato o di un altro tipo
+	binary_search_tree<int, compare_int, equal_int> small;
+	for(int i = 0; i < 10; ++i)
+		small.add(i);
+	small.save_image(path);
+	std::string bytes;
+	{
+		std::ifstream in(path, std::ios::binary);
+		std::ostringstream all;
+		all << in.rdbuf();
+		bytes = all.str();
+	}
+	assert(!image_rejected(path, bytes));
+	std::string corrupted = bytes;
+	corrupted[40] ^= 1;
+	std::string wrong_child = bytes;
+	wrong_child[sizeof(bst_image_header) + sizeof(int)] = 100;
+	assert(image_rejected(path, corrupted));
+	assert(image_rejected(path, bytes.substr(0, bytes.size() - 1)));
+	assert(image_rejected(path, bytes.substr(0, 10)));
+	assert(image_rejected(path, "BSTIMAGE" + bytes.substr(8, 20)));
+	assert(!image_rejected(path, wrong_child));
+	bool caught = false;
+	try{
+		binary_search_tree<int, compare_int, equal_int>::open_image(path).contains(0);
+	}
+	catch(const NoTreeLoadedException &){
+		caught = true;
+	}
+	assert(caught);
+	// un figlio che punta all'indietro creerebbe un ciclo
+	std::string cycle = bytes;
+	const std::int32_t back = -1;
+	cycle.replace(sizeof(bst_image_header) + (bytes.size() - sizeof(bst_image_header)) / 10 + sizeof(int), sizeof(back), reinterpret_cast<const char *>(&back), sizeof(back));
+	assert(!image_rejected(path, cycle));
+	caught = false;
+	try{
+		binary_search_tree<int, compare_int, equal_int>::open_image(path).contains(-5);
+	}
+	catch(const NoTreeLoadedException &){
+		caught = true;
+	}
+	assert(caught);
+	small.save_image(path);
+	caught = false;
+	try{
+		binary_search_tree<point, compare_point, equal_point>::open_image(path);
+	}
+	catch(const NoTreeLoadedException &){
+		caught = true;
+	}
+	assert(caught);
+	caught = false;
+	try{
+		binary_search_tree<int, compare_int, equal_int>::open_image("immagine_inesistente.bsti");
+	}
+	catch(const NoTreeLoadedException &){
+		caught = true;
+	}
+	assert(caught);
+
+	// valori equivalenti ma diversi nella disposizione in ampiezza
+	typedef binary_search_tree<point, compare_point, equal_point, avl_balance> point_type;
+	point_type points;
+	check_equivalent_points(points);
+	points.save_image(path);
+	point_type::image_type point_image = point_type::open_image(path);
+	assert(point_image.size() == 150);
+	for(int y = 0; y < 300; ++y){
+		assert(point_image.contains(point(y % 5, y)) == (y % 2 == 1));
+		assert(!point_image.contains(point(y % 5, y + 300)));
+		point_type::image_type::const_iterator f = point_image.find(point(y % 5, y));
+		assert((f != point_image.end()) == (y % 2 == 1));
+		if(f != point_image.end())
+			assert(std::equal(points.find(point(y % 5, y)), points.end(), f, equal_point()));
+	}
+
+	// tempo di avvio: ricostruzione, caricamento binario, mappatura
+	tree.save_image(path);
+	std::stringstream data(std::ios::in | std::ios::out | std::ios::binary);
+	tree.save(data);
+
+	clock::time_point start = clock::now();
+	avl_type rebuilt;
+	for(avl_type::const_iterator i = tree.begin(), ie = tree.end(); i != ie; ++i)
+		rebuilt.add(*i);
+	bool hit = rebuilt.contains(scattered_key(0));
+	double rebuild_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+	start = clock::now();
+	avl_type loaded;
+	loaded.load(data);
+	hit = loaded.contains(scattered_key(0)) && hit;
+	double load_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+	start = clock::now();
+	avl_type::image_type mapped = avl_type::open_image(path);
+	hit = mapped.contains(scattered_key(0)) && hit;
+	double map_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	assert(hit);
+
+	std::cout << "avvio con " << tree.size() << " chiavi e prima ricerca: ricostruzione " << rebuild_ms
+	          << " ms, caricamento binario " << load_ms << " ms, immagine mappata " << map_ms << " ms" << std::endl;
+
+	std::remove(path);
+}
+
+void test_albero_compatto(){
+	std::cout << "******** Test albero compatto ********" << std::endl;
+
+	typedef compact_binary_search_tree<int, compare_int, equal_int> compact_type;
+	typedef binary_search_tree<int, compare_int, equal_int, avl_balance> avl_type;
+	const int keys = 1 << 18;
+
+	static_assert(std::is_same<decltype(avl_type().size()), std::size_t>::value, "size() a 64 bit");
+	assert(compact_type::node_size() <= 16);
+
+	compact_type tree;
+	avl_type check;
+	tree.reserve(keys / 2);
+	for(int i = 0; i < keys; i += 2){
+		int k = scattered_key(i) % 100000;
+		tree.add(k);
+		check.add(k);
+	}
+	assert(tree.size() == check.size() && tree.capacity() == (std::size_t)keys / 2);
+	tree.add(*check.begin());
+	assert(tree.size() == check.size());
+	assert(std::equal(check.begin(), check.end(), tree.begin()));
+	assert(tree.height() <= 1.45 * std::log2(tree.size() + 2.0));
+
+	// rimozioni: il vettore resta denso e l'albero bilanciato
+	for(int i = 1; i < keys; i += 4){
+		int k = scattered_key(i) % 100000;
+		assert(tree.erase(k) == check.erase(k));
+		assert(tree.size() == check.size());
+	}
+	assert(std::equal(check.begin(), check.end(), tree.begin()));
+	assert(tree.height() <= 1.45 * std::log2(tree.size() + 2.0));
+	for(int k = 0; k < 1000; ++k){
+		assert(tree.contains(k) == check.contains(k));
+		compact_type::const_iterator lb = tree.lower_bound(k);
+		assert(lb == tree.end() ? check.lower_bound(k) == check.end() : *lb == *check.lower_bound(k));
+		compact_type::const_iterator ub = tree.upper_bound(k);
+		assert(ub == tree.end() ? check.upper_bound(k) == check.end() : *ub == *check.upper_bound(k));
+		compact_type::const_iterator f = tree.find(k);
+		assert((f != tree.end()) == check.contains(k));
+		if(f != tree.end() && ++f != tree.end())
+			assert(*f == *check.upper_bound(k));
+	}
+
+	// copia, spostamento, svuotamento
+	compact_type copy(tree);
+	assert(copy.size() == tree.size() && std::equal(tree.begin(), tree.end(), copy.begin()));
+	compact_type moved(std::move(copy));
+	assert(copy.size() == 0 && copy.begin() == copy.end() && moved.size() == tree.size());
+	copy = moved;
+	moved.clear();
+	assert(moved.size() == 0 && !moved.contains(*tree.begin()) && copy.size() == tree.size());
+	while(copy.size() > 0)
+		assert(copy.erase(*copy.begin()) == 1);
+	assert(copy.height() == 0);
+
+	// valori con risorse proprie
+	std::string names[] = { "pera", "mela", "kiwi", "fico", "uva" };
+	compact_binary_search_tree<std::string, compare_string_key, equal_string_key> words(names, names + 5);
+	assert(words.erase("mela") == 1 && words.erase("mela") == 0 && words.size() == 4);
+	assert(*words.begin() == "fico" && words.contains("uva"));
+
+	// valori equivalenti ma diversi: anche compact ritrova il padre del nodo spostato
+	compact_binary_search_tree<point, compare_point, equal_point> points;
+	check_equivalent_points(points);
+	std::vector<point> order(points.begin(), points.end());
+	for(std::size_t k = 0; k < order.size(); ++k){
+		compact_binary_search_tree<point, compare_point, equal_point>::const_iterator f = points.find(order[k]);
+		assert(f != points.end() && std::distance(f, points.end()) == (std::ptrdiff_t)(order.size() - k));
+	}
+	for(std::size_t k = 0; k < order.size(); ++k)
+		assert(points.erase(order[(k * 7) % order.size()]) == 1);
+	assert(points.size() == 0);
+
+	std::cout << "byte per nodo int: " << compact_type::node_size() << ", " << tree.size() << " elementi in "
+	          << tree.capacity() * compact_type::node_size() / 1024 << " KiB" << std::endl;
+}
+
+void test_albero_splay(){
+	std::cout << "******** Test albero splay ********" << std::endl;
+
+	typedef binary_search_tree<int, compare_int, equal_int, splay_balance, std::allocator<int>, bst_order_statistics | bst_threaded> splay_type;
+	typedef binary_search_tree<int, compare_int, equal_int, avl_balance> avl_type;
+	typedef std::chrono::steady_clock clock;
+	const int keys = 1 << 17;
+
+	splay_type tree;
+	avl_type check;
+	for(int i = 0; i < keys; ++i){
+		tree.add(scattered_key(i));
+		check.add(scattered_key(i));
+	}
+	assert(tree.size() == check.size() && std::equal(check.begin(), check.end(), tree.begin()));
+	assert(std::equal(check.rbegin(), check.rend(), tree.rbegin()));
+
+	// il nodo cercato o inserito diventa la radice
+	assert(tree.find(scattered_key(5)) != tree.end());
+	assert(tree.subtree_view(scattered_key(5)).size() == tree.size());
+	assert(tree.contains(scattered_key(7)) && tree.subtree_view(scattered_key(7)).size() == tree.size());
+	tree.add(scattered_key(9));
+	assert(tree.subtree_view(scattered_key(9)).size() == tree.size());
+	tree.add(1 << 20);
+	assert(tree.subtree_view(1 << 20).size() == tree.size() && *tree.select(keys) == 1 << 20);
+	assert(!tree.contains(-1) && tree.subtree_view(*tree.begin()).size() == tree.size());
+
+	// le rotazioni mantengono dimensioni dei sottoalberi e collegamenti in ordine
+	for(int i = 0; i < keys; i += 3)
+		assert(tree.erase(scattered_key(i)) == check.erase(scattered_key(i)));
+	tree.erase(1 << 20);
+	assert(tree.size() == check.size() && std::equal(check.begin(), check.end(), tree.begin()));
+	avl_type::const_iterator expected = check.begin();
+	for(std::size_t k = 0; k < tree.size(); ++k, ++expected)
+		if(k % 997 == 0)
+			assert(*tree.select(k) == *expected && tree.rank(*expected) == k);
+
+	// inserimenti ordinati: una catena che la prima ricerca dimezza
+	splay_type chain;
+	for(int i = 0; i < 100000; ++i)
+		chain.add(i);
+	assert(chain.height() == 100000);
+	assert(chain.contains(0) && chain.height() < 60000);
+
+	// semi-splay: stesse operazioni, solo i nodi profondi si spostano
+	typedef binary_search_tree<int, compare_int, equal_int, semi_splay_balance, std::allocator<int>, bst_order_statistics | bst_threaded> semi_type;
+	semi_type semi;
+	avl_type semi_check;
+	for(int i = 0; i < keys; ++i){
+		semi.add(scattered_key(i));
+		semi_check.add(scattered_key(i));
+	}
+	for(int i = 0; i < keys; i += 3){
+		assert(semi.contains(scattered_key(i + 1)) && !semi.contains(-1 - i));
+		assert(semi.erase(scattered_key(i)) == semi_check.erase(scattered_key(i)));
+	}
+	assert(semi.size() == semi_check.size() && std::equal(semi_check.begin(), semi_check.end(), semi.begin()));
+	assert(std::equal(semi_check.rbegin(), semi_check.rend(), semi.rbegin()));
+	expected = semi_check.begin();
+	for(std::size_t k = 0; k < semi.size(); ++k, ++expected)
+		if(k % 997 == 0)
+			assert(*semi.select(k) == *expected && semi.rank(*expected) == k);
+	semi_type semi_chain;
+	for(int i = 0; i < 100000; ++i)
+		semi_chain.add(i);
+	assert(semi_chain.height() < 10000);
+	for(int i = 0; i < 100000; i += 7)
+		assert(semi_chain.contains(i));
+	assert(semi_chain.height() < 100);
+
+	// valori equivalenti ma diversi: ogni accesso ristruttura l'albero
+	binary_search_tree<point, compare_point, equal_point, splay_balance> splay_points;
+	binary_search_tree<point, compare_point, equal_point, semi_splay_balance, std::allocator<point>, bst_threaded> semi_points;
+	check_equivalent_points(splay_points);
+	check_equivalent_points(semi_points);
+
+	// accessi sbilanciati: l'1% delle chiavi riceve il 90% delle ricerche
+	typedef binary_search_tree<int, counting_compare_int, equal_int, splay_balance> counted_splay;
+	typedef binary_search_tree<int, counting_compare_int, equal_int, semi_splay_balance> counted_semi;
+	typedef binary_search_tree<int, counting_compare_int, equal_int, avl_balance> counted_avl;
+	counted_splay skewed_splay;
+	counted_semi skewed_semi;
+	counted_avl skewed_avl;
+	for(int i = 0; i < keys; ++i){
+		skewed_splay.add(scattered_key(i));
+		skewed_semi.add(scattered_key(i));
+		skewed_avl.add(scattered_key(i));
+	}
+	std::vector<int> lookups;
+	for(int i = 0; i < 1000000; ++i){
+		int r = scattered_key(i % keys);
+		lookups.push_back(r % 10 != 0 ? scattered_key(r % (keys / 100) * 100) : scattered_key(r % keys));
+	}
+
+	std::size_t hits = 0;
+	counting_compare_int::calls = 0;
+	clock::time_point start = clock::now();
+	for(std::size_t i = 0; i < lookups.size(); ++i)
+		hits += skewed_splay.contains(lookups[i]);
+	double splay_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	long splay_calls = counting_compare_int::calls;
+
+	counting_compare_int::calls = 0;
+	start = clock::now();
+	for(std::size_t i = 0; i < lookups.size(); ++i)
+		hits -= skewed_semi.contains(lookups[i]);
+	double semi_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	long semi_calls = counting_compare_int::calls;
+
+	counting_compare_int::calls = 0;
+	start = clock::now();
+	for(std::size_t i = 0; i < lookups.size(); ++i)
+		hits += skewed_avl.contains(lookups[i]);
+	double avl_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	long avl_calls = counting_compare_int::calls;
+
+	assert(hits == lookups.size() && splay_calls < avl_calls && semi_calls < avl_calls);
+	std::cout << "1M ricerche sbilanciate, confronti per ricerca e tempo: splay " << splay_calls / 1e6 << " in " << splay_ms
+	          << " ms, semi-splay " << semi_calls / 1e6 << " in " << semi_ms
+	          << " ms, avl " << avl_calls / 1e6 << " in " << avl_ms << " ms" << std::endl;
+}
+
+void test_ricerca_con_dito(){
+	std::cout << "******** Test ricerca con dito ********" << std::endl;
+
+	typedef binary_search_tree<int, counting_compare_int, equal_int, avl_balance> avl_type;
+	typedef binary_search_tree<int, compare_int, equal_int, red_black_balance, std::allocator<int>, bst_order_statistics | bst_threaded> rb_type;
+	typedef std::chrono::steady_clock clock;
+	const int n = 100000;
+
+	// suggerimenti qualsiasi: il risultato non cambia
+	rb_type hinted, check;
+	rb_type::const_iterator hint = hinted.end();
+	for(int i = 0; i < n; ++i){
+		int k = scattered_key(i) % 50000;
+		rb_type::const_iterator pos = hinted.add(i % 3 == 0 ? hinted.begin() : hint, k);
+		check.add(k);
+		assert(*pos == k);
+		if(i % 7 == 0)
+			hint = pos;
+	}
+	assert(hinted.size() == check.size() && std::equal(check.begin(), check.end(), hinted.begin()));
+	assert(hinted.height() <= 2 * std::log2(hinted.size() + 1.0));
+	assert(*hinted.select(hinted.size() / 2) == *check.select(check.size() / 2));
+
+	// suggerimenti di un altro albero o di una vista: la ricerca parte dalla radice
+	rb_type other, mine;
+	for(int i = 0; i < 100; i += 2){
+		other.add(i);
+		mine.add(i + 1);
+	}
+	rb_type::const_iterator foreign = mine.add(other.find(50), 10);
+	rb_type::const_iterator from_end = mine.add(other.end(), 1000);
+	rb_type::view_type view = mine.subtree_view(*mine.select(mine.size() / 2));
+	rb_type::const_iterator from_view = mine.add(view.begin(), -3);
+	rb_type::const_iterator from_view_end = mine.add(view.end(), 2000);
+	assert(*foreign == 10 && *from_end == 1000 && *from_view == -3 && *from_view_end == 2000);
+	assert(mine.size() == 54 && other.size() == 50 && *other.rbegin() == 98);
+	assert(*mine.begin() == -3 && *mine.rbegin() == 2000 && *mine.select(1) == 1 && mine.rank(10) == 6);
+	assert(std::is_sorted(mine.begin(), mine.end()) && std::is_sorted(other.begin(), other.end()));
+
+	// inserimenti ordinati con il suggerimento precedente: pochi confronti
+	avl_type sorted, plain;
+	counting_compare_int::calls = 0;
+	clock::time_point start = clock::now();
+	avl_type::const_iterator last = sorted.end();
+	for(int i = 0; i < n; ++i)
+		last = sorted.add(last, i);
+	double hinted_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	long hinted_calls = counting_compare_int::calls;
+
+	counting_compare_int::calls = 0;
+	start = clock::now();
+	for(int i = 0; i < n; ++i)
+		plain.add(i);
+	double plain_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	long plain_calls = counting_compare_int::calls;
+	assert(sorted.size() == (std::size_t)n && std::equal(plain.begin(), plain.end(), sorted.begin()));
+	assert(hinted_calls * 4 < plain_calls);
+
+	// dito su una finestra scorrevole, con ricerche riuscite e fallite
+	rb_type sparse;
+	for(int i = 0; i < n; i += 3)
+		sparse.add(i);
+	rb_type::finger_type finger = sparse.finger();
+	assert(finger.position() == sparse.end());
+	for(int i = 0; i < n; i += 2){
+		int k = i + (i % 10) - 5;
+		assert(finger.contains(k) == sparse.contains(k));
+		rb_type::const_iterator lb = finger.lower_bound(k);
+		assert(lb == sparse.lower_bound(k));
+		if(lb != sparse.end())
+			assert(finger.position() == lb);
+	}
+	assert(finger.lower_bound(n + 10) == sparse.end() && finger.lower_bound(-10) == sparse.begin());
+	assert(*finger.add(n + 10) == n + 10 && sparse.contains(n + 10));
+	finger.add(1);
+	for(int i = 0; i < 300; i += 3)
+		sparse.erase(i);
+	assert(finger.find(1) == sparse.find(1) && finger.find(301) == sparse.end() && finger.contains(303));
+
+	// dito con ricerche vicine: confronti per ricerca
+	avl_type::finger_type near = plain.finger();
+	counting_compare_int::calls = 0;
+	std::size_t hits = 0;
+	for(int i = 0; i < n; ++i)
+		hits += near.contains(i + scattered_key(i) % 16);
+	long finger_calls = counting_compare_int::calls;
+	counting_compare_int::calls = 0;
+	for(int i = 0; i < n; ++i)
+		hits -= plain.contains(i + scattered_key(i) % 16);
+	long root_calls = counting_compare_int::calls;
+	assert(hits == 0 && finger_calls < root_calls);
+
+	std::cout << "100000 inserimenti ordinati: con suggerimento " << hinted_calls / (double)n << " confronti, " << hinted_ms
+	          << " ms; dalla radice " << plain_calls / (double)n << " confronti, " << plain_ms << " ms" << std::endl;
+	std::cout << "ricerche vicine, confronti per ricerca: dito " << finger_calls / (double)n
+	          << ", dalla radice " << root_calls / (double)n << std::endl;
+}
+
 int main(int argc, char const *argv[]) {
 
     // variabili 
@@ -397,6 +2892,30 @@ int main(int argc, char const *argv[]) {
     test_funtore_stringhe();
     test_tree_point();
 	test_uso();
+	test_bilanciamento();
+	test_pool_allocator();
+	test_spostamento();
+	test_copia_iterativa();
+	test_costruzione_da_sequenza();
+	test_rimozione();
+	test_statistiche_ordine();
+	test_viste();
+	test_persistente();
+	test_iteratori_bidirezionali();
+	test_collegamenti_in_ordine();
+	test_bplus();
+	test_congelato();
+	test_ricerca_trasparente();
+	test_confronto_tre_vie();
+	test_lettori_concorrenti();
+	test_scrittori_concorrenti();
+	test_visite_parallele();
+	test_interrogazioni_con_limiti();
+	test_serializzazione();
+	test_immagine_mappata();
+	test_albero_compatto();
+	test_albero_splay();
+	test_ricerca_con_dito();
 
 	// pulizia
 	int_test_tree.clear();
@@ -0,0 +1,673 @@
+#ifndef MAPPED_BSTREE_H
+#define MAPPED_BSTREE_H
+
+#include <ostream>
+#include <iostream>
+#include <iterator> // std::forward_iterator_tag
+#include <cstddef>  // std::ptrdiff_t, std::size_t
+#include <cstdint>  // std::int32_t, std::uint32_t, std::uint64_t
+#include <cstring>  // std::memcpy, std::memcmp
+#include <cstdio>   // std::rename, std::remove
+#include <string>
+#include <type_traits> // std::is_trivially_copyable
+#include <fcntl.h>  // open
+#include <unistd.h> // close, ftruncate, fsync
+#include <sys/mman.h> // mmap, munmap, madvise
+#include <sys/stat.h> // fstat
+#include "bstree.h"
+
+/**
+ * Intestazione di un'immagine su file di un albero. Occupa 64 byte ed è
+ * protetta da un checksum, così un file troncato, corrotto o scritto per un
+ * altro tipo viene rifiutato all'apertura senza leggere i nodi.
+ *
+ * @brief Intestazione dell'immagine di un albero
+*/
+struct bst_image_header {
+    enum { version = 1 };
+
+    char magic[8]; // "BSTIMAGE"
+    std::uint32_t format; // versione del formato
+    std::uint32_t value_size; // sizeof(T)
+    std::uint32_t node_size; // dimensione di un nodo
+    std::uint32_t reserved; // zero
+    std::uint64_t count; // numero di nodi
+    std::uint64_t root; // indice della radice
+    std::uint64_t nodes_offset; // posizione del primo nodo nel file
+    std::uint64_t file_size; // dimensione del file
+    std::uint64_t checksum; // FNV-1a dei campi precedenti
+
+    /**
+     * Checksum FNV-1a a 64 bit di tutti i campi tranne checksum
+    */
+    std::uint64_t compute_checksum() const {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(this);
+        std::uint64_t h = 14695981039346656037ULL;
+        for(std::size_t i = 0; i < offsetof(bst_image_header, checksum); ++i) {
+            h ^= p[i];
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    /**
+     * Verifica l'intestazione di un file di file_bytes byte
+    */
+    bool valid(std::uint32_t vsize, std::uint32_t nsize, std::uint64_t file_bytes) const {
+        return std::memcmp(magic, "BSTIMAGE", 8) == 0 && format == version &&
+               value_size == vsize && node_size == nsize && reserved == 0 &&
+               file_size == file_bytes && nodes_offset == sizeof(bst_image_header) &&
+               count <= (file_size - nodes_offset) / node_size &&
+               file_size == nodes_offset + count * node_size &&
+               (count == 0 || root < count) && checksum == compute_checksum();
+    }
+};
+
+/**
+ * Albero in sola lettura memorizzato in un file e mappato in memoria.
+ * I nodi non contengono puntatori: ogni figlio è indicato dalla distanza
+ * (in nodi) dal padre, quindi il file può essere mappato a qualsiasi
+ * indirizzo e interrogato subito dopo l'apertura, mentre il sistema
+ * operativo carica solo le pagine dei nodi visitati.
+ *
+ * L'immagine si scrive con binary_search_tree::save_image, che dispone i
+ * nodi come un albero perfettamente bilanciato in ordine di visita in
+ * ampiezza: i primi livelli, toccati da ogni ricerca, stanno nelle prime
+ * pagine del file. Si apre con binary_search_tree::open_image e si torna a
+ * un albero modificabile con thaw(). La mappatura è privata e in sola
+ * lettura. T deve essere banalmente copiabile e i byte sono nell'ordine
+ * della macchina che scrive. Valori equivalenti per C ma diversi per E
+ * sono ammessi: se una ricerca arriva accanto a valori equivalenti, li
+ * scorre tutti prima di concludere che il valore manca.
+ *
+ * @brief Albero mappato da un file
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ * @param B politica di bilanciamento dell'albero restituito da thaw()
+ * @param A allocatore dell'albero restituito da thaw()
+ * @param F funzionalità opzionali dell'albero restituito da thaw()
+*/
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F>
+class mapped_binary_search_tree {
+
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "l'immagine su file richiede un tipo banalmente copiabile");
+
+public:
+
+    typedef binary_search_tree<T,C,E,B,A,F> tree_type;
+
+private:
+
+    /**
+     * Nodo dell'immagine: i figli sono distanze relative, 0 se assenti
+     *
+     * @brief Nodo dell'immagine
+    */
+    struct node {
+        T value; // valore del dato
+        std::int32_t left; // distanza del figlio sinistro
+        std::int32_t right; // distanza del figlio destro
+    };
+
+    /**
+     * Altezza massima accettata: un albero scritto da save_image con meno
+     * di 2^31 nodi è alto al più 32
+    */
+    enum { max_height = 64 };
+
+    void *_map; // inizio della mappatura
+    std::size_t _length; // lunghezza della mappatura
+    const node *_nodes; // primo nodo
+    std::uint64_t _count; // numero di nodi
+    const node *_root; // radice, nullptr se vuoto
+
+    C _conf; // oggetto funtore per il confronto
+    E _eql; // oggetto funtore per l'uguaglianza
+
+    mapped_binary_search_tree(const mapped_binary_search_tree &);
+    mapped_binary_search_tree &operator=(const mapped_binary_search_tree &);
+
+    /**
+     * Figlio di n, con il controllo che resti dentro il file.
+     * In ampiezza ogni figlio segue il padre, quindi una distanza negativa
+     * indica un file corrotto e, se accettata, potrebbe creare un ciclo
+     *
+     * @throw NoTreeLoadedException se la distanza è negativa o esce dall'immagine
+    */
+    const node *child(const node *n, bool left) const {
+        std::int32_t offset = left ? n->left : n->right;
+        if(offset == 0)
+            return nullptr;
+        if(offset < 0)
+            throw NoTreeLoadedException();
+
+        std::uint64_t i = (std::uint64_t)(n - _nodes) + (std::uint64_t)(std::int64_t)offset;
+        if(i >= _count)
+            throw NoTreeLoadedException();
+        return _nodes + i;
+    }
+
+    /**
+     * Primo nodo in ordine nella disposizione in ampiezza di n nodi
+    */
+    static std::uint64_t first(std::uint64_t n) {
+        std::uint64_t k = n == 0 ? 0 : 1;
+        while(k != 0 && 2 * k <= n)
+            k = 2 * k;
+        return k;
+    }
+
+    /**
+     * Nodo successivo a k in ordine, 0 dopo l'ultimo
+    */
+    static std::uint64_t next(std::uint64_t k, std::uint64_t n) {
+        if(2 * k + 1 <= n) {
+            k = 2 * k + 1;
+            while(2 * k <= n)
+                k = 2 * k;
+            return k;
+        }
+        while(k & 1)
+            k >>= 1;
+        return k >> 1;
+    }
+
+    /**
+     * Indica se una discesa senza esito è passata per valori equivalenti a
+     * value. L'immagine è in ordine, ma la disposizione bilanciata può
+     * mettere l'uguale nell'altro ramo di un equivalente: i valori
+     * equivalenti restano contigui e terminano in pred, l'ultimo nodo
+     * lasciato a sinistra.
+    */
+    bool equivalent_miss(const node *pred, const T &value) const {
+        return !bst_equal_from_order<C, E>::value && pred != nullptr &&
+            !bst_less(_conf, pred->value, value);
+    }
+
+    void unmap() {
+        if(_map != nullptr)
+            ::munmap(_map, _length);
+        _map = nullptr;
+        _length = 0;
+        _nodes = nullptr;
+        _count = 0;
+        _root = nullptr;
+    }
+
+public:
+
+    /**
+     * Costruttore di default: immagine vuota
+    */
+    mapped_binary_search_tree(): _map(nullptr), _length(0), _nodes(nullptr), _count(0), _root(nullptr) {}
+
+    /**
+     * Apre e mappa in memoria un'immagine scritta da save_image. Viene
+     * letta solo l'intestazione; i nodi sono caricati alla prima visita.
+     *
+     * @param path percorso del file
+     *
+     * @throw NoTreeLoadedException se il file manca o l'intestazione non è valida
+    */
+    explicit mapped_binary_search_tree(const char *path) : mapped_binary_search_tree() {
+        int fd = ::open(path, O_RDONLY);
+        if(fd < 0)
+            throw NoTreeLoadedException();
+
+        struct stat st;
+        if(::fstat(fd, &st) != 0 || (std::uint64_t)st.st_size < sizeof(bst_image_header)) {
+            ::close(fd);
+            throw NoTreeLoadedException();
+        }
+
+        void *map = ::mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(map == MAP_FAILED)
+            throw NoTreeLoadedException();
+
+        _map = map;
+        _length = (std::size_t)st.st_size;
+
+        const bst_image_header *h = static_cast<const bst_image_header *>(map);
+        if(!h->valid(sizeof(T), sizeof(node), _length)) {
+            unmap();
+            throw NoTreeLoadedException();
+        }
+
+        // le ricerche saltano da un livello all'altro: niente lettura anticipata
+        ::madvise(map, _length, MADV_RANDOM);
+
+        _nodes = reinterpret_cast<const node *>(static_cast<const char *>(map) + h->nodes_offset);
+        _count = h->count;
+        _root = _count == 0 ? nullptr : _nodes + h->root;
+    }
+
+    /**
+     * Costruttore di spostamento
+     *
+     * @param other immagine da spostare, resta vuota
+    */
+    mapped_binary_search_tree(mapped_binary_search_tree &&other)
+        : _map(other._map), _length(other._length), _nodes(other._nodes), _count(other._count), _root(other._root) {
+        other._map = nullptr;
+        other.unmap();
+    }
+
+    /**
+     * Assegnamento per spostamento
+     *
+     * @param other immagine da spostare, resta vuota
+     *
+     * @return reference a this
+    */
+    mapped_binary_search_tree &operator=(mapped_binary_search_tree &&other) {
+        if(this != &other) {
+            unmap();
+            _map = other._map;
+            _length = other._length;
+            _nodes = other._nodes;
+            _count = other._count;
+            _root = other._root;
+            other._map = nullptr;
+            other.unmap();
+        }
+        return *this;
+    }
+
+    /**
+     * Distruttore: rimuove la mappatura
+    */
+    ~mapped_binary_search_tree() {
+        unmap();
+    }
+
+    /**
+     * Scrive l'immagine di un albero. Il file viene scritto accanto a path
+     * e rinominato solo alla fine, quindi un'immagine esistente resta
+     * valida se la scrittura fallisce.
+     *
+     * @param tree albero da scrivere
+     * @param path percorso del file
+     *
+     * @throw NoTreeSavedException se il file non può essere scritto
+    */
+    static void save(const tree_type &tree, const char *path) {
+        std::uint64_t n = tree.size();
+        if(n > 0x7fffffffULL)
+            throw NoTreeSavedException();
+
+        bst_image_header h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, "BSTIMAGE", 8);
+        h.format = bst_image_header::version;
+        h.value_size = sizeof(T);
+        h.node_size = sizeof(node);
+        h.count = n;
+        h.root = 0;
+        h.nodes_offset = sizeof(bst_image_header);
+        h.file_size = h.nodes_offset + n * sizeof(node);
+        h.checksum = h.compute_checksum();
+
+        std::string tmp = std::string(path) + ".tmp";
+        int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0)
+            throw NoTreeSavedException();
+
+        void *map = MAP_FAILED;
+        if(::ftruncate(fd, (off_t)h.file_size) == 0)
+            map = ::mmap(nullptr, (std::size_t)h.file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(map == MAP_FAILED) {
+            ::close(fd);
+            std::remove(tmp.c_str());
+            throw NoTreeSavedException();
+        }
+
+        // il nodo k (da 1) ha i figli in 2k e 2k + 1: distanze k e k + 1
+        node *nodes = reinterpret_cast<node *>(static_cast<char *>(map) + h.nodes_offset);
+        std::uint64_t k = first(n);
+        for(typename tree_type::const_iterator i = tree.begin(), ie = tree.end(); i != ie; ++i, k = next(k, n)) {
+            node &dst = nodes[k - 1];
+            std::memcpy(&dst.value, &*i, sizeof(T));
+            dst.left = 2 * k <= n ? (std::int32_t)k : 0;
+            dst.right = 2 * k + 1 <= n ? (std::int32_t)(k + 1) : 0;
+        }
+        std::memcpy(map, &h, sizeof(h));
+
+        bool ok = ::munmap(map, (std::size_t)h.file_size) == 0 && ::fsync(fd) == 0;
+        ok = ::close(fd) == 0 && ok;
+        if(!ok || std::rename(tmp.c_str(), path) != 0) {
+            std::remove(tmp.c_str());
+            throw NoTreeSavedException();
+        }
+    }
+
+    /**
+     * Ritorna il numero di elementi nell'immagine
+     *
+     * @return numero di elementi
+    */
+    std::size_t size() const {
+        return (std::size_t)_count;
+    }
+
+    /**
+     * Determina se esiste un determinato elemento nell'immagine
+     *
+     * @param value valore da cercare
+     *
+     * @return true se esiste l'elemento, false altrimenti
+     *
+     * @throw NoTreeLoadedException se l'immagine è corrotta
+    */
+    bool contains(const T &value) const {
+        const node *n = _root;
+        const node *pred = nullptr;
+        while(n != nullptr) {
+            if(bst_equal(_conf, _eql, n->value, value))
+                return true;
+            bool left = bst_less(_conf, value, n->value);
+            if(!left)
+                pred = n;
+            n = child(n, left);
+        }
+        return equivalent_miss(pred, value) && find_equivalent(_root, value, nullptr, 0) != nullptr;
+    }
+
+    /**
+     * Iteratore costante dell'immagine, con uno stack degli antenati
+     *
+     * @brief Iteratore costante dell'immagine
+    */
+    class const_iterator{
+
+    private:
+        const node *_stack[max_height]; // antenati ancora da visitare
+        int _top; // numero di nodi nello stack
+        const mapped_binary_search_tree *_tree; // immagine visitata
+
+        friend class mapped_binary_search_tree;
+
+        explicit const_iterator(const mapped_binary_search_tree *tree) : _top(0), _tree(tree) {}
+
+        void push(const node *n) {
+            if(_top == max_height)
+                throw NoTreeLoadedException();
+            _stack[_top++] = n;
+        }
+
+        /**
+         * Impila n e tutti i suoi discendenti a sinistra
+        */
+        void push_left(const node *n) {
+            while(n != nullptr) {
+                push(n);
+                n = _tree->child(n, true);
+            }
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T                         value_type;
+        typedef ptrdiff_t                 difference_type;
+        typedef const T*                  pointer;
+        typedef const T&                  reference;
+
+        const_iterator() : _top(0), _tree(nullptr) {}
+
+        const_iterator(const const_iterator &other) : _top(other._top), _tree(other._tree) {
+            for(int i = 0; i < _top; ++i)
+                _stack[i] = other._stack[i];
+        }
+
+        const_iterator& operator=(const const_iterator &other) {
+            _top = other._top;
+            _tree = other._tree;
+            for(int i = 0; i < _top; ++i)
+                _stack[i] = other._stack[i];
+            return *this;
+        }
+
+        ~const_iterator() {}
+
+        /**
+         * Ritorna il dato riferito dall'iteratore (dereferenziamento)
+        */
+        reference operator*() const {
+            return _stack[_top - 1]->value;
+        }
+
+        /**
+         * Ritorna il puntatore al dato riferito dall'iteratore
+        */
+        pointer operator->() const {
+            return &(_stack[_top - 1]->value);
+        }
+
+        /**
+         * Operatore di iterazione post-incremento
+        */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * Operatore di iterazione pre-incremento
+        */
+        const_iterator& operator++() {
+            const node *n = _stack[--_top];
+            push_left(_tree->child(n, false));
+            return *this;
+        }
+
+        /**
+         * Uguaglianza
+        */
+        bool operator==(const const_iterator &other) const {
+            if(_top != other._top)
+                return false;
+            return _top == 0 || _stack[_top - 1] == other._stack[_top - 1];
+        }
+
+        /**
+         * Diversità
+        */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    };
+
+private:
+
+    /**
+     * Cerca value tra gli equivalenti del sottoalbero n, esplorando
+     * entrambi i figli di ogni equivalente, in O(log n + k) con k numero di
+     * equivalenti. Se path non è nullptr riceve lo stack dell'iteratore.
+     *
+     * @param depth profondità di n, limitata da max_height
+     *
+     * @throw NoTreeLoadedException se l'immagine è corrotta
+    */
+    const node *find_equivalent(const node *n, const T &value, const_iterator *path, int depth) const {
+        for(; n != nullptr; ++depth) {
+            if(depth >= max_height)
+                throw NoTreeLoadedException();
+            if(bst_less(_conf, value, n->value)) {
+                if(path != nullptr)
+                    path->push(n);
+                n = child(n, true);
+            }
+            else if(bst_less(_conf, n->value, value)) {
+                n = child(n, false);
+            }
+            else {
+                int top = path != nullptr ? path->_top : 0;
+                if(path != nullptr)
+                    path->push(n);
+                if(bst_equal(_conf, _eql, n->value, value))
+                    return n;
+
+                const node *l = find_equivalent(child(n, true), value, path, depth + 1);
+                if(l != nullptr)
+                    return l;
+                if(path != nullptr)
+                    path->_top = top;
+                n = child(n, false);
+            }
+        }
+        return nullptr;
+    }
+
+public:
+
+    /**
+     * Ritorna l'iteratore all'inizio della sequenza dati
+     *
+     * @return iteratore all'inizio della sequenza
+    */
+    const_iterator begin() const {
+        const_iterator it(this);
+        it.push_left(_root);
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore alla fine della sequenza dati
+     *
+     * @return iteratore alla fine della sequenza
+    */
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    /**
+     * Cerca un elemento. L'iteratore ritornato prosegue in ordine
+     * dall'elemento trovato.
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore all'elemento, end() se non presente
+    */
+    const_iterator find(const T &value) const {
+        const_iterator it(this);
+        const node *n = _root;
+        const node *pred = nullptr;
+
+        while(n != nullptr) {
+            if(bst_equal(_conf, _eql, n->value, value)) {
+                it.push(n);
+                return it;
+            }
+            bool left = bst_less(_conf, value, n->value);
+            if(left)
+                it.push(n);
+            else
+                pred = n;
+            n = child(n, left);
+        }
+
+        it._top = 0;
+        if(!equivalent_miss(pred, value) || find_equivalent(_root, value, &it, 0) == nullptr)
+            return const_iterator();
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento non minore di value
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore al primo elemento x con !(x < value)
+    */
+    const_iterator lower_bound(const T &value) const {
+        const_iterator it(this);
+        const node *n = _root;
+
+        while(n != nullptr) {
+            bool left = !bst_less(_conf, n->value, value);
+            if(left)
+                it.push(n);
+            n = child(n, left);
+        }
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento maggiore di value
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore al primo elemento x con value < x
+    */
+    const_iterator upper_bound(const T &value) const {
+        const_iterator it(this);
+        const node *n = _root;
+
+        while(n != nullptr) {
+            bool left = bst_less(_conf, value, n->value);
+            if(left)
+                it.push(n);
+            n = child(n, left);
+        }
+        return it;
+    }
+
+    /**
+     * Ritorna un albero modificabile con gli stessi valori, costruito in
+     * tempo lineare
+     *
+     * @return l'albero
+     *
+     * @throw eccezione di copiatura dell'albero
+    */
+    tree_type thaw() const {
+        return tree_type(sorted_unique_range, begin(), end());
+    }
+
+};
+
+/**
+ * Overload dell'operatore di stream << per un mapped_binary_search_tree
+ *
+ * @brief Operatore <<
+ *
+ * @return puntatore allo stream
+*/
+template <typename T, typename C, typename E, typename B, typename A, unsigned int F>
+std::ostream &operator<<(std::ostream &os, const mapped_binary_search_tree<T,C,E,B,A,F> &bstree) {
+
+    typename mapped_binary_search_tree<T,C,E,B,A,F>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i)
+        os << *i << " ";
+
+    return os;
+}
+
+/**
+ * Stampa a schermo l'elenco dei valori dell'immagine che soddisfano un
+ * predicato.
+ *
+ * @brief Stampa i valori dell'albero che soddisfano un predicato.
+ *
+ * @param bstree albero mappato
+ * @param pred predicato
+*/
+template <typename T, typename C, typename E, typename P, typename B, typename A, unsigned int F>
+void printIF(const mapped_binary_search_tree<T,C,E,B,A,F> &bstree, P pred) {
+
+    typename mapped_binary_search_tree<T,C,E,B,A,F>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i) {
+        if(pred(*i))
+            std::cout << *i << std::endl;
+    }
+
+}
+
+#endif
@@ -0,0 +1,825 @@
+#ifndef PERSISTENT_BSTREE_H
+#define PERSISTENT_BSTREE_H
+
+#include <ostream>
+#include <iostream>
+#include <iterator> // std::forward_iterator_tag
+#include <cstddef>  // std::ptrdiff_t, std::size_t
+#include <atomic>   // std::atomic
+#include "bstree.h" // eccezioni comuni
+
+/**
+ * Classe generica che implementa un albero binario di ricerca persistente.
+ * I nodi sono immutabili e condivisi tra le versioni tramite un contatore di
+ * riferimenti: copiare l'albero (snapshot) costa O(1) e una modifica copia
+ * solo gli O(log n) nodi del percorso che tocca, lasciando intatte le
+ * versioni precedenti. I nodi di una versione sono liberati quando l'ultima
+ * versione che li usa viene distrutta.
+ *
+ * Il contatore è atomico, quindi versioni diverse possono essere lette,
+ * modificate e distrutte da thread diversi. Lo stesso oggetto albero non può
+ * invece essere usato da più thread senza sincronizzazione esterna.
+ *
+ * L'albero è bilanciato con la politica AVL, così il percorso copiato ha
+ * sempre lunghezza logaritmica. Valori equivalenti per C ma diversi per E
+ * sono ammessi: se una ricerca arriva accanto a valori equivalenti, li
+ * scorre tutti prima di concludere che il valore manca.
+ *
+ * @brief Albero binario di ricerca persistente
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+*/
+template <typename T, typename C, typename E>
+class persistent_binary_search_tree {
+
+private:
+
+    /**
+     * Nodo immutabile condiviso tra le versioni
+     *
+     * @brief Nodo dell'albero
+    */
+    struct node {
+
+        T value; // valore del dato inserito
+        node *left; // figlio sinistro del nodo
+        node *right; // figlio destro del nodo
+        int height; // altezza del sottoalbero radicato nel nodo
+        std::size_t count; // numero di nodi del sottoalbero
+        std::atomic<unsigned int> refs; // riferimenti da padri e alberi
+
+        /**
+         * Costruttore che prende possesso dei riferimenti ai figli
+         *
+         * @param v valore del dato
+         * @param l figlio sinistro
+         * @param r figlio destro
+        */
+        node(const T &v, node *l, node *r): value(v), left(l), right(r), refs(1) {
+            update();
+        }
+
+        /**
+         * Ricalcola altezza e dimensione dai figli
+        */
+        void update() {
+            int hl = height_of(left);
+            int hr = height_of(right);
+            height = 1 + (hl > hr ? hl : hr);
+            count = 1 + count_of(left) + count_of(right);
+        }
+
+    };
+
+    /**
+     * Altezza massima dell'albero: un AVL con 2^64 nodi è alto meno di 96
+    */
+    enum { max_height = 96 };
+
+    node *_root; // radice della versione
+    std::size_t _size; // numero di nodi della versione
+
+    C _conf; // oggetto funtore per il confronto
+    E _eql; // oggetto funtore per l'uguaglianza
+
+    static int height_of(const node *n){
+        return n == nullptr ? 0 : n->height;
+    }
+
+    static std::size_t count_of(const node *n){
+        return n == nullptr ? 0 : n->count;
+    }
+
+    /**
+     * Aggiunge un riferimento al nodo
+    */
+    static node *retain(node *n){
+        if(n != nullptr)
+            n->refs.fetch_add(1, std::memory_order_relaxed);
+        return n;
+    }
+
+    /**
+     * Toglie un riferimento al nodo e lo distrugge quando non ne ha più,
+     * rilasciando a sua volta i figli
+    */
+    static void release(node *n){
+        while(n != nullptr && n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1){
+            node *l = n->left;
+            node *r = n->right;
+            delete n;
+            release(l);
+            n = r;
+        }
+    }
+
+    /**
+     * Riferimento a un nodo rilasciato all'uscita dal blocco, a meno che
+     * non venga ripreso con dismiss: se una copia del percorso fallisce a
+     * metà, i nodi già copiati vengono liberati
+    */
+    struct node_guard {
+        node *n;
+
+        explicit node_guard(node *x): n(x) {}
+
+        ~node_guard() {
+            release(n);
+        }
+
+        node *dismiss() {
+            node *x = n;
+            n = nullptr;
+            return x;
+        }
+
+    private:
+        node_guard(const node_guard &);
+        node_guard &operator=(const node_guard &);
+    };
+
+    /**
+     * Crea un nodo che prende possesso dei riferimenti ai figli.
+     * In caso di errore i riferimenti vengono rilasciati.
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    static node *make_node(const T &value, node *l, node *r){
+        try{
+            return new node(value, l, r);
+        }
+        catch(...){
+            release(l);
+            release(r);
+            throw NoNodeCreatedException();
+        }
+    }
+
+    /**
+     * Rende modificabile il nodo n posseduto dal chiamante: se è condiviso
+     * con altre versioni ne crea una copia e rilascia l'originale.
+     * Se la copia fallisce n resta invariato e posseduto dal chiamante.
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    static node *own(node *n){
+        if(n->refs.load(std::memory_order_acquire) == 1)
+            return n;
+
+        node *copy = make_node(n->value, retain(n->left), retain(n->right));
+        release(n);
+        return copy;
+    }
+
+    /**
+     * Rotazione a destra di un nodo posseduto dal chiamante.
+     * L'unica allocazione precede ogni modifica.
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    static node *rotate_right(node *x){
+        node *y = own(x->left);
+        x->left = y->right;
+        x->update();
+        y->right = x;
+        y->update();
+        return y;
+    }
+
+    /**
+     * Rotazione a sinistra di un nodo posseduto dal chiamante.
+     * L'unica allocazione precede ogni modifica.
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    static node *rotate_left(node *x){
+        node *y = own(x->right);
+        x->right = y->left;
+        x->update();
+        y->left = x;
+        y->update();
+        return y;
+    }
+
+    /**
+     * Ribilancia un nodo posseduto dal chiamante, copiando i nodi
+     * condivisi coinvolti nelle rotazioni. Ogni copia viene collegata
+     * subito al padre, quindi i contatori restano coerenti; se una copia
+     * fallisce n viene rilasciato insieme ai nodi già copiati.
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    static node *balance(node *n){
+        n->update();
+        int bal = height_of(n->left) - height_of(n->right);
+        if(bal >= -1 && bal <= 1)
+            return n;
+
+        node_guard guard(n);
+        if(bal > 1){
+            if(height_of(n->left->left) < height_of(n->left->right)){
+                n->left = own(n->left);
+                n->left = rotate_left(n->left);
+            }
+            n = rotate_right(n);
+        }
+        else{
+            if(height_of(n->right->right) < height_of(n->right->left)){
+                n->right = own(n->right);
+                n->right = rotate_right(n->right);
+            }
+            n = rotate_left(n);
+        }
+        guard.dismiss();
+        return n;
+    }
+
+    /**
+     * Inserisce il valore nel sottoalbero n copiando il percorso.
+     * I valori equivalenti vanno a destra di quelli presenti; prima di
+     * creare il nodo si controlla che nessun equivalente spostato dalle
+     * rotazioni sia uguale al valore.
+     *
+     * @param pred ultimo nodo lasciato a sinistra del percorso
+     *
+     * @return nuova radice del sottoalbero, nullptr se il valore è già presente
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    node *insert(node *n, const T &value, const node *pred) const {
+        if(n == nullptr){
+            if(equivalent_miss(pred, value) && find_equivalent(_root, value, nullptr) != nullptr)
+                return nullptr;
+            return make_node(value, nullptr, nullptr);
+        }
+
+        if(_eql(n->value, value))
+            return nullptr;
+
+        if(_conf(value, n->value)){
+            node *l = insert(n->left, value, pred);
+            if(l == nullptr)
+                return nullptr;
+            return balance(make_node(n->value, l, retain(n->right)));
+        }
+
+        node *r = insert(n->right, value, n);
+        if(r == nullptr)
+            return nullptr;
+        return balance(make_node(n->value, retain(n->left), r));
+    }
+
+    /**
+     * Toglie il minimo dal sottoalbero n copiando il percorso
+     *
+     * @param n sottoalbero non vuoto
+     * @param min nodo minimo (riferimento acquisito, solo in caso di successo)
+     *
+     * @return nuova radice del sottoalbero
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    static node *remove_min(node *n, node *&min){
+        if(n->left == nullptr){
+            min = retain(n);
+            return retain(n->right);
+        }
+        node *l = remove_min(n->left, min);
+        node_guard held(min);
+        node *r = balance(make_node(n->value, l, retain(n->right)));
+        held.dismiss();
+        return r;
+    }
+
+    /**
+     * Rimuove il valore dal sottoalbero n copiando il percorso.
+     *
+     * @param n sottoalbero
+     * @param value valore da rimuovere
+     * @param found true se il valore è stato trovato
+     * @param scan true per cercare il valore anche a sinistra dei nodi
+     *             equivalenti ma diversi
+     * @param pred ultimo nodo lasciato a sinistra del percorso
+     *
+     * @return nuova radice del sottoalbero (riferimento acquisito)
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    node *remove(node *n, const T &value, bool &found, bool scan, const node *&pred) const {
+        if(n == nullptr){
+            found = false;
+            return nullptr;
+        }
+
+        if(_eql(n->value, value)){
+            found = true;
+            if(n->left == nullptr)
+                return retain(n->right);
+            if(n->right == nullptr)
+                return retain(n->left);
+
+            node *min;
+            node *r = remove_min(n->right, min);
+            node_guard held(min);
+            return balance(make_node(min->value, retain(n->left), r));
+        }
+
+        if(_conf(value, n->value)){
+            node *l = remove(n->left, value, found, scan, pred);
+            if(!found)
+                return nullptr;
+            return balance(make_node(n->value, l, retain(n->right)));
+        }
+
+        if(scan && !_conf(n->value, value)){
+            node *l = remove(n->left, value, found, scan, pred);
+            if(found)
+                return balance(make_node(n->value, l, retain(n->right)));
+        }
+
+        pred = n;
+        node *r = remove(n->right, value, found, scan, pred);
+        if(!found)
+            return nullptr;
+        return balance(make_node(n->value, retain(n->left), r));
+    }
+
+    /**
+     * Cerca il nodo con il valore dato
+    */
+    node *find_node(const T &value) const {
+        node *curr = _root;
+        node *pred = nullptr;
+
+        while(curr != nullptr){
+            if(_eql(curr->value, value))
+                return curr;
+
+            if(_conf(value, curr->value)){
+                curr = curr->left;
+            }
+            else{
+                pred = curr;
+                curr = curr->right;
+            }
+        }
+
+        if(!equivalent_miss(pred, value))
+            return nullptr;
+        return const_cast<node *>(find_equivalent(_root, value, nullptr));
+    }
+
+    /**
+     * Indica se una discesa senza esito è passata per valori equivalenti a
+     * value. I valori equivalenti per C ma diversi per E vanno a destra di
+     * quelli presenti, ma le rotazioni AVL possono spostarli a sinistra del
+     * percorso; in ordine restano contigui e terminano in pred, l'ultimo
+     * nodo lasciato a sinistra.
+    */
+    bool equivalent_miss(const node *pred, const T &value) const {
+        return pred != nullptr && !_conf(pred->value, value);
+    }
+
+public:
+
+    /**
+     * Costruttore di default
+    */
+    persistent_binary_search_tree(): _root(nullptr), _size(0) {}
+
+    /**
+     * Costruttore di copia: crea uno snapshot in O(1) condividendo i nodi
+     *
+     * @param other albero da copiare
+    */
+    persistent_binary_search_tree(const persistent_binary_search_tree &other)
+        : _root(retain(other._root)), _size(other._size), _conf(other._conf), _eql(other._eql) {}
+
+    /**
+     * Operatore di assegnamento: condivide i nodi di other in O(1)
+     *
+     * @param other albero da copiare
+     *
+     * @return reference a this
+    */
+    persistent_binary_search_tree &operator=(const persistent_binary_search_tree &other) {
+        if(this != &other) {
+            node *old = _root;
+            _root = retain(other._root);
+            _size = other._size;
+            release(old);
+        }
+        return *this;
+    }
+
+    /**
+     * Distruttore: rilascia i nodi non più usati da altre versioni
+    */
+    ~persistent_binary_search_tree(){
+        clear();
+    }
+
+    /**
+     * Cancella il contenuto della versione
+    */
+    void clear(){
+        release(_root);
+        _root = nullptr;
+        _size = 0;
+    }
+
+    /**
+     * Ritorna uno snapshot della versione corrente in O(1)
+     *
+     * @return lo snapshot
+    */
+    persistent_binary_search_tree snapshot() const {
+        return persistent_binary_search_tree(*this);
+    }
+
+    /**
+     * Ritorna il numero di elementi nell'albero
+     *
+     * @return numero di elementi presenti nell'albero
+    */
+    std::size_t size() const {
+        return _size;
+    }
+
+    /**
+     * Determina se esiste un determinato elemento nell'albero.
+     *
+     * @param value valore da cercare
+     *
+     * @return true se esiste l'elemento, false altrimenti
+    */
+    bool contains(const T &value) const {
+        return find_node(value) != nullptr;
+    }
+
+    /**
+     * Inserisce un elemento copiando solo il percorso dalla radice al nuovo
+     * nodo. Le altre versioni non vedono la modifica.
+     *
+     * @param value valore da inserire
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    void add(const T &value){
+        node *r = insert(_root, value, nullptr);
+        if(r == nullptr)
+            return;
+
+        release(_root);
+        _root = r;
+        _size++;
+    }
+
+    /**
+     * Rimuove un elemento copiando solo il percorso dalla radice al nodo.
+     * Le altre versioni non vedono la modifica.
+     *
+     * @param value valore da rimuovere
+     *
+     * @return numero di elementi rimossi (0 o 1)
+     *
+     * @throw eccezione sulla creazione del nodo
+    */
+    std::size_t erase(const T &value){
+        bool found;
+        const node *pred = nullptr;
+        node *r = remove(_root, value, found, false, pred);
+        if(!found && equivalent_miss(pred, value))
+            r = remove(_root, value, found, true, pred);
+        if(!found)
+            return 0;
+
+        release(_root);
+        _root = r;
+        _size--;
+        return 1;
+    }
+
+    /**
+     * Restituisce il sottoalbero radicato nel nodo con il valore dato.
+     * Il sottoalbero condivide i nodi, quindi il costo è O(log n).
+     *
+     * @param value valore che sarà radice del sottoalbero
+     *
+     * @return il sottoalbero ricercato
+    */
+    persistent_binary_search_tree subtree(const T &value) const {
+        persistent_binary_search_tree tmp;
+        node *n = find_node(value);
+
+        tmp._root = retain(n);
+        tmp._size = count_of(n);
+        return tmp;
+    }
+
+    /**
+     * Iteratore costante dell'albero. Visita i nodi in ordine con uno stack
+     * di dimensione fissa, perché i nodi non hanno il puntatore al padre.
+     * Resta valido finché esiste la versione da cui è stato creato.
+     *
+     * @brief Iteratore costante dell'albero
+    */
+    class const_iterator{
+
+    private:
+        const node *_stack[max_height]; // antenati ancora da visitare
+        int _top; // numero di nodi nello stack
+
+        friend class persistent_binary_search_tree;
+
+        /**
+         * Impila n e tutti i suoi discendenti a sinistra
+        */
+        void push_left(const node *n){
+            while(n != nullptr){
+                _stack[_top++] = n;
+                n = n->left;
+            }
+        }
+
+        explicit const_iterator(const node *root) : _top(0) {
+            push_left(root);
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T                         value_type;
+        typedef ptrdiff_t                 difference_type;
+        typedef const T*                  pointer;
+        typedef const T&                  reference;
+
+        const_iterator() : _top(0) {}
+
+        const_iterator(const const_iterator &other) : _top(other._top) {
+            for(int i = 0; i < _top; ++i)
+                _stack[i] = other._stack[i];
+        }
+
+        const_iterator& operator=(const const_iterator &other) {
+            _top = other._top;
+            for(int i = 0; i < _top; ++i)
+                _stack[i] = other._stack[i];
+            return *this;
+        }
+
+        ~const_iterator() {}
+
+        /**
+         * Ritorna il dato riferito dall'iteratore (dereferenziamento)
+        */
+        reference operator*() const {
+            return _stack[_top - 1]->value;
+        }
+
+        /**
+         * Ritorna il puntatore al dato riferito dall'iteratore
+        */
+        pointer operator->() const {
+            return &(_stack[_top - 1]->value);
+        }
+
+        /**
+         * Operatore di iterazione post-incremento
+        */
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * Operatore di iterazione pre-incremento
+        */
+        const_iterator& operator++() {
+            const node *n = _stack[--_top];
+            push_left(n->right);
+            return *this;
+        }
+
+        /**
+         * Uguaglianza
+        */
+        bool operator==(const const_iterator &other) const {
+            if(_top != other._top)
+                return false;
+            return _top == 0 || _stack[_top - 1] == other._stack[_top - 1];
+        }
+
+        /**
+         * Diversità
+        */
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    };
+
+    /**
+     * Ritorna l'iteratore all'inizio della sequenza dati
+     *
+     * @return iteratore all'inizio della sequenza
+    */
+    const_iterator begin() const {
+        return const_iterator(_root);
+    }
+
+    /**
+     * Ritorna l'iteratore alla fine della sequenza dati
+     *
+     * @return iteratore alla fine della sequenza
+    */
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+private:
+
+    /**
+     * Cerca value visitando solo i nodi equivalenti e i percorsi che li
+     * raggiungono, da entrambe le parti di ogni nodo equivalente ma diverso.
+     * Costo O(log n + k) con k valori equivalenti.
+     *
+     * @param n radice del sottoalbero
+     * @param value valore cercato
+     * @param path se non nullo, riceve gli antenati da visitare dopo il nodo
+     *
+     * @return nodo uguale a value, nullptr se non presente
+    */
+    const node *find_equivalent(const node *n, const T &value, const_iterator *path) const {
+        while(n != nullptr){
+            if(_conf(value, n->value)){
+                if(path != nullptr)
+                    path->_stack[path->_top++] = n;
+                n = n->left;
+            }
+            else if(_conf(n->value, value)){
+                n = n->right;
+            }
+            else{
+                int depth = path != nullptr ? path->_top : 0;
+                if(path != nullptr)
+                    path->_stack[path->_top++] = n;
+                if(_eql(n->value, value))
+                    return n;
+
+                const node *l = find_equivalent(n->left, value, path);
+                if(l != nullptr)
+                    return l;
+                if(path != nullptr)
+                    path->_top = depth;
+                n = n->right;
+            }
+        }
+        return nullptr;
+    }
+
+public:
+
+    /**
+     * Cerca un elemento nella versione corrente in O(log n).
+     * L'iteratore ritornato prosegue in ordine dall'elemento trovato.
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore all'elemento, end() se non presente
+    */
+    const_iterator find(const T &value) const {
+        const_iterator it;
+        const node *curr = _root;
+        const node *pred = nullptr;
+
+        while(curr != nullptr){
+            if(_eql(curr->value, value)){
+                it._stack[it._top++] = curr;
+                return it;
+            }
+
+            if(_conf(value, curr->value)){
+                it._stack[it._top++] = curr;
+                curr = curr->left;
+            }
+            else{
+                pred = curr;
+                curr = curr->right;
+            }
+        }
+
+        it._top = 0;
+        if(!equivalent_miss(pred, value) || find_equivalent(_root, value, &it) == nullptr)
+            return const_iterator();
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento non minore di value
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore al primo elemento x con !(x < value)
+    */
+    const_iterator lower_bound(const T &value) const {
+        const_iterator it;
+        const node *curr = _root;
+
+        // lo stack contiene esattamente gli antenati in cui si è scesi a sinistra
+        while(curr != nullptr){
+            if(_conf(curr->value, value)){
+                curr = curr->right;
+            }
+            else{
+                it._stack[it._top++] = curr;
+                curr = curr->left;
+            }
+        }
+        return it;
+    }
+
+    /**
+     * Ritorna l'iteratore al primo elemento maggiore di value
+     *
+     * @param value valore da cercare
+     *
+     * @return iteratore al primo elemento x con value < x
+    */
+    const_iterator upper_bound(const T &value) const {
+        const_iterator it;
+        const node *curr = _root;
+
+        while(curr != nullptr){
+            if(_conf(value, curr->value)){
+                it._stack[it._top++] = curr;
+                curr = curr->left;
+            }
+            else{
+                curr = curr->right;
+            }
+        }
+        return it;
+    }
+
+    /**
+     * Ritorna l'altezza dell'albero
+     *
+     * @return altezza dell'albero (0 se vuoto)
+    */
+    unsigned int height() const {
+        return height_of(_root);
+    }
+
+};
+
+/**
+ * Overload dell'operatore di stream << per un persistent_binary_search_tree
+ *
+ * @brief Operatore <<
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ *
+ * @return puntatore allo stream
+*/
+template <typename T, typename C, typename E>
+std::ostream &operator<<(std::ostream &os, const persistent_binary_search_tree<T,C,E> &bstree) {
+
+    typename persistent_binary_search_tree<T,C,E>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i)
+        os << *i << " ";
+
+    return os;
+}
+
+/**
+ * Stampa a schermo l'elenco dei valori dell'albero persistente che
+ * soddisfano un predicato.
+ *
+ * @brief Stampa i valori dell'albero che soddisfano un predicato.
+ *
+ * @param T tipo del dato
+ * @param C funtore di comparazione
+ * @param E funtore di uguaglianza
+ * @param P funtore del predicato
+ * @param bstree albero di tipo T
+ * @param pred predicato
+*/
+template <typename T, typename C, typename E, typename P>
+void printIF(const persistent_binary_search_tree<T,C,E> &bstree, P pred) {
+
+    typename persistent_binary_search_tree<T,C,E>::const_iterator i,ie;
+
+    for(i = bstree.begin(), ie = bstree.end(); i != ie; ++i) {
+        if(pred(*i))
+            std::cout << *i << std::endl;
+    }
+
+}
+
+#endif
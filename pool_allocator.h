@@ -0,0 +1,478 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <cstddef>  // std::size_t, std::max_align_t
+#include <cstdlib>  // posix_memalign, std::free
+#include <new>      // ::operator new, std::bad_alloc
+#include <memory>   // std::shared_ptr
+#include <type_traits> // std::true_type, std::false_type
+
+/**
+ * Alloca size byte allineati ad align. Fino a alignof(std::max_align_t)
+ * basta ::operator new; oltre, che in C++11 ::operator new non garantisce,
+ * la memoria viene da posix_memalign.
+ *
+ * @param size numero di byte
+ * @param align allineamento, potenza di due
+ *
+ * @throw std::bad_alloc
+*/
+inline void *aligned_allocate(std::size_t size, std::size_t align) {
+    if(align <= alignof(std::max_align_t))
+        return ::operator new(size);
+
+    void *p = nullptr;
+    if(::posix_memalign(&p, align < sizeof(void *) ? sizeof(void *) : align, size) != 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+/**
+ * Libera la memoria ottenuta con aligned_allocate con lo stesso align
+*/
+inline void aligned_deallocate(void *p, std::size_t align) {
+    if(align <= alignof(std::max_align_t))
+        ::operator delete(p);
+    else
+        std::free(p);
+}
+
+/**
+ * Allocatore compatibile con std::allocator che rispetta l'allineamento di
+ * T anche quando supera quello di std::max_align_t, come i nodi allineati
+ * alle linee di cache. Non ha stato: tutte le istanze sono uguali.
+ *
+ * @brief Allocatore con allineamento esteso
+ *
+ * @param T tipo degli oggetti allocati
+*/
+template <typename T>
+class aligned_allocator {
+
+public:
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_pointer;
+    typedef T&          reference;
+    typedef const T&    const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    typedef std::true_type is_always_equal;
+
+    template <typename U>
+    struct rebind {
+        typedef aligned_allocator<U> other;
+    };
+
+    aligned_allocator() {}
+
+    /**
+     * Costruttore di conversione da un altro allocatore senza stato
+    */
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U> &) {}
+
+    template <typename U>
+    aligned_allocator(const std::allocator<U> &) {}
+
+    /**
+     * Alloca n oggetti contigui allineati ad alignof(T)
+     *
+     * @throw std::bad_alloc
+    */
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(aligned_allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Libera n oggetti contigui allocati con allocate
+    */
+    void deallocate(T *p, std::size_t) {
+        aligned_deallocate(p, alignof(T));
+    }
+
+};
+
+template <typename T, typename U>
+bool operator==(const aligned_allocator<T> &, const aligned_allocator<U> &) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const aligned_allocator<T> &, const aligned_allocator<U> &) {
+    return false;
+}
+
+/**
+ * Arena di oggetti di dimensione fissa.
+ * Gli oggetti sono ricavati da blocchi contigui di memoria; quelli liberati
+ * sono riusati tramite una free list e l'intera arena può essere rilasciata
+ * con un costo proporzionale al numero di blocchi.
+ *
+ * @brief Arena di oggetti di dimensione fissa
+*/
+class node_pool {
+
+private:
+
+    /**
+     * Intestazione di un blocco, seguita dagli oggetti
+    */
+    struct block {
+        block *next; // blocco allocato in precedenza
+    };
+
+    /**
+     * Elemento della free list, sovrapposto a un oggetto liberato
+    */
+    struct free_chunk {
+        free_chunk *next; // prossimo oggetto libero
+    };
+
+    std::size_t _chunk; // dimensione di un oggetto (con allineamento)
+    std::size_t _align; // allineamento degli oggetti
+    std::size_t _per_block; // numero di oggetti per blocco
+    std::size_t _blocks; // numero di blocchi allocati
+
+    block *_head; // ultimo blocco allocato
+    free_chunk *_free; // oggetti liberati riusabili
+    char *_cursor; // prossimo oggetto mai usato del blocco corrente
+    char *_limit; // fine del blocco corrente
+
+    node_pool(const node_pool &);
+    node_pool &operator=(const node_pool &);
+
+    static std::size_t round_up(std::size_t n, std::size_t a) {
+        return (n + a - 1) / a * a;
+    }
+
+    std::size_t header_size() const {
+        return round_up(sizeof(block), _align > alignof(std::max_align_t) ? _align : alignof(std::max_align_t));
+    }
+
+    /**
+     * Alloca un nuovo blocco e lo rende blocco corrente
+     *
+     * @throw std::bad_alloc
+    */
+    void grow() {
+        block *b = static_cast<block *>(aligned_allocate(header_size() + _chunk * _per_block, _align));
+        b->next = _head;
+        _head = b;
+        _blocks++;
+
+        _cursor = reinterpret_cast<char *>(b) + header_size();
+        _limit = _cursor + _chunk * _per_block;
+    }
+
+public:
+
+    /**
+     * Costruttore
+     *
+     * @param size dimensione degli oggetti
+     * @param align allineamento degli oggetti
+     * @param per_block numero di oggetti per blocco
+    */
+    node_pool(std::size_t size, std::size_t align, std::size_t per_block)
+        : _per_block(per_block == 0 ? 1 : per_block), _blocks(0),
+          _head(nullptr), _free(nullptr), _cursor(nullptr), _limit(nullptr) {
+        if(align < alignof(free_chunk))
+            align = alignof(free_chunk);
+        if(size < sizeof(free_chunk))
+            size = sizeof(free_chunk);
+        _chunk = round_up(size, align);
+        _align = align;
+    }
+
+    /**
+     * Distruttore: rilascia tutti i blocchi
+    */
+    ~node_pool() {
+        release();
+    }
+
+    /**
+     * Ritorna lo spazio per un oggetto, riusando prima quelli liberati
+     *
+     * @throw std::bad_alloc
+    */
+    void *allocate() {
+        if(_free != nullptr) {
+            free_chunk *c = _free;
+            _free = c->next;
+            return c;
+        }
+
+        if(_cursor == _limit)
+            grow();
+
+        void *p = _cursor;
+        _cursor += _chunk;
+        return p;
+    }
+
+    /**
+     * Restituisce un oggetto all'arena inserendolo nella free list
+    */
+    void deallocate(void *p) {
+        free_chunk *c = static_cast<free_chunk *>(p);
+        c->next = _free;
+        _free = c;
+    }
+
+    /**
+     * Rilascia in blocco tutta la memoria dell'arena.
+     * Gli oggetti ancora vivi non vengono distrutti.
+    */
+    void release() {
+        while(_head != nullptr) {
+            block *b = _head;
+            _head = b->next;
+            aligned_deallocate(b, _align);
+        }
+        _blocks = 0;
+        _free = nullptr;
+        _cursor = nullptr;
+        _limit = nullptr;
+    }
+
+    /**
+     * Ritorna il numero di blocchi allocati
+    */
+    std::size_t blocks() const {
+        return _blocks;
+    }
+
+    /**
+     * Ritorna la dimensione di un oggetto dell'arena
+    */
+    std::size_t chunk_size() const {
+        return _chunk;
+    }
+
+};
+
+/**
+ * Insieme di arene condiviso da un allocatore e dalle sue rebind.
+ * Contiene un'arena per ogni dimensione di oggetto richiesta.
+ *
+ * @brief Insieme di arene
+*/
+class pool_set {
+
+private:
+
+    /**
+     * Arena della lista
+    */
+    struct entry {
+        node_pool pool; // arena
+        std::size_t size; // dimensione richiesta
+        std::size_t align; // allineamento richiesto
+        entry *next; // arena successiva
+
+        entry(std::size_t s, std::size_t a, std::size_t n, entry *nx)
+            : pool(s, a, n), size(s), align(a), next(nx) {}
+    };
+
+    entry *_head; // lista delle arene
+
+    pool_set(const pool_set &);
+    pool_set &operator=(const pool_set &);
+
+public:
+
+    pool_set() : _head(nullptr) {}
+
+    ~pool_set() {
+        while(_head != nullptr) {
+            entry *e = _head;
+            _head = e->next;
+            delete e;
+        }
+    }
+
+    /**
+     * Ritorna l'arena per oggetti della dimensione indicata, creandola se serve
+     *
+     * @throw std::bad_alloc
+    */
+    node_pool *get(std::size_t size, std::size_t align, std::size_t per_block) {
+        for(entry *e = _head; e != nullptr; e = e->next) {
+            if(e->size == size && e->align == align)
+                return &e->pool;
+        }
+        _head = new entry(size, align, per_block, _head);
+        return &_head->pool;
+    }
+
+    /**
+     * Rilascia in blocco la memoria di tutte le arene
+    */
+    void release() {
+        for(entry *e = _head; e != nullptr; e = e->next)
+            e->pool.release();
+    }
+
+    /**
+     * Ritorna il numero totale di blocchi allocati
+    */
+    std::size_t blocks() const {
+        std::size_t n = 0;
+        for(entry *e = _head; e != nullptr; e = e->next)
+            n += e->pool.blocks();
+        return n;
+    }
+
+};
+
+/**
+ * Allocatore compatibile con std::allocator che ricava gli oggetti da un
+ * node_pool. Le copie e le rebind di un allocatore condividono lo stesso
+ * pool_set, quindi sono uguali tra loro e possono liberare l'una la memoria
+ * dell'altra. Le allocazioni di più oggetti contigui sono delegate
+ * a aligned_allocate, che rispetta anche gli allineamenti estesi.
+ *
+ * @brief Allocatore a pool di nodi
+ *
+ * @param T tipo degli oggetti allocati
+ * @param N numero di oggetti per blocco
+*/
+template <typename T, std::size_t N = 1024>
+class pool_allocator {
+
+private:
+    std::shared_ptr<pool_set> _set; // arene condivise tra le copie
+    node_pool *_pool; // arena per oggetti di tipo T
+
+    template <typename U, std::size_t M> friend class pool_allocator;
+
+public:
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_pointer;
+    typedef T&          reference;
+    typedef const T&    const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::true_type  propagate_on_container_move_assignment;
+    typedef std::true_type  propagate_on_container_swap;
+
+    template <typename U>
+    struct rebind {
+        typedef pool_allocator<U, N> other;
+    };
+
+    /**
+     * Costruttore di default: crea un insieme di arene nuovo
+     *
+     * @throw std::bad_alloc
+    */
+    pool_allocator() : _set(new pool_set()), _pool(_set->get(sizeof(T), alignof(T), N)) {}
+
+    /**
+     * Costruttore di copia: condivide le arene
+    */
+    pool_allocator(const pool_allocator &other) : _set(other._set), _pool(other._pool) {}
+
+    /**
+     * Costruttore di conversione da un allocatore di un altro tipo:
+     * condivide le arene e usa quella della dimensione di T
+     *
+     * @throw std::bad_alloc
+    */
+    template <typename U>
+    pool_allocator(const pool_allocator<U, N> &other)
+        : _set(other._set), _pool(_set->get(sizeof(T), alignof(T), N)) {}
+
+    pool_allocator &operator=(const pool_allocator &other) {
+        _set = other._set;
+        _pool = other._pool;
+        return *this;
+    }
+
+    /**
+     * Un contenitore copiato riceve un'arena propria
+    */
+    pool_allocator select_on_container_copy_construction() const {
+        return pool_allocator();
+    }
+
+    /**
+     * Alloca n oggetti contigui
+     *
+     * @throw std::bad_alloc
+    */
+    T *allocate(std::size_t n) {
+        if(n == 1)
+            return static_cast<T *>(_pool->allocate());
+        return static_cast<T *>(aligned_allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Libera n oggetti contigui allocati con allocate
+    */
+    void deallocate(T *p, std::size_t n) {
+        if(n == 1)
+            _pool->deallocate(p);
+        else
+            aligned_deallocate(p, alignof(T));
+    }
+
+    /**
+     * Rilascia in blocco le arene, se non sono condivise con altri allocatori.
+     * Gli oggetti allocati non vengono distrutti.
+     *
+     * @return true se l'arena è stata rilasciata
+    */
+    bool release() {
+        if(_set.use_count() != 1)
+            return false;
+        _set->release();
+        return true;
+    }
+
+    /**
+     * Ritorna il numero di blocchi allocati dalle arene
+    */
+    std::size_t blocks() const {
+        return _set->blocks();
+    }
+
+    template <typename U>
+    bool operator==(const pool_allocator<U, N> &other) const {
+        return _set == other._set;
+    }
+
+    template <typename U>
+    bool operator!=(const pool_allocator<U, N> &other) const {
+        return _set != other._set;
+    }
+
+};
+
+/**
+ * Rilascio in blocco per un allocatore generico: non disponibile
+ *
+ * @return false
+*/
+template <typename A>
+bool release_arena(A &) {
+    return false;
+}
+
+/**
+ * Rilascio in blocco per un pool_allocator
+ *
+ * @return true se l'arena è stata rilasciata
+*/
+template <typename T, std::size_t N>
+bool release_arena(pool_allocator<T, N> &alloc) {
+    return alloc.release();
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef TEST_TYPES_H
+#define TEST_TYPES_H
+
+#include <string> // std::string
+#include <type_traits> // std::true_type
+#include "frozen_bstree.h" // bst_natural_order
+
+/**
+ * Tipi di dato e funtori usati sia dai test (main.cpp) sia dal benchmark
+ * (bench.cpp).
+*/
+
+/**
+ * Struct point che implementa un punto 2D.
+ * 
+ * @brief Struct point che implementa un punto 2D.
+*/
+struct point {
+    int x; ///< coordinata x del punto
+    int y; ///< coordinata y del punto
+
+    point(int xx, int yy) : x(xx), y(yy) {}
+};
+
+/**
+ * Funtore per l'uguaglianza tra interi.
+ * 
+ * @brief Funtore per l'uguaglianza tra interi.
+*/
+struct equal_int {
+	bool operator()(const int a, const int b) const {
+		return (a==b);
+	} 
+};
+
+/**
+ * Funtore per il confronto tra interi.
+ * 
+ * @brief Funtore per il confronto tra interi.
+*/
+struct compare_int {
+	bool operator()(const int a, const int b) const {
+		return (a < b);
+	} 
+};
+
+/**
+ * compare_int coincide con l'operatore <: l'albero congelato può
+ * confrontare più chiavi insieme.
+*/
+template <>
+struct bst_natural_order<compare_int> : std::true_type {};
+
+/**
+ * Funtore per l'uguaglianza tra stringhe.
+ * 
+ * @brief Funtore per l'uguaglianza tra stringhe.
+*/
+struct equal_string {
+	bool operator()(const std::string &a, const std::string &b) const {
+		return (a==b);
+	} 
+};
+
+/**
+ * Funtore per il confronto tra stringhe.
+ * La valutazione è fatta sulla lunghezza.
+ * Ritorna true se la prima stringa è più corta della seconda.
+ * 
+ * @brief Funtore per il confronto tra stringhe.
+*/
+struct compare_string {
+	bool operator()(const std::string &a, const std::string &b) const {
+		return (a.size()<b.size());
+	} 
+};
+
+/**
+ * Funtore per il confronto di uguaglianza tra due punti.
+ * Ritorna true se p1.x != p2.x.
+ * 
+ * @brief Funtore per il confronto di due punti.
+*/
+struct equal_point {
+    bool operator()(const point &p1, const point &p2) const {
+        return (p1.x==p2.x) && (p1.y==p2.y);
+    } 
+};
+
+/**
+ * Funtore per il confronto di due punti. 
+ * Ritorna true se p1.x < p2.x.
+ * 
+ * @brief Funtore per il confronto di due punti.
+*/
+struct compare_point {
+    bool operator()(const point &p1, const point &p2) const {
+        return (p1.x<p2.x);
+    } 
+};
+
+/**
+ * Funtore trasparente per il confronto lessicografico tra stringhe,
+ * anche con stringhe C.
+ * 
+ * @brief Funtore trasparente per il confronto tra stringhe.
+*/
+struct compare_string_key {
+	typedef void is_transparent;
+
+	bool operator()(const std::string &a, const std::string &b) const {
+		return a < b;
+	}
+	bool operator()(const std::string &a, const char *b) const {
+		return a.compare(b) < 0;
+	}
+	bool operator()(const char *a, const std::string &b) const {
+		return b.compare(a) > 0;
+	}
+};
+
+/**
+ * Funtore trasparente per l'uguaglianza tra stringhe, anche con stringhe C.
+ * 
+ * @brief Funtore trasparente per l'uguaglianza tra stringhe.
+*/
+struct equal_string_key {
+	typedef void is_transparent;
+
+	bool operator()(const std::string &a, const std::string &b) const {
+		return a == b;
+	}
+	bool operator()(const std::string &a, const char *b) const {
+		return a.compare(b) == 0;
+	}
+};
+
+#endif